@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "batch.h"
+#include "misc.h"
+
+#define BATCH_WINDOW 4096
+#define BATCH_LINE 512
+
+// One input position and, once a worker is done, its result
+typedef struct {
+    char line[BATCH_LINE];
+    int valid;
+    Move best_move;
+    int score;
+    int depth;
+    uint64_t nodes;
+    int done;
+} BatchJob;
+
+// Per-worker engine instance
+typedef struct {
+    SearchThread search;
+    TranspositionTable tt;
+    uint64_t positions;
+    int64_t busy_ns;
+    SearchStats stats;        // summed over this worker's jobs, merged once at the end
+    struct BatchQueue *queue;
+    pthread_t handle;
+} BatchWorker;
+
+// Ring of jobs shared between the reader/writer (main thread) and the workers
+typedef struct BatchQueue {
+    BatchJob *jobs;
+    uint64_t produced;        // jobs filled by the reader
+    uint64_t taken;           // jobs claimed by workers
+    int eof;
+    SearchLimits limits;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t job_done;
+} BatchQueue;
+
+// Function to search one job on a worker's private engine
+static void process_job(BatchWorker *w, BatchJob *job) {
+    Position pos;
+
+    job->valid = position_set_fen(&pos, job->line);
+    if (!job->valid) return;
+
+    // Start every position from an empty table, so its result does not depend on
+    // which worker took it or what that worker searched before
+    tt_clear(&w->tt);
+    job->best_move = search_position(&w->search, &pos, &w->queue->limits);
+    job->score = w->search.best_score;
+    job->depth = w->search.completed_depth;
+    job->nodes = w->search.stats.nodes;
+
+    SearchStats stats;
+    search_total_stats(&w->search, &stats);
+    stats_add(&w->stats, &stats);
+}
+
+// Function to run one worker: claim the next job, search it, publish the result
+static void *worker_main(void *arg) {
+    BatchWorker *w = arg;
+    BatchQueue *q = w->queue;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->taken == q->produced && !q->eof) pthread_cond_wait(&q->work_ready, &q->lock);
+        if (q->taken == q->produced) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        BatchJob *job = &q->jobs[q->taken++ % BATCH_WINDOW];
+        pthread_mutex_unlock(&q->lock);
+
+        int64_t start = now_ns();
+        process_job(w, job);
+        w->busy_ns += now_ns() - start;
+        w->positions++;
+
+        pthread_mutex_lock(&q->lock);
+        job->done = 1;
+        pthread_cond_signal(&q->job_done);
+        pthread_mutex_unlock(&q->lock);
+    }
+    return NULL;
+}
+
+// Function to read the next non-empty, non-comment line; returns 0 at end of file
+static int read_position_line(FILE *in, char *buf) {
+    while (fgets(buf, BATCH_LINE, in)) {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        char *p = buf;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p && *p != '#') {
+            memmove(buf, p, strlen(p) + 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to write one finished job as a tab-separated result line
+static void write_result(FILE *out, const BatchJob *job) {
+    char text[6];
+
+    if (!job->valid) {
+        fprintf(out, "%s\terror\tinvalid-fen\t0\t0\n", job->line);
+        return;
+    }
+    move_to_uci(job->best_move, text);
+    fprintf(out, "%s\t%s\t%d\t%d\t%" PRIu64 "\n", job->line, text, job->score, job->depth, job->nodes);
+}
+
+// Function to search every FEN/EPD line of a file on a worker pool and write
+// results in input order; returns the process exit code
+int run_batch(const char *in_path, const char *out_path, const SearchLimits *limits,
+              int workers, size_t hash_mb, FILE *stats_json) {
+    FILE *in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "r");
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    BatchQueue q;
+    BatchWorker *pool;
+    uint64_t written = 0, nodes = 0, invalid = 0;
+    size_t worker_mb;
+
+    if (!in || !out) {
+        fprintf(stderr, "Could not open %s\n", !in ? in_path : out_path);
+        return 1;
+    }
+    if (workers < 1) workers = 1;
+    worker_mb = hash_mb / (size_t)workers ? hash_mb / (size_t)workers : 1;
+
+    memset(&q, 0, sizeof(q));
+    q.limits = *limits;
+    q.jobs = calloc(BATCH_WINDOW, sizeof(BatchJob));
+    pool = calloc((size_t)workers, sizeof(BatchWorker));
+    if (!q.jobs || !pool) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.work_ready, NULL);
+    pthread_cond_init(&q.job_done, NULL);
+
+    int64_t start = now_ns();
+    int started = 0;
+    while (started < workers) {
+        BatchWorker *w = &pool[started];
+        if (!tt_init(&w->tt, worker_mb)) break;
+        w->search.tt = &w->tt;
+        w->queue = &q;
+        if (pthread_create(&w->handle, NULL, worker_main, w) != 0) {
+            tt_free(&w->tt);
+            break;
+        }
+        started++;
+    }
+    if (started < workers) {
+        // Release the workers that did start before giving up
+        fprintf(stderr, "Could not start worker %d\n", started);
+        pthread_mutex_lock(&q.lock);
+        q.eof = 1;
+        pthread_cond_broadcast(&q.work_ready);
+        pthread_mutex_unlock(&q.lock);
+        for (int i = 0; i < started; i++) {
+            pthread_join(pool[i].handle, NULL);
+            tt_free(&pool[i].tt);
+        }
+        free(pool);
+        free(q.jobs);
+        return 1;
+    }
+
+    for (;;) {
+        // Keep the window full so every worker has something queued
+        while (!q.eof && q.produced - written < BATCH_WINDOW) {
+            BatchJob *job = &q.jobs[q.produced % BATCH_WINDOW];
+            int got = read_position_line(in, job->line);
+            pthread_mutex_lock(&q.lock);
+            if (got) {
+                job->done = 0;
+                q.produced++;
+                pthread_cond_signal(&q.work_ready);
+            } else {
+                q.eof = 1;
+                pthread_cond_broadcast(&q.work_ready);
+            }
+            pthread_mutex_unlock(&q.lock);
+        }
+
+        // Results leave strictly in input order
+        pthread_mutex_lock(&q.lock);
+        while (written < q.produced && !q.jobs[written % BATCH_WINDOW].done) {
+            pthread_cond_wait(&q.job_done, &q.lock);
+        }
+        pthread_mutex_unlock(&q.lock);
+        if (written == q.produced) break;
+
+        BatchJob *job = &q.jobs[written % BATCH_WINDOW];
+        write_result(out, job);
+        nodes += job->nodes;
+        invalid += !job->valid;
+        written++;
+    }
+
+    for (int i = 0; i < workers; i++) pthread_join(pool[i].handle, NULL);
+    double seconds = (now_ns() - start) / 1e9;
+    fflush(out);
+
+    // The report goes to stderr so stdout stays a clean result stream
+    fprintf(stderr, "Positions: %" PRIu64 " (%" PRIu64 " invalid)\n", written, invalid);
+    fprintf(stderr, "Time: %.3f s\n", seconds);
+    fprintf(stderr, "Positions/sec: %.1f\n", seconds > 0 ? written / seconds : 0.0);
+    fprintf(stderr, "Nodes: %" PRIu64 " (%.0f nps)\n", nodes, seconds > 0 ? nodes / seconds : 0.0);
+    for (int i = 0; i < workers; i++) {
+        double busy = pool[i].busy_ns / 1e9;
+        fprintf(stderr, "Worker %d: %" PRIu64 " positions, %.1f positions/sec busy, %.0f%% utilization\n", i,
+                pool[i].positions, busy > 0 ? pool[i].positions / busy : 0.0,
+                seconds > 0 ? 100.0 * busy / seconds : 0.0);
+        tt_free(&pool[i].tt);
+    }
+    if (stats_json) {
+        SearchStats total;
+        memset(&total, 0, sizeof(total));
+        for (int i = 0; i < workers; i++) stats_add(&total, &pool[i].stats);
+        stats_write_json(stats_json, "batch", &total, (int64_t)(seconds * 1000), NULL);
+    }
+    fprintf(stderr, "Scaling: %.2fx of one worker's busy rate with %d workers\n",
+            pool[0].busy_ns > 0 && seconds > 0 && pool[0].positions
+                ? (written / seconds) / (pool[0].positions / (pool[0].busy_ns / 1e9)) : 0.0, workers);
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    free(pool);
+    free(q.jobs);
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "search.h"
+
+// Function to search every FEN/EPD line of a file on a worker pool and write
+// results in input order; returns the process exit code
+int run_batch(const char *in_path, const char *out_path, const SearchLimits *limits,
+              int workers, size_t hash_mb, FILE *stats_json);
+
+#endif
@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include "bench.h"
+#include "smp.h"
+#include "misc.h"
+#include "eval.h"
+#include "nnue.h"
+
+// Fixed middlegame and endgame positions used by the benchmarks
+const char *bench_fens[] = {
+    START_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "8/8/8/5k2/8/3K4/4P3/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+const int bench_fen_count = sizeof(bench_fens) / sizeof(bench_fens[0]);
+
+// Function to measure time-to-depth over the bench positions with 1, 2, 4 ... max_threads
+int run_smp_bench(int max_threads, int depth, size_t hash_mb) {
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth};
+    int64_t base_time = 0;
+
+    if (!tt_init(&tt, hash_mb)) return 1;
+    printf("Time to depth %d over %d positions\n", depth, bench_fen_count);
+    printf("%8s %10s %14s %12s %8s\n", "threads", "time ms", "nodes", "nps", "speedup");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        SearchPool pool;
+        uint64_t nodes = 0;
+        int64_t elapsed = 0;
+
+        if (!pool_init(&pool, threads, &tt)) return 1;
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            tt_clear(&tt);
+
+            int64_t start = now_ms();
+            pool_search(&pool, &pos, &limits);
+            elapsed += now_ms() - start;
+            nodes += search_total_nodes(&pool.threads[0]);
+        }
+        pool_free(&pool);
+
+        if (threads == 1) base_time = elapsed;
+        printf("%8d %10" PRId64 " %14" PRIu64 " %12" PRIu64 " %8.2f\n", threads, elapsed, nodes,
+               elapsed > 0 ? nodes * 1000 / (uint64_t)elapsed : nodes,
+               elapsed > 0 ? (double)base_time / elapsed : 0.0);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+
+    tt_free(&tt);
+    return 0;
+}
+
+// Function to walk the legal move tree, optionally evaluating every leaf
+static uint64_t eval_walk(Position *pos, int depth, int evaluate_leaves, int64_t *checksum) {
+    MoveList list;
+    uint64_t leaves = 0;
+
+    if (depth == 0) {
+        if (evaluate_leaves) *checksum += evaluate(pos, NULL);
+        return 1;
+    }
+    generate_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        make_move(pos, list.moves[i]);
+        leaves += eval_walk(pos, depth - 1, evaluate_leaves, checksum);
+        unmake_move(pos, list.moves[i]);
+    }
+    return leaves;
+}
+
+// Function to compare tree walks with and without leaf evaluation over the bench positions
+int run_eval_bench(int depth) {
+    int64_t elapsed[2] = {0, 0};
+    uint64_t leaves = 0;
+    int64_t checksum = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            int64_t start = now_ns();
+            uint64_t n = eval_walk(&pos, depth, pass, &checksum);
+            elapsed[pass] += now_ns() - start;
+            if (pass) leaves += n;
+        }
+    }
+
+    double eval_ns = (double)(elapsed[1] - elapsed[0]) / (leaves ? leaves : 1);
+    printf("Leaves: %" PRIu64 " (eval checksum %" PRId64 ")\n", leaves, checksum);
+    printf("Walk without eval: %.0f leaves/s\n", leaves * 1e9 / (elapsed[0] ? elapsed[0] : 1));
+    printf("Walk with eval:    %.0f leaves/s\n", leaves * 1e9 / (elapsed[1] ? elapsed[1] : 1));
+    printf("Eval cost: %.1f ns per call, %.1f%% of the walk\n", eval_ns > 0 ? eval_ns : 0.0,
+           elapsed[1] > 0 ? 100.0 * (elapsed[1] - elapsed[0]) / elapsed[1] : 0.0);
+    return 0;
+}
+
+// Function to compare search trees with and without move ordering over the bench positions
+int run_order_bench(int depth, size_t hash_mb) {
+    static SearchThread st;
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth};
+    const char *names[2] = {"generation", "staged"};
+
+    if (depth < 2) depth = 2;
+    if (!tt_init(&tt, hash_mb)) return 1;
+    st.tt = &tt;
+    printf("Fixed depth %d over %d positions\n", depth, bench_fen_count);
+    printf("%-11s %14s %9s %10s %14s %12s %8s\n", "order", "nodes", "qnodes %", "time ms", "first-move %",
+           "moves/node", "EBF");
+
+    for (int plain = 1; plain >= 0; plain--) {
+        SearchStats total = {0};
+        uint64_t last = 0, previous = 0;
+        int64_t elapsed = 0;
+
+        st.plain_order = plain;
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            tt_clear(&tt);
+
+            int64_t start = now_ms();
+            search_position(&st, &pos, &limits);
+            elapsed += now_ms() - start;
+
+            stats_add(&total, &st.stats);
+
+            // Effective branching factor: growth of the tree from one iteration to the next
+            int d = st.completed_depth;
+            if (d >= 2) {
+                last += st.iteration_nodes[d] - st.iteration_nodes[d - 1];
+                previous += st.iteration_nodes[d - 1] - (d >= 3 ? st.iteration_nodes[d - 2] : 0);
+            }
+        }
+
+        printf("%-11s %14" PRIu64 " %9.1f %10" PRId64 " %14.1f %12.2f %8.2f\n", names[!plain], total.nodes,
+               total.nodes ? 100.0 * total.qnodes / total.nodes : 0.0, elapsed,
+               total.cutoffs ? 100.0 * total.cutoffs_by_move[0] / total.cutoffs : 0.0,
+               total.interior_nodes ? (double)total.moves_searched / total.interior_nodes : 0.0,
+               previous ? (double)last / previous : 0.0);
+    }
+
+    tt_free(&tt);
+    return 0;
+}
+
+// Function to compare search speed with and without the pawn hash table over the bench positions
+int run_pawn_bench(int depth, size_t hash_mb) {
+    static SearchThread st;
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth};
+    const char *names[2] = {"table", "recompute"};
+
+    if (!tt_init(&tt, hash_mb)) return 1;
+    st.tt = &tt;
+    printf("Fixed depth %d over %d positions\n", depth, bench_fen_count);
+    printf("%-10s %14s %10s %12s %12s\n", "pawns", "nodes", "time ms", "nps", "hit rate %");
+
+    // Both passes evaluate identically, so they search the same trees
+    for (int plain = 0; plain <= 1; plain++) {
+        uint64_t nodes = 0, probes = 0, hits = 0;
+        int64_t elapsed = 0;
+
+        st.plain_pawns = plain;
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            tt_clear(&tt);
+
+            int64_t start = now_ms();
+            search_position(&st, &pos, &limits);
+            elapsed += now_ms() - start;
+            nodes += st.stats.nodes;
+            probes += st.pawns.probes;
+            hits += st.pawns.hits;
+        }
+
+        printf("%-10s %14" PRIu64 " %10" PRId64 " %12" PRIu64, names[plain], nodes, elapsed,
+               elapsed > 0 ? nodes * 1000 / (uint64_t)elapsed : nodes);
+        // The table only counts probes when search statistics are compiled in
+        if (STATS_ENABLED) printf(" %12.1f\n", probes ? 100.0 * hits / probes : 0.0);
+        else printf(" %12s\n", "-");
+    }
+
+    tt_free(&tt);
+    return 0;
+}
+
+// Selective search settings compared by run_prune_bench; the first is the reference
+// the others' best moves are checked against
+static const struct {
+    const char *name;
+    int pruning_off;
+} prune_configs[] = {
+    {"none", PRUNE_ALL},
+    {"all", 0},
+    {"no null move", PRUNE_NULL_MOVE},
+    {"no lmr", PRUNE_LMR},
+    {"no futility", PRUNE_FUTILITY},
+    {"no aspiration", PRUNE_ASPIRATION},
+    {"no pvs", PRUNE_PVS},
+    {"only null move", PRUNE_ALL & ~PRUNE_NULL_MOVE},
+    {"only lmr", PRUNE_ALL & ~PRUNE_LMR},
+    {"only futility", PRUNE_ALL & ~PRUNE_FUTILITY},
+    {"only aspiration", PRUNE_ALL & ~PRUNE_ASPIRATION},
+    {"only pvs", PRUNE_ALL & ~PRUNE_PVS},
+};
+#define PRUNE_CONFIG_COUNT ((int)(sizeof(prune_configs) / sizeof(prune_configs[0])))
+
+// Function to compare search trees and time to depth with each selective search technique
+// switched on and off over the bench positions
+int run_prune_bench(int depth, size_t hash_mb) {
+    static SearchThread st;
+    static int64_t time_to_depth[PRUNE_CONFIG_COUNT][MAX_PLY];
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth};
+    Move reference[64];
+
+    if (depth < 2) depth = limits.depth = 2;
+    if (depth >= MAX_PLY) depth = limits.depth = MAX_PLY - 1;
+    if (!tt_init(&tt, hash_mb)) return 1;
+    st.tt = &tt;
+    printf("Fixed depth %d over %d positions\n", depth, bench_fen_count);
+    printf("%-16s %14s %10s %8s %10s\n", "pruning", "nodes", "time ms", "EBF", "same move");
+
+    for (int c = 0; c < PRUNE_CONFIG_COUNT; c++) {
+        uint64_t nodes = 0, last = 0, previous = 0;
+        int64_t elapsed = 0;
+        int same = 0;
+
+        st.pruning_off = prune_configs[c].pruning_off;
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            tt_clear(&tt);
+
+            int64_t start = now_ms();
+            Move move = search_position(&st, &pos, &limits);
+            elapsed += now_ms() - start;
+            nodes += st.stats.nodes;
+
+            if (c == 0) reference[i] = move;
+            same += move == reference[i];
+            for (int d = 1; d <= depth; d++) {
+                // A search that ended early (a forced mate) reached the rest at once
+                time_to_depth[c][d] += st.iteration_time[d <= st.completed_depth ? d : st.completed_depth];
+            }
+
+            // Effective branching factor: growth of the tree from one iteration to the next
+            int d = st.completed_depth;
+            if (d >= 2) {
+                last += st.iteration_nodes[d] - st.iteration_nodes[d - 1];
+                previous += st.iteration_nodes[d - 1] - (d >= 3 ? st.iteration_nodes[d - 2] : 0);
+            }
+        }
+
+        printf("%-16s %14" PRIu64 " %10" PRId64 " %8.2f %6d/%-3d\n", prune_configs[c].name, nodes, elapsed,
+               previous ? (double)last / previous : 0.0, same, bench_fen_count);
+    }
+
+    printf("Time to depth in ms, summed over the positions\n%-16s", "pruning");
+    for (int d = 1; d <= depth; d++) printf(" %8d", d);
+    printf("\n");
+    for (int c = 0; c < PRUNE_CONFIG_COUNT; c++) {
+        printf("%-16s", prune_configs[c].name);
+        for (int d = 1; d <= depth; d++) printf(" %8" PRId64, time_to_depth[c][d]);
+        printf("\n");
+    }
+
+    tt_free(&tt);
+    return 0;
+}
+
+// Function to search every bench position to a fixed depth on one thread with a cleared
+// table; the total node count is a signature that changes only if the search does
+int run_search_bench(int depth) {
+    static SearchThread st;
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth};
+    uint64_t nodes = 0;
+    int64_t elapsed = 0;
+    char text[6];
+
+    if (!tt_init(&tt, BENCH_HASH_MB)) return 1;
+    st.tt = &tt;
+    printf("Fixed depth %d over %d positions, %d MB hash\n", depth, bench_fen_count, BENCH_HASH_MB);
+    printf("%-4s %-6s %7s %12s %10s\n", "pos", "move", "score", "nodes", "time ms");
+
+    for (int i = 0; i < bench_fen_count; i++) {
+        Position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        tt_clear(&tt);
+
+        int64_t start = now_ns();
+        Move move = search_position(&st, &pos, &limits);
+        int64_t spent = now_ns() - start;
+
+        move_to_uci(move, text);
+        printf("%-4d %-6s %7d %12" PRIu64 " %10.1f\n", i + 1, text, st.best_score, st.stats.nodes, spent / 1e6);
+        nodes += st.stats.nodes;
+        elapsed += spent;
+    }
+
+    printf("Total time (ms): %" PRId64 "\n", elapsed / 1000000);
+    printf("Nodes/second: %" PRIu64 "\n", elapsed > 0 ? (uint64_t)(nodes * 1e9 / elapsed) : nodes);
+    printf("Nodes searched: %" PRIu64 "\n", nodes);
+
+    tt_free(&tt);
+    return 0;
+}
+
+// Walk modes for run_nnue_bench: what is evaluated at every node
+#define WALK_NONE 0
+#define WALK_CLASSICAL 1
+#define WALK_NNUE_FULL 2
+#define WALK_NNUE_INCREMENTAL 3
+
+// Function to walk the legal move tree evaluating every node the way mode says; the
+// incremental walk also counts the nodes where it disagrees with a full refresh when asked
+static uint64_t nnue_walk(Position *pos, NnueAccumulator *acc, DirtyPieces *dirty, int ply, int depth,
+                          int mode, int64_t *checksum, uint64_t *mismatches) {
+    MoveList list;
+    uint64_t nodes = 1;
+
+    if (mode == WALK_CLASSICAL) *checksum += evaluate(pos, NULL);
+    else if (mode == WALK_NNUE_FULL) *checksum += nnue_evaluate_full(pos);
+    else if (mode == WALK_NNUE_INCREMENTAL) {
+        int score = nnue_evaluate(pos, acc, dirty, ply);
+        *checksum += score;
+        if (mismatches && score != nnue_evaluate_full(pos)) (*mismatches)++;
+    }
+    if (depth == 0) return nodes;
+
+    generate_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        nnue_record_move(pos, list.moves[i], &dirty[ply + 1]);
+        acc[ply + 1].computed[0] = acc[ply + 1].computed[1] = 0;
+        make_move(pos, list.moves[i]);
+        nodes += nnue_walk(pos, acc, dirty, ply + 1, depth - 1, mode, checksum, mismatches);
+        unmake_move(pos, list.moves[i]);
+    }
+    return nodes;
+}
+
+// Function to time one evaluation mode over the bench positions; returns nanoseconds
+static int64_t nnue_walk_all(int depth, int mode, uint64_t *nodes, int64_t *checksum, uint64_t *mismatches) {
+    static NnueAccumulator acc[MAX_PLY + 1];
+    static DirtyPieces dirty[MAX_PLY + 1];
+    int64_t elapsed = 0;
+
+    *nodes = 0;
+    *checksum = 0;
+    for (int i = 0; i < bench_fen_count; i++) {
+        Position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        acc[0].computed[0] = acc[0].computed[1] = 0;
+        int64_t start = now_ns();
+        *nodes += nnue_walk(&pos, acc, dirty, 0, depth, mode, checksum, mismatches);
+        elapsed += now_ns() - start;
+    }
+    return elapsed;
+}
+
+// Function to compare network evaluation, full and incremental on every SIMD path, with
+// the classical evaluation over a tree walk of the bench positions, check the incremental
+// updates against full refreshes, and compare search speed with both evaluations
+int run_nnue_bench(int depth, size_t hash_mb) {
+    static SearchThread st;
+    TranspositionTable tt = {0};
+    SearchLimits limits = {.depth = depth + 3};
+    uint64_t nodes, mismatches = 0;
+    int64_t checksum, bare, elapsed;
+    int best = nnue_best_simd();
+
+    if (!nnue_loaded()) {
+        printf("No network given (--nnue <file>); using the bootstrap network\n");
+        nnue_init_bootstrap();
+        if (!nnue_loaded()) return 1;
+    }
+
+    bare = nnue_walk_all(depth, WALK_NONE, &nodes, &checksum, NULL);
+    printf("Walk to depth %d over %d positions, every node evaluated: %" PRIu64 " nodes\n", depth,
+           bench_fen_count, nodes);
+    printf("%-24s %14s %10s %12s\n", "evaluation", "evals/s", "ns/eval", "checksum");
+
+    elapsed = nnue_walk_all(depth, WALK_CLASSICAL, &nodes, &checksum, NULL);
+    printf("%-24s %14.0f %10.1f %12" PRId64 "\n", "classical", nodes * 1e9 / (elapsed ? elapsed : 1),
+           elapsed > bare ? (double)(elapsed - bare) / nodes : 0.0, checksum);
+    for (int level = NNUE_SCALAR; level <= best; level++) {
+        char name[32];
+        nnue_set_simd(level);
+        for (int mode = WALK_NNUE_FULL; mode <= WALK_NNUE_INCREMENTAL; mode++) {
+            elapsed = nnue_walk_all(depth, mode, &nodes, &checksum, NULL);
+            snprintf(name, sizeof(name), "nnue %s %s", nnue_simd_name(level),
+                     mode == WALK_NNUE_FULL ? "full" : "incremental");
+            printf("%-24s %14.0f %10.1f %12" PRId64 "\n", name, nodes * 1e9 / (elapsed ? elapsed : 1),
+                   elapsed > bare ? (double)(elapsed - bare) / nodes : 0.0, checksum);
+        }
+    }
+
+    nnue_walk_all(depth, WALK_NNUE_INCREMENTAL, &nodes, &checksum, &mismatches);
+    printf("Incremental against full refresh (%s): %" PRIu64 " mismatches\n", nnue_simd_name(best), mismatches);
+
+    if (!tt_init(&tt, hash_mb)) return 1;
+    st.tt = &tt;
+    printf("Fixed depth %d search over %d positions\n", limits.depth, bench_fen_count);
+    printf("%-10s %14s %10s %12s\n", "eval", "nodes", "time ms", "nps");
+    for (int classical = 0; classical <= 1; classical++) {
+        nodes = 0;
+        elapsed = 0;
+        st.classical_eval = classical;
+        for (int i = 0; i < bench_fen_count; i++) {
+            Position pos;
+            position_set_fen(&pos, bench_fens[i]);
+            tt_clear(&tt);
+
+            int64_t start = now_ms();
+            search_position(&st, &pos, &limits);
+            elapsed += now_ms() - start;
+            nodes += st.stats.nodes;
+        }
+        printf("%-10s %14" PRIu64 " %10" PRId64 " %12" PRIu64 "\n", classical ? "classical" : "nnue", nodes,
+               elapsed, elapsed > 0 ? nodes * 1000 / (uint64_t)elapsed : nodes);
+    }
+
+    tt_free(&tt);
+    return mismatches ? 1 : 0;
+}
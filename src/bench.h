@@ -0,0 +1,38 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+// Table size for the signature bench; the node count depends on it
+#define BENCH_HASH_MB 16
+#define BENCH_DEFAULT_DEPTH 7
+
+extern const char *bench_fens[];
+extern const int bench_fen_count;
+
+// Function to measure time-to-depth over the bench positions with 1, 2, 4 ... max_threads
+int run_smp_bench(int max_threads, int depth, size_t hash_mb);
+
+// Function to compare tree walks with and without leaf evaluation over the bench positions
+int run_eval_bench(int depth);
+
+// Function to compare search trees with and without move ordering over the bench positions
+int run_order_bench(int depth, size_t hash_mb);
+
+// Function to compare search speed with and without the pawn hash table over the bench positions
+int run_pawn_bench(int depth, size_t hash_mb);
+
+// Function to compare search trees and time to depth with each selective search technique
+// switched on and off over the bench positions
+int run_prune_bench(int depth, size_t hash_mb);
+
+// Function to compare network evaluation, full and incremental on every SIMD path, with
+// the classical evaluation over a tree walk of the bench positions, check the incremental
+// updates against full refreshes, and compare search speed with both evaluations
+int run_nnue_bench(int depth, size_t hash_mb);
+
+// Function to search the bench positions to a fixed depth on one thread and print
+// the node count signature and speed
+int run_search_bench(int depth);
+
+#endif
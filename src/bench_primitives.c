@@ -0,0 +1,280 @@
+// Microbenchmark for the board[8][8] move predicates of the interactive game.
+// Every predicate is timed over a fixed corpus (the bench positions plus a few
+// mates and stalemates) and reported in ns and cycles per call; the count of
+// true results is a checksum that must not change when a predicate is rewritten.
+// The piece predicates are also timed against the direction-loop versions they
+// replaced, which must give the same answer to every query.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "legacy.h"
+#include "bench.h"
+#include "misc.h"
+#include "eval.h"
+#include "pawns.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+// Time stamp counter: reference cycles at the nominal clock, not core cycles
+static inline uint64_t read_cycles(void) { return __rdtsc(); }
+#else
+#define HAVE_TSC 0
+static inline uint64_t read_cycles(void) { return 0; }
+#endif
+
+#define MIN_SAMPLE_NS 300000000LL   // time each predicate for at least this long
+#define CALLS_PER_SAMPLE 4096        // calls between two clock reads
+
+// Positions where the mate and stalemate predicates answer yes
+static const char *extra_fens[] = {
+    "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+    "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+    "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",
+    "k7/2Q5/1K6/8/8/8/8/8 b - - 0 1",
+    "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1",
+};
+
+// One predicate call: a move on the board, or a king square and color
+typedef struct {
+    int8_t sr, sc, dr, dc;
+    int8_t color;
+} Query;
+
+// The queries of one position
+typedef struct {
+    Position pos;
+    Query *queries;
+    int count;
+} Sample;
+
+// Function to call a predicate on every query and count the yes answers
+typedef int64_t (*Runner)(const Query *q, int n);
+
+#define MOVE_RUNNER(name, call)                                   \
+    static int64_t name(const Query *q, int n) {                  \
+        int64_t yes = 0;                                          \
+        for (int i = 0; i < n; i++) yes += call;                  \
+        return yes;                                               \
+    }
+
+// The piece predicates as they were before the table lookups: a step direction found by
+// division, then a walk that bounds-checks every square. Kept as the baseline
+
+// Function to check if a pawn move is legal, walking the board
+static int loop_pawn_move(int sr, int sc, int dr, int dc) {
+    int piece = board[sr][sc];
+    int direction = (piece & BLACK) ? 1 : -1;
+    int start_row = (piece & BLACK) ? 1 : 6;
+    int opponent_color = (piece & BLACK) ? WHITE : BLACK;
+
+    if (dc == sc && is_square_empty(dr, dc)) {
+        if (dr == sr + direction) return 1;
+        if (sr == start_row && dr == sr + 2 * direction && is_square_empty(sr + direction, sc)) return 1;
+    } else if ((dc == sc + 1 || dc == sc - 1) && dr == sr + direction && is_opponent_piece(dr, dc, opponent_color)) {
+        return 1;
+    }
+    return 0;
+}
+
+// Function to check if a knight move is legal, walking the board
+static int loop_knight_move(int sr, int sc, int dr, int dc, int color) {
+    int row_diff = abs(dr - sr), col_diff = abs(dc - sc);
+    return ((row_diff == 2 && col_diff == 1) || (row_diff == 1 && col_diff == 2))
+        && (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color));
+}
+
+// Function to check if a bishop move is legal, walking the board
+static int loop_bishop_move(int sr, int sc, int dr, int dc, int color) {
+    if (abs(dr - sr) != abs(dc - sc)) return 0;
+    int row_step = (dr - sr) / abs(dr - sr);
+    int col_step = (dc - sc) / abs(dc - sc);
+    for (int r = sr + row_step, c = sc + col_step; r != dr && c != dc; r += row_step, c += col_step) {
+        if (!is_square_empty(r, c)) return 0;
+    }
+    return is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color);
+}
+
+// Function to check if a rook move is legal, walking the board
+static int loop_rook_move(int sr, int sc, int dr, int dc, int color) {
+    if (sr != dr && sc != dc) return 0;
+    int row_step = (dr - sr) ? (dr - sr) / abs(dr - sr) : 0;
+    int col_step = (dc - sc) ? (dc - sc) / abs(dc - sc) : 0;
+    for (int r = sr + row_step, c = sc + col_step; r != dr || c != dc; r += row_step, c += col_step) {
+        if (!is_square_empty(r, c)) return 0;
+    }
+    return is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color);
+}
+
+// Function to check if a queen move is legal, walking the board
+static int loop_queen_move(int sr, int sc, int dr, int dc, int color) {
+    return loop_bishop_move(sr, sc, dr, dc, color) || loop_rook_move(sr, sc, dr, dc, color);
+}
+
+// Function to check if a king move is legal, walking the board
+static int loop_king_move(int sr, int sc, int dr, int dc, int color) {
+    return abs(dr - sr) <= 1 && abs(dc - sc) <= 1 && (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color));
+}
+
+MOVE_RUNNER(run_pawn, is_legal_pawn_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc))
+MOVE_RUNNER(run_knight, is_legal_knight_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(run_bishop, is_legal_bishop_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(run_rook, is_legal_rook_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(run_queen, is_legal_queen_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(run_king, is_legal_king_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(run_in_check, is_in_check(q[i].sr, q[i].sc, q[i].color))
+MOVE_RUNNER(run_checkmate, is_checkmate(q[i].color))
+MOVE_RUNNER(run_stalemate, is_stalemate(q[i].color))
+MOVE_RUNNER(loop_pawn, loop_pawn_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc))
+MOVE_RUNNER(loop_knight, loop_knight_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(loop_bishop, loop_bishop_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(loop_rook, loop_rook_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(loop_queen, loop_queen_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+MOVE_RUNNER(loop_king, loop_king_move(q[i].sr, q[i].sc, q[i].dr, q[i].dc, q[i].color))
+
+// A predicate and the piece whose moves it is asked about; KING_SQUARE queries
+// the king squares and COLOR_ONLY just each color
+#define KING_SQUARE 8
+#define COLOR_ONLY 9
+
+typedef struct {
+    const char *name;
+    Runner run;
+    Runner baseline;          // the implementation it replaced, or NULL
+    int piece;
+} Primitive;
+
+static const Primitive primitives[] = {
+    {"is_legal_pawn_move", run_pawn, loop_pawn, PAWN},
+    {"is_legal_knight_move", run_knight, loop_knight, KNIGHT},
+    {"is_legal_bishop_move", run_bishop, loop_bishop, BISHOP},
+    {"is_legal_rook_move", run_rook, loop_rook, ROOK},
+    {"is_legal_queen_move", run_queen, loop_queen, QUEEN},
+    {"is_legal_king_move", run_king, loop_king, KING},
+    {"is_in_check", run_in_check, NULL, KING_SQUARE},
+    {"is_checkmate", run_checkmate, NULL, COLOR_ONLY},
+    {"is_stalemate", run_stalemate, NULL, COLOR_ONLY},
+};
+#define PRIMITIVE_COUNT ((int)(sizeof(primitives) / sizeof(primitives[0])))
+
+// Function to build the queries of one position: every piece of the given type of
+// either color to every other square, so both the yes and no paths are exercised
+static int build_queries(const Position *pos, int piece, Query *out) {
+    int n = 0;
+
+    for (int ci = 0; ci < 2; ci++) {
+        int color = ci == 0 ? WHITE : BLACK;
+        if (piece == COLOR_ONLY) {
+            out[n++] = (Query){0, 0, 0, 0, (int8_t)color};
+            continue;
+        }
+        Bitboard b = pos->by_color[ci] & pos->by_type[piece == KING_SQUARE ? KING : piece];
+        while (b) {
+            int from = pop_lsb(&b);
+            if (piece == KING_SQUARE) {
+                out[n++] = (Query){(int8_t)SQ_ROW(from), (int8_t)SQ_COL(from), 0, 0, (int8_t)color};
+                continue;
+            }
+            for (int to = 0; to < 64; to++) {
+                if (to == from) continue;
+                out[n++] = (Query){(int8_t)SQ_ROW(from), (int8_t)SQ_COL(from), (int8_t)SQ_ROW(to),
+                                   (int8_t)SQ_COL(to), (int8_t)color};
+            }
+        }
+    }
+    return n;
+}
+
+// Function to time one runner over the corpus for at least MIN_SAMPLE_NS; returns ns per
+// call and stores reference cycles per call through cycles_per_call
+static double time_runner(Runner run, Sample *samples, int count, double *cycles_per_call) {
+    int64_t calls = 0, elapsed = 0;
+    uint64_t cycles = 0;
+
+    while (elapsed < MIN_SAMPLE_NS) {
+        for (int i = 0; i < count; i++) {
+            if (samples[i].count == 0) continue;
+            int repeat = CALLS_PER_SAMPLE / samples[i].count + 1;
+            volatile int64_t sink = 0;
+
+            position_to_board(&samples[i].pos, board);
+            game = samples[i].pos;
+            int64_t start = now_ns();
+            uint64_t start_cycles = read_cycles();
+            for (int r = 0; r < repeat; r++) sink += run(samples[i].queries, samples[i].count);
+            cycles += read_cycles() - start_cycles;
+            elapsed += now_ns() - start;
+            calls += (int64_t)repeat * samples[i].count;
+            (void)sink;
+        }
+    }
+    *cycles_per_call = (double)cycles / calls;
+    return (double)elapsed / calls;
+}
+
+// Function to time one predicate (and the implementation it replaced) over the corpus;
+// returns 0 if it disagrees with the old one
+static int time_primitive(const Primitive *p, Sample *samples, int count) {
+    int64_t yes = 0, differ = 0;
+    double ns, cycles, baseline_ns = 0, baseline_cycles;
+    int total = 0;
+
+    for (int i = 0; i < count; i++) {
+        samples[i].count = build_queries(&samples[i].pos, p->piece, samples[i].queries);
+        total += samples[i].count;
+    }
+    if (total == 0) return 1;
+
+    // One untimed sweep gives the checksum, compares every answer and warms the caches
+    for (int i = 0; i < count; i++) {
+        position_to_board(&samples[i].pos, board);
+        game = samples[i].pos;
+        yes += p->run(samples[i].queries, samples[i].count);
+        for (int q = 0; p->baseline && q < samples[i].count; q++) {
+            differ += p->run(&samples[i].queries[q], 1) != p->baseline(&samples[i].queries[q], 1);
+        }
+    }
+
+    ns = time_runner(p->run, samples, count, &cycles);
+    if (p->baseline) baseline_ns = time_runner(p->baseline, samples, count, &baseline_cycles);
+
+    printf("%-22s %8d %8" PRId64 " %10.2f", p->name, total, yes, ns);
+    if (HAVE_TSC) printf(" %12.2f", cycles);
+    else printf(" %12s", "-");
+    if (p->baseline) printf(" %10.2f %8.2fx", baseline_ns, ns > 0 ? baseline_ns / ns : 0.0);
+    if (differ) printf("  %" PRId64 " answers differ from the loop version", differ);
+    printf("\n");
+    return differ == 0;
+}
+
+// Main function
+int main(void) {
+    int count = bench_fen_count + (int)(sizeof(extra_fens) / sizeof(extra_fens[0]));
+    Sample *samples = calloc((size_t)count, sizeof(Sample));
+
+    init_bitboards();
+    init_zobrist();
+    init_eval();
+    init_pawns();
+    if (!samples) return 1;
+    for (int i = 0; i < count; i++) {
+        const char *fen = i < bench_fen_count ? bench_fens[i] : extra_fens[i - bench_fen_count];
+        // At most 16 pieces of one type per side, each asked about 63 squares
+        samples[i].queries = malloc(2 * 16 * 63 * sizeof(Query));
+        if (!samples[i].queries || !position_set_fen(&samples[i].pos, fen)) {
+            printf("Bad bench position %s\n", fen);
+            return 1;
+        }
+    }
+
+    printf("%d positions, each predicate timed for at least %lld ms\n", count, MIN_SAMPLE_NS / 1000000);
+    printf("%-22s %8s %8s %10s %12s %10s %9s\n", "primitive", "queries", "true", "ns/op", HAVE_TSC ? "ref cyc/op" : "cycles/op",
+           "loop ns/op", "speedup");
+    int agree = 1;
+    for (int i = 0; i < PRIMITIVE_COUNT; i++) agree &= time_primitive(&primitives[i], samples, count);
+
+    for (int i = 0; i < count; i++) free(samples[i].queries);
+    free(samples);
+    return agree ? 0 : 1;
+}
@@ -0,0 +1,472 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bitbase.h"
+#include "misc.h"
+
+#define BITBASE_MAGIC "BITBASE1"
+#define BITBASE_HEADER_SIZE 16
+#define BITBASE_MAX_THREADS 64
+
+// Generation states; a win found at retrograde level L is stored as STATE_WIN + L
+#define STATE_UNKNOWN 0
+#define STATE_INVALID 1
+#define STATE_DRAW 2
+#define STATE_WIN 3
+
+// An endgame of a king and the listed pieces against a lone king. Tables are
+// indexed by side to move (0 = strong side), strong king, lone king and the pieces,
+// with the strong side always playing "white" (pawns moving towards row 0). The
+// lone king can never win, so one bit per position is enough: strong side wins or not
+typedef struct {
+    const char *name;
+    int types[2];
+    int count;
+} Endgame;
+
+// Ordered so that KPK can look up the KQK and KRK results of its promotions
+static const Endgame endgames[] = {
+    {"KQK", {QUEEN, 0}, 1},
+    {"KRK", {ROOK, 0}, 1},
+    {"KPK", {PAWN, 0}, 1},
+    {"KBNK", {BISHOP, KNIGHT}, 2},
+};
+#define ENDGAME_COUNT ((int)(sizeof(endgames) / sizeof(endgames[0])))
+
+// Mapped bitbase files, one per endgame; NULL if not loaded
+static const uint8_t *tables[ENDGAME_COUNT];
+static const uint8_t *mappings[ENDGAME_COUNT];
+static size_t mapping_sizes[ENDGAME_COUNT];
+static int loaded_count = 0;
+
+// Decoded table index
+typedef struct {
+    int stm;
+    int wk;
+    int bk;
+    int sq[2];
+} BitbaseIndex;
+
+// Function to get the number of positions in an endgame's table
+static size_t table_positions(const Endgame *eg) {
+    return (size_t)2 << (6 * (2 + eg->count));
+}
+
+// Function to pack a position into a table index
+static size_t encode_index(const Endgame *eg, const BitbaseIndex *p) {
+    size_t idx = ((size_t)p->stm * 64 + (size_t)p->wk) * 64 + (size_t)p->bk;
+    for (int i = 0; i < eg->count; i++) idx = idx * 64 + (size_t)p->sq[i];
+    return idx;
+}
+
+// Function to unpack a table index
+static void decode_index(const Endgame *eg, size_t idx, BitbaseIndex *p) {
+    for (int i = eg->count - 1; i >= 0; i--) {
+        p->sq[i] = (int)(idx & 63);
+        idx >>= 6;
+    }
+    p->bk = (int)(idx & 63);
+    p->wk = (int)((idx >> 6) & 63);
+    p->stm = (int)(idx >> 12);
+}
+
+// Function to test one bit of a loaded table
+static inline int table_win(int eg, size_t idx) {
+    return (tables[eg][idx >> 3] >> (idx & 7)) & 1;
+}
+
+// Function to get the squares attacked by a strong-side piece
+static Bitboard piece_attacks(int type, int sq, Bitboard occ) {
+    switch (type) {
+        case PAWN: return pawn_attacks[0][sq];
+        case KNIGHT: return knight_attacks[sq];
+        case BISHOP: return bishop_attacks(sq, occ);
+        case ROOK: return rook_attacks(sq, occ);
+        case QUEEN: return queen_attacks(sq, occ);
+        default: return king_attacks[sq];
+    }
+}
+
+// Function to get every square the strong side attacks
+static Bitboard strong_attacks(const Endgame *eg, const BitbaseIndex *p, Bitboard occ) {
+    Bitboard attacks = king_attacks[p->wk];
+    for (int i = 0; i < eg->count; i++) attacks |= piece_attacks(eg->types[i], p->sq[i], occ);
+    return attacks;
+}
+
+// Function to get the squares of the strong side's pieces other than the king
+static Bitboard strong_pieces(const Endgame *eg, const BitbaseIndex *p) {
+    Bitboard pieces = 0;
+    for (int i = 0; i < eg->count; i++) pieces |= SQ_BB(p->sq[i]);
+    return pieces;
+}
+
+// Work shared by the generator threads for one endgame
+typedef struct {
+    const Endgame *eg;
+    _Atomic uint8_t *state;
+    _Atomic uint8_t *count;     // legal moves of the lone king not yet known to lose
+    size_t size;
+    int level;
+    atomic_int changed;
+} Generator;
+
+// Arguments of one generator thread
+typedef struct {
+    Generator *gen;
+    size_t begin;
+    size_t end;
+    void (*run)(Generator *gen, size_t idx);
+} GeneratorJob;
+
+// Function to classify a position before any retrograde step: invalid, drawn,
+// already won (mate, winning promotion) or unknown with its lone-king move count
+static void init_position(Generator *gen, size_t idx) {
+    const Endgame *eg = gen->eg;
+    BitbaseIndex p;
+    decode_index(eg, idx, &p);
+
+    if (p.wk == p.bk) goto invalid;
+    Bitboard occ = SQ_BB(p.wk) | SQ_BB(p.bk);
+    for (int i = 0; i < eg->count; i++) {
+        if (occ & SQ_BB(p.sq[i])) goto invalid;
+        if (eg->types[i] == PAWN && (SQ_ROW(p.sq[i]) == 0 || SQ_ROW(p.sq[i]) == 7)) goto invalid;
+        occ |= SQ_BB(p.sq[i]);
+    }
+    if (king_attacks[p.wk] & SQ_BB(p.bk)) goto invalid;
+
+    Bitboard attacked = strong_attacks(eg, &p, occ);
+    if (p.stm == 0) {
+        // The lone king cannot be in check with the strong side to move
+        if (attacked & SQ_BB(p.bk)) goto invalid;
+
+        // A promotion into a won KQK or KRK position wins outright
+        for (int i = 0; i < eg->count; i++) {
+            int to = p.sq[i] - 8;
+            if (eg->types[i] != PAWN || SQ_ROW(to) != 0 || (occ & SQ_BB(to))) continue;
+            for (int promo = 0; promo < 2; promo++) {
+                BitbaseIndex q = {1, p.wk, p.bk, {to, 0}};
+                if (tables[promo] && table_win(promo, encode_index(&endgames[promo], &q))) {
+                    atomic_store_explicit(&gen->state[idx], STATE_WIN, memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+        atomic_store_explicit(&gen->state[idx], STATE_UNKNOWN, memory_order_relaxed);
+        return;
+    }
+
+    // Lone king to move: x-rays through its own square count, it cannot hide behind itself
+    Bitboard moves = king_attacks[p.bk] & ~strong_attacks(eg, &p, occ ^ SQ_BB(p.bk));
+    if (moves & strong_pieces(eg, &p)) {
+        // Taking an undefended piece leaves too little to win with
+        atomic_store_explicit(&gen->state[idx], STATE_DRAW, memory_order_relaxed);
+    } else if (!moves) {
+        atomic_store_explicit(&gen->state[idx], (attacked & SQ_BB(p.bk)) ? STATE_WIN : STATE_DRAW,
+                              memory_order_relaxed);
+    } else {
+        atomic_store_explicit(&gen->count[idx], (uint8_t)popcount(moves), memory_order_relaxed);
+        atomic_store_explicit(&gen->state[idx], STATE_UNKNOWN, memory_order_relaxed);
+    }
+    return;
+
+invalid:
+    atomic_store_explicit(&gen->state[idx], STATE_INVALID, memory_order_relaxed);
+}
+
+// Function to mark a position won at the next level if nothing decided it yet
+static void mark_win(Generator *gen, size_t idx) {
+    uint8_t expected = STATE_UNKNOWN;
+    if (atomic_compare_exchange_strong(&gen->state[idx], &expected, (uint8_t)(STATE_WIN + gen->level + 1))) {
+        atomic_store_explicit(&gen->changed, 1, memory_order_relaxed);
+    }
+}
+
+// Function to take one retrograde step back from a position won at the current level:
+// every strong-side move into it wins, and a lone-king position wins once all its moves lose
+static void retro_position(Generator *gen, size_t idx) {
+    if (atomic_load_explicit(&gen->state[idx], memory_order_relaxed) != STATE_WIN + gen->level) return;
+
+    const Endgame *eg = gen->eg;
+    BitbaseIndex p;
+    decode_index(eg, idx, &p);
+    Bitboard occ = SQ_BB(p.wk) | SQ_BB(p.bk) | strong_pieces(eg, &p);
+
+    if (p.stm == 0) {
+        // Undo lone-king moves; no capture can lead into this endgame
+        Bitboard from = king_attacks[p.bk] & ~occ;
+        while (from) {
+            BitbaseIndex q = p;
+            q.stm = 1;
+            q.bk = pop_lsb(&from);
+            size_t prev = encode_index(eg, &q);
+            if (atomic_load_explicit(&gen->state[prev], memory_order_relaxed) != STATE_UNKNOWN) continue;
+            if (atomic_fetch_sub(&gen->count[prev], 1) == 1) mark_win(gen, prev);
+        }
+        return;
+    }
+
+    // Undo strong-side moves; piece moves are reversible, pawns only step back
+    for (int piece = -1; piece < eg->count; piece++) {
+        int sq = piece < 0 ? p.wk : p.sq[piece];
+        int type = piece < 0 ? KING : eg->types[piece];
+        Bitboard from;
+
+        if (type == PAWN) {
+            from = 0;
+            if (SQ_ROW(sq) < 6 && !(occ & SQ_BB(sq + 8))) {
+                from |= SQ_BB(sq + 8);
+                if (SQ_ROW(sq) == 4 && !(occ & SQ_BB(sq + 16))) from |= SQ_BB(sq + 16);
+            }
+        } else {
+            from = piece_attacks(type, sq, occ) & ~occ;
+        }
+
+        while (from) {
+            BitbaseIndex q = p;
+            q.stm = 0;
+            if (piece < 0) q.wk = pop_lsb(&from);
+            else q.sq[piece] = pop_lsb(&from);
+            mark_win(gen, encode_index(eg, &q));
+        }
+    }
+}
+
+// Function to run a generator step over one slice of the table
+static void *generator_main(void *arg) {
+    GeneratorJob *job = arg;
+    for (size_t idx = job->begin; idx < job->end; idx++) job->run(job->gen, idx);
+    return NULL;
+}
+
+// Function to run a generator step over the whole table, split across threads
+static void run_parallel(Generator *gen, int threads, void (*run)(Generator *, size_t)) {
+    pthread_t handles[BITBASE_MAX_THREADS];
+    GeneratorJob jobs[BITBASE_MAX_THREADS];
+    size_t slice = (gen->size + (size_t)threads - 1) / (size_t)threads;
+    int started = 0;
+
+    for (int i = 0; i < threads; i++) {
+        jobs[i].gen = gen;
+        jobs[i].begin = slice * (size_t)i < gen->size ? slice * (size_t)i : gen->size;
+        jobs[i].end = jobs[i].begin + slice < gen->size ? jobs[i].begin + slice : gen->size;
+        jobs[i].run = run;
+    }
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&handles[i], NULL, generator_main, &jobs[i]) != 0) break;
+        started++;
+    }
+    generator_main(&jobs[0]);
+    for (int i = 1; i <= started; i++) pthread_join(handles[i], NULL);
+
+    // Slices whose thread could not be started are done here
+    for (int i = started + 1; i < threads; i++) generator_main(&jobs[i]);
+}
+
+// Function to map one bitbase file; returns 1 on success
+static int load_table(const char *dir, int eg) {
+    char path[4096];
+    struct stat st;
+    size_t bytes = (table_positions(&endgames[eg]) + 7) / 8;
+
+    snprintf(path, sizeof(path), "%s/%s.bb", dir, endgames[eg].name);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != BITBASE_HEADER_SIZE + bytes) {
+        printf("Bitbase %s has the wrong size\n", path);
+        close(fd);
+        return 0;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+    if (memcmp(data, BITBASE_MAGIC, 8) != 0) {
+        printf("Bitbase %s has a bad header\n", path);
+        munmap(data, (size_t)st.st_size);
+        return 0;
+    }
+
+    if (mappings[eg]) munmap((void *)mappings[eg], mapping_sizes[eg]);
+    else loaded_count++;
+    mappings[eg] = data;
+    mapping_sizes[eg] = (size_t)st.st_size;
+    tables[eg] = (const uint8_t *)data + BITBASE_HEADER_SIZE;
+    return 1;
+}
+
+// Function to pack the won positions into bits and write them out; returns 1 on success
+static int write_table(const char *dir, const Generator *gen, uint64_t *wins) {
+    char path[4096];
+    uint8_t header[BITBASE_HEADER_SIZE] = {0};
+    size_t bytes = (gen->size + 7) / 8;
+    uint8_t *bits = calloc(bytes, 1);
+
+    if (!bits) return 0;
+    *wins = 0;
+    for (size_t idx = 0; idx < gen->size; idx++) {
+        if (atomic_load_explicit(&gen->state[idx], memory_order_relaxed) >= STATE_WIN) {
+            bits[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+            (*wins)++;
+        }
+    }
+
+    memcpy(header, BITBASE_MAGIC, 8);
+    header[8] = (uint8_t)gen->eg->count;
+    snprintf(path, sizeof(path), "%s/%s.bb", dir, gen->eg->name);
+    FILE *file = fopen(path, "wb");
+    int ok = file && fwrite(header, 1, sizeof(header), file) == sizeof(header)
+          && fwrite(bits, 1, bytes, file) == bytes;
+    if (file && fclose(file) != 0) ok = 0;
+    if (!ok) printf("Could not write %s\n", path);
+    free(bits);
+    return ok;
+}
+
+// Function to generate the KPK, KRK, KQK and KBNK bitbases into dir using the given
+// number of threads, leaving them loaded; returns 1 on success
+int bitbase_generate(const char *dir, int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > BITBASE_MAX_THREADS) threads = BITBASE_MAX_THREADS;
+    printf("Generating bitbases in %s with %d thread(s)\n", dir, threads);
+    printf("%-6s %12s %12s %12s %7s %9s\n", "table", "positions", "wins", "legal", "levels", "time ms");
+
+    int64_t total_start = now_ms();
+    for (int eg = 0; eg < ENDGAME_COUNT; eg++) {
+        Generator gen;
+        int64_t start = now_ms();
+
+        gen.eg = &endgames[eg];
+        gen.size = table_positions(gen.eg);
+        gen.state = malloc(gen.size);
+        gen.count = calloc(gen.size, 1);
+        if (!gen.state || !gen.count) {
+            printf("Could not allocate %zu positions for %s\n", gen.size, gen.eg->name);
+            free(gen.state);
+            free(gen.count);
+            return 0;
+        }
+
+        run_parallel(&gen, threads, init_position);
+        for (gen.level = 0; ; gen.level++) {
+            atomic_store(&gen.changed, 0);
+            run_parallel(&gen, threads, retro_position);
+            if (!atomic_load(&gen.changed) || STATE_WIN + gen.level + 1 >= 255) break;
+        }
+
+        uint64_t wins, legal = 0;
+        for (size_t idx = 0; idx < gen.size; idx++) legal += gen.state[idx] != STATE_INVALID;
+        int ok = write_table(dir, &gen, &wins);
+        free(gen.state);
+        free(gen.count);
+        if (!ok || !load_table(dir, eg)) return 0;
+
+        printf("%-6s %12zu %12llu %12llu %7d %9lld\n", gen.eg->name, gen.size, (unsigned long long)wins,
+               (unsigned long long)legal, gen.level, (long long)(now_ms() - start));
+    }
+    printf("Total: %lld ms\n", (long long)(now_ms() - total_start));
+    return 1;
+}
+
+// Function to map the bitbase files found in dir; returns the number of endgames loaded
+int bitbase_load(const char *dir) {
+    for (int eg = 0; eg < ENDGAME_COUNT; eg++) load_table(dir, eg);
+    return loaded_count;
+}
+
+// Function to unmap every loaded bitbase
+void bitbase_free(void) {
+    for (int eg = 0; eg < ENDGAME_COUNT; eg++) {
+        if (mappings[eg]) munmap((void *)mappings[eg], mapping_sizes[eg]);
+        mappings[eg] = NULL;
+        tables[eg] = NULL;
+    }
+    loaded_count = 0;
+}
+
+// Function to get the Manhattan distance between two squares
+static inline int manhattan_distance(int a, int b) {
+    return abs(SQ_ROW(a) - SQ_ROW(b)) + abs(SQ_COL(a) - SQ_COL(b));
+}
+
+// Function to score a won position for the strong side so the search makes progress:
+// lone king to the edge (to the bishop's corners in KBNK), kings close, pawn advanced
+static int win_score(const Endgame *eg, const BitbaseIndex *p) {
+    int score = VALUE_KNOWN_WIN;
+    int row = SQ_ROW(p->bk), col = SQ_COL(p->bk);
+
+    score += 20 * ((row < 4 ? 3 - row : row - 4) + (col < 4 ? 3 - col : col - 4));
+    score += 10 * (7 - square_distance(p->wk, p->bk));
+    for (int i = 0; i < eg->count; i++) {
+        int sq = p->sq[i];
+        score += piece_value[eg->types[i]];
+        if (eg->types[i] == PAWN) score += 20 * (6 - SQ_ROW(sq));
+        if (eg->types[i] == BISHOP) {
+            // Mate is only possible in a corner the bishop controls
+            int corner = ((SQ_ROW(sq) + SQ_COL(sq)) & 1) == 0 ? 0 : 7;
+            int d = manhattan_distance(p->bk, corner);
+            int d2 = manhattan_distance(p->bk, 63 - corner);
+            score += 40 * (14 - (d < d2 ? d : d2));
+        }
+    }
+    return score;
+}
+
+// Function to find the table and index for pos; returns the endgame number or -1
+static int find_position(const Position *pos, BitbaseIndex *p) {
+    Bitboard occ = occupied_bb(pos);
+    if (!loaded_count || popcount(occ) > 4) return -1;
+
+    int strong;
+    if (!more_than_one(pos->by_color[1])) strong = WHITE;
+    else if (!more_than_one(pos->by_color[0])) strong = BLACK;
+    else return -1;
+
+    // Play the strong side as white: flip the board vertically when it is black
+    int flip = strong == WHITE ? 0 : 56;
+    int ci = COLOR_INDEX(strong);
+    for (int eg = 0; eg < ENDGAME_COUNT; eg++) {
+        const Endgame *e = &endgames[eg];
+        if (!tables[eg] || popcount(pos->by_color[ci]) != e->count + 1) continue;
+
+        int match = 1;
+        for (int i = 0; i < e->count && match; i++) {
+            Bitboard pieces = pieces_of(pos, strong, e->types[i]);
+            if (popcount(pieces) != 1) match = 0;
+            else p->sq[i] = lsb(pieces) ^ flip;
+        }
+        if (!match) continue;
+
+        p->stm = pos->side == strong ? 0 : 1;
+        p->wk = king_square(pos, strong) ^ flip;
+        p->bk = king_square(pos, OPPONENT(strong)) ^ flip;
+        return eg;
+    }
+    return -1;
+}
+
+// Function to check if a loaded bitbase covers the material of pos
+int bitbase_covers(const Position *pos) {
+    BitbaseIndex p;
+    return find_position(pos, &p) >= 0;
+}
+
+// Function to look up pos; returns 1 and sets *score (side to move's view) if a
+// loaded bitbase covers it. Positions with the side to move in check are left to
+// the search so it can still find the actual mates
+int bitbase_probe(const Position *pos, int *score) {
+    BitbaseIndex p;
+    if (pos->checkers) return 0;
+    int eg = find_position(pos, &p);
+    if (eg < 0) return 0;
+
+    if (!table_win(eg, encode_index(&endgames[eg], &p))) *score = 0;
+    else *score = p.stm == 0 ? win_score(&endgames[eg], &p) : -win_score(&endgames[eg], &p);
+    return 1;
+}
@@ -0,0 +1,28 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "position.h"
+
+// Score of a bitbase win before the bonuses that steer the search towards mate;
+// well above any evaluation and well below the mate scores
+#define VALUE_KNOWN_WIN 10000
+
+// Function to generate the KPK, KRK, KQK and KBNK bitbases into dir using the given
+// number of threads, leaving them loaded; returns 1 on success
+int bitbase_generate(const char *dir, int threads);
+
+// Function to map the bitbase files found in dir; returns the number of endgames loaded
+int bitbase_load(const char *dir);
+
+// Function to unmap every loaded bitbase
+void bitbase_free(void);
+
+// Function to check if a loaded bitbase covers the material of pos
+int bitbase_covers(const Position *pos);
+
+// Function to look up pos; returns 1 and sets *score (side to move's view) if a
+// loaded bitbase covers it. Positions with the side to move in check are left to
+// the search so it can still find the actual mates
+int bitbase_probe(const Position *pos, int *score);
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include "bitboard.h"
+
+Magic bishop_magics[64];
+Magic rook_magics[64];
+
+static Bitboard bishop_table[0x1480];
+static Bitboard rook_table[0x19000];
+
+static const int bishop_dirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+static const int rook_dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// Function to check if a row/col pair is on the board
+static int on_board(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+// Function to compute slider attacks by walking rays (only used while building tables)
+static Bitboard sliding_attacks(const int dirs[4][2], int sq, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int r = SQ_ROW(sq) + dirs[d][0];
+        int c = SQ_COL(sq) + dirs[d][1];
+        while (on_board(r, c)) {
+            attacks |= SQ_BB(SQUARE(r, c));
+            if (occupied & SQ_BB(SQUARE(r, c))) break;
+            r += dirs[d][0];
+            c += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+// Magic multipliers for the row * 8 + col square layout (a8 = 0). They were
+// found offline with a sparse random search; every subset of each mask maps
+// to a slot holding the correct attack set.
+static const Bitboard bishop_magic_numbers[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL,
+};
+
+static const Bitboard rook_magic_numbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+};
+
+// Function to fill the magic entries and attack table for one slider type
+static void init_magics(Magic magics[64], Bitboard *table, const Bitboard numbers[64], const int dirs[4][2]) {
+    Bitboard *next = table;
+
+    for (int sq = 0; sq < 64; sq++) {
+        Magic *m = &magics[sq];
+        // Edge squares never affect the attack set unless the slider sits on that edge
+        Bitboard edges = ((ROW_0_BB | ROW_7_BB) & ~(ROW_0_BB << (8 * SQ_ROW(sq))))
+                       | ((COL_A_BB | COL_H_BB) & ~(COL_A_BB << SQ_COL(sq)));
+        m->mask = sliding_attacks(dirs, sq, 0) & ~edges;
+        m->magic = numbers[sq];
+        m->shift = 64 - popcount(m->mask);
+        m->attacks = next;
+
+        // Enumerate every subset of the mask (Carry-Rippler)
+        Bitboard b = 0;
+        do {
+            m->attacks[magic_index(m, b)] = sliding_attacks(dirs, sq, b);
+            b = (b - m->mask) & m->mask;
+        } while (b);
+        next += 1ULL << popcount(m->mask);
+    }
+}
+
+// Function to build the slider attack tables; must run once before any lookup
+void init_bitboards(void) {
+    static int initialized = 0;
+
+    if (initialized) return;
+    initialized = 1;
+    init_magics(bishop_magics, bishop_table, bishop_magic_numbers, bishop_dirs);
+    init_magics(rook_magics, rook_table, rook_magic_numbers, rook_dirs);
+}
+
+// Function to print a bitboard as an 8x8 grid (debugging aid)
+void print_bitboard(Bitboard b) {
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            printf("%c ", (b & SQ_BB(SQUARE(r, c))) ? 'X' : '.');
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
@@ -0,0 +1,86 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "types.h"
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
+
+#define SQ_BB(sq) (1ULL << (sq))
+
+#define ROW_0_BB 0x00000000000000FFULL   // rank 8
+#define ROW_7_BB 0xFF00000000000000ULL   // rank 1
+#define COL_A_BB 0x0101010101010101ULL
+#define COL_H_BB 0x8080808080808080ULL
+
+// Magic (or PEXT) lookup entry for one slider square
+typedef struct {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    int shift;
+} Magic;
+
+// Fixed tables, generated at build time by gen_tables (attack_tables.c in the build tree)
+extern const Bitboard knight_attacks[64];
+extern const Bitboard king_attacks[64];
+extern const Bitboard pawn_attacks[2][64];
+extern const Bitboard between_bb[64][64];   // squares strictly between two aligned squares
+extern const Bitboard line_bb[64][64];      // the whole line through two aligned squares
+extern const uint8_t distance_table[64][64];  // king steps from one square to another
+
+extern Magic bishop_magics[64];
+extern Magic rook_magics[64];
+
+// Function to build the slider attack tables; must run once before any lookup
+void init_bitboards(void);
+
+// Function to print a bitboard as an 8x8 grid (debugging aid)
+void print_bitboard(Bitboard b);
+
+static inline int popcount(Bitboard b) {
+    return __builtin_popcountll(b);
+}
+
+static inline int lsb(Bitboard b) {
+    return __builtin_ctzll(b);
+}
+
+static inline int pop_lsb(Bitboard *b) {
+    int sq = __builtin_ctzll(*b);
+    *b &= *b - 1;
+    return sq;
+}
+
+static inline int square_distance(int a, int b) {
+    return distance_table[a][b];
+}
+
+static inline int more_than_one(Bitboard b) {
+    return (b & (b - 1)) != 0;
+}
+
+static inline unsigned magic_index(const Magic *m, Bitboard occupied) {
+#ifdef USE_PEXT
+    return (unsigned)_pext_u64(occupied, m->mask);
+#else
+    return (unsigned)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline Bitboard bishop_attacks(int sq, Bitboard occupied) {
+    const Magic *m = &bishop_magics[sq];
+    return m->attacks[magic_index(m, occupied)];
+}
+
+static inline Bitboard rook_attacks(int sq, Bitboard occupied) {
+    const Magic *m = &rook_magics[sq];
+    return m->attacks[magic_index(m, occupied)];
+}
+
+static inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+    return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "position.h"
+
+// Number of values in the Polyglot Random64 table
+#define POLYGLOT_RANDOM_COUNT 781
+
+// A Polyglot opening book mapped read-only into memory; entries are
+// 16 bytes, big-endian and sorted by key, so probing is a binary search
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t count;
+} Book;
+
+// Function to compute the Polyglot hash of a position
+uint64_t polyglot_key(const Position *pos);
+
+// Function to check the hashes of the Polyglot format's published test positions;
+// returns the number that differ
+int book_check_keys(void);
+
+// Function to map a Polyglot .bin book; returns 1 on success
+int book_open(Book *book, const char *path);
+
+// Function to unmap the book
+void book_close(Book *book);
+
+// Function to pick a book move for pos at random, weighted by the entries' weights;
+// returns MOVE_NONE if the position is not in the book
+Move book_probe(const Book *book, const Position *pos);
+
+// Function to print every book move for pos with its weight; returns the number found
+int book_print_moves(const Book *book, const Position *pos);
+
+#endif
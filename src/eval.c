@@ -0,0 +1,156 @@
+#include "eval.h"
+
+int psq_mg[24][64];
+int psq_eg[24][64];
+
+// Game phase contributed by each piece type; 24 is the full opening set
+const int phase_weight[7] = {0, 0, 1, 1, 2, 4, 0};
+
+static const int value_mg[7] = {0, 82, 337, 365, 477, 1025, 0};
+static const int value_eg[7] = {0, 94, 281, 297, 512, 936, 0};
+
+// Weight of the king distances to a passed pawn's stop square, by the pawn's rank
+static const int proximity_weight[8] = {0, 0, 0, 1, 2, 4, 6, 0};
+
+// Piece-square tables from White's point of view, rank 8 first like board[8][8]
+static const int pawn_mg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     60,  60,  60,  60,  60,  60,  60,  60,
+     15,  15,  25,  35,  35,  25,  15,  15,
+      5,   5,  12,  25,  25,  12,   5,   5,
+      0,   0,   8,  20,  20,   8,   0,   0,
+      5,  -3,  -5,   5,   5,  -5,  -3,   5,
+      5,  10,  10, -15, -15,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int pawn_eg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+    120, 120, 120, 120, 120, 120, 120, 120,
+     70,  70,  70,  70,  70,  70,  70,  70,
+     35,  35,  35,  35,  35,  35,  35,  35,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int knight_psq[64] = {
+    -50, -35, -25, -20, -20, -25, -35, -50,
+    -35, -15,   0,   5,   5,   0, -15, -35,
+    -25,   5,  15,  20,  20,  15,   5, -25,
+    -20,   5,  20,  25,  25,  20,   5, -20,
+    -20,   0,  15,  25,  25,  15,   0, -20,
+    -25,   5,  12,  15,  15,  12,   5, -25,
+    -35, -15,   0,   5,   5,   0, -15, -35,
+    -50, -30, -25, -20, -20, -25, -30, -50,
+};
+
+static const int bishop_psq[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+
+static const int rook_psq[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+
+static const int queen_psq[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+
+static const int king_mg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+
+static const int king_eg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+// Function to build the piece-square tables; must run before any position is set up
+void init_eval(void) {
+    const int *mg_tables[7] = {0, pawn_mg, knight_psq, bishop_psq, rook_psq, queen_psq, king_mg};
+    const int *eg_tables[7] = {0, pawn_eg, knight_psq, bishop_psq, rook_psq, queen_psq, king_eg};
+
+    for (int type = PAWN; type <= KING; type++) {
+        for (int sq = 0; sq < 64; sq++) {
+            // Black reads the table flipped vertically
+            psq_mg[WHITE | type][sq] = value_mg[type] + mg_tables[type][sq];
+            psq_eg[WHITE | type][sq] = value_eg[type] + eg_tables[type][sq];
+            psq_mg[BLACK | type][sq] = -(value_mg[type] + mg_tables[type][sq ^ 56]);
+            psq_eg[BLACK | type][sq] = -(value_eg[type] + eg_tables[type][sq ^ 56]);
+        }
+    }
+}
+
+// Function to score passed pawns by how much closer their stop square is to the enemy
+// king than to their own; this depends on the kings, so it is not cached with the pawns
+static int passed_king_proximity(const Position *pos, const PawnEntry *entry) {
+    int score = 0;
+    for (int ci = 0; ci < 2; ci++) {
+        int own_king = lsb(pos->by_color[ci] & pos->by_type[KING]);
+        int enemy_king = lsb(pos->by_color[ci ^ 1] & pos->by_type[KING]);
+        Bitboard b = entry->passed[ci];
+        while (b) {
+            int sq = pop_lsb(&b);
+            int rank = ci == 0 ? 7 - SQ_ROW(sq) : SQ_ROW(sq);
+            int stop = sq + (ci == 0 ? -8 : 8);
+            int bonus = proximity_weight[rank] * (5 * square_distance(enemy_king, stop) - 2 * square_distance(own_king, stop));
+            score += ci == 0 ? bonus : -bonus;
+        }
+    }
+    return score;
+}
+
+// Function to score the position from the side to move's point of view; pawn
+// structure comes from the given pawn table, or is recomputed when it is NULL
+int evaluate(const Position *pos, PawnTable *pawns) {
+    PawnEntry local;
+    const PawnEntry *entry;
+    if (pawns) {
+        entry = pawn_probe(pawns, pos);
+    } else {
+        pawn_evaluate(pos, &local);
+        entry = &local;
+    }
+
+    int mg = pos->psq_mg + entry->mg + entry->shield[0] - entry->shield[1];
+    int eg = pos->psq_eg + entry->eg + passed_king_proximity(pos, entry);
+    int phase = pos->phase < PHASE_MAX ? pos->phase : PHASE_MAX;
+    int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+    return (pos->side == WHITE ? score : -score) + TEMPO_BONUS;
+}
@@ -0,0 +1,23 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "position.h"
+#include "pawns.h"
+
+#define PHASE_MAX 24
+#define TEMPO_BONUS 10
+
+// Material plus piece-square values per piece code and square, signed so
+// that white pieces add and black pieces subtract
+extern int psq_mg[24][64];
+extern int psq_eg[24][64];
+extern const int phase_weight[7];
+
+// Function to build the piece-square tables; must run before any position is set up
+void init_eval(void);
+
+// Function to score the position from the side to move's point of view; pawn
+// structure comes from the given pawn table, or is recomputed when it is NULL
+int evaluate(const Position *pos, PawnTable *pawns);
+
+#endif
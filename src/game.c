@@ -0,0 +1,64 @@
+#include "game.h"
+#include "movegen.h"
+#include "search.h"
+
+// Function to start a game from a FEN string; returns 0 on a bad FEN
+int game_init(GameState *game, const char *fen) {
+    game->tail_count = 0;
+    game->ply = 0;
+    return fen_to_packed(fen, &game->base);
+}
+
+// Function to rebuild the current position, history included, into pos
+void game_position(const GameState *game, Position *pos) {
+    unpack_position(&game->base, pos);
+    for (int i = 0; i < game->tail_count; i++) make_move(pos, game->tail[i]);
+}
+
+// Function to play a legal move on pos, which must be the game's current position,
+// and record it in the game
+void game_play(GameState *game, Position *pos, Move move) {
+    make_move(pos, move);
+    game->ply++;
+
+    // Nothing before an irreversible move can repeat, so it becomes the new base;
+    // a full tail means the fifty-move rule has already ended the game
+    if (pos->halfmove == 0 || game->tail_count == GAME_MAX_TAIL) {
+        pack_position(pos, &game->base);
+        game->tail_count = 0;
+    } else {
+        game->tail[game->tail_count++] = move;
+    }
+}
+
+// Function to count the earlier occurrences of the current position
+int repetition_count(const Position *pos) {
+    int count = 0;
+    int end = pos->game_ply - pos->halfmove;
+    if (end < 0) end = 0;
+    for (int i = pos->game_ply - 2; i >= end; i -= 2) {
+        if (pos->history[i].key == pos->key) count++;
+    }
+    return count;
+}
+
+// Function to get the outcome of a position as a RESULT_* code; RESULT_UNKNOWN while
+// the game goes on (draws by threefold repetition, the fifty-move rule and material included)
+int game_result(const Position *pos) {
+    MoveList list;
+
+    generate_legal_moves(pos, &list);
+    if (list.count == 0) {
+        if (!in_check(pos)) return RESULT_DRAW;
+        return pos->side == WHITE ? RESULT_BLACK_WINS : RESULT_WHITE_WINS;
+    }
+    // The search calls a single repetition a draw; a game needs the third occurrence
+    if (pos->halfmove >= 100 || repetition_count(pos) >= 2 || is_insufficient_material(pos)) return RESULT_DRAW;
+    return RESULT_UNKNOWN;
+}
+
+// Function to format a RESULT_* code for the wire ("1-0", "0-1", "1/2-1/2", "*")
+const char *game_result_text(int result) {
+    static const char *texts[4] = {"0-1", "1/2-1/2", "1-0", "*"};
+    return texts[result & 3];
+}
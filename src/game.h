@@ -0,0 +1,40 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "position.h"
+#include "record.h"
+
+// Moves kept after the last irreversible one; enough for the fifty-move rule
+#define GAME_MAX_TAIL 128
+
+// Self-contained state of one game, small enough to keep thousands in memory: the
+// position after the last capture or pawn move, packed, and the moves played since,
+// which are all a repetition can reach. The full position is rebuilt on demand
+typedef struct {
+    PackedPosition base;
+    Move tail[GAME_MAX_TAIL];
+    int tail_count;
+    int ply;                  // plies played since the game started
+} GameState;
+
+// Function to start a game from a FEN string; returns 0 on a bad FEN
+int game_init(GameState *game, const char *fen);
+
+// Function to rebuild the current position, history included, into pos
+void game_position(const GameState *game, Position *pos);
+
+// Function to play a legal move on pos, which must be the game's current position,
+// and record it in the game
+void game_play(GameState *game, Position *pos, Move move);
+
+// Function to count the earlier occurrences of the current position
+int repetition_count(const Position *pos);
+
+// Function to get the outcome of a position as a RESULT_* code; RESULT_UNKNOWN while
+// the game goes on (draws by threefold repetition, the fifty-move rule and material included)
+int game_result(const Position *pos);
+
+// Function to format a RESULT_* code for the wire ("1-0", "0-1", "1/2-1/2", "*")
+const char *game_result_text(int result);
+
+#endif
@@ -0,0 +1,116 @@
+// Build-time generator for the fixed board tables: leaper attacks, the squares between
+// and the whole line through two aligned squares, and square distances. It writes a C
+// file defining the tables bitboard.h declares, so they sit in read-only data and cost
+// nothing at start-up. Usage: gen_tables <output.c>
+#include <stdio.h>
+#include <stdlib.h>
+#include "types.h"
+
+#define SQ_BB(sq) (1ULL << (sq))
+
+static Bitboard knight[64], king[64], pawn[2][64];
+static Bitboard between[64][64], line[64][64];
+static int distance[64][64];
+
+// Function to check if a row/col pair is on the board
+static int on_board(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+// Function to compute leaper attacks from a list of offsets
+static Bitboard leaper_attacks(int sq, const int offsets[][2], int count) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < count; i++) {
+        int r = SQ_ROW(sq) + offsets[i][0];
+        int c = SQ_COL(sq) + offsets[i][1];
+        if (on_board(r, c)) attacks |= SQ_BB(SQUARE(r, c));
+    }
+    return attacks;
+}
+
+// Function to fill every table by walking the board
+static void build_tables(void) {
+    static const int knight_offsets[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+    static const int king_offsets[8][2] = {{1, 1}, {1, 0}, {1, -1}, {0, 1}, {0, -1}, {-1, 1}, {-1, 0}, {-1, -1}};
+    static const int white_pawn_offsets[2][2] = {{-1, -1}, {-1, 1}};
+    static const int black_pawn_offsets[2][2] = {{1, -1}, {1, 1}};
+
+    for (int sq = 0; sq < 64; sq++) {
+        knight[sq] = leaper_attacks(sq, knight_offsets, 8);
+        king[sq] = leaper_attacks(sq, king_offsets, 8);
+        pawn[0][sq] = leaper_attacks(sq, white_pawn_offsets, 2);
+        pawn[1][sq] = leaper_attacks(sq, black_pawn_offsets, 2);
+
+        for (int to = 0; to < 64; to++) {
+            int dr = abs(SQ_ROW(sq) - SQ_ROW(to)), dc = abs(SQ_COL(sq) - SQ_COL(to));
+            distance[sq][to] = dr > dc ? dr : dc;
+        }
+
+        // Along each of the eight directions: the line is the whole ray both ways, and
+        // the squares between grow by one square per step
+        for (int d = 0; d < 8; d++) {
+            int r_step = king_offsets[d][0], c_step = king_offsets[d][1];
+            Bitboard full = SQ_BB(sq), path = 0;
+
+            for (int r = SQ_ROW(sq) + r_step, c = SQ_COL(sq) + c_step; on_board(r, c); r += r_step, c += c_step) {
+                full |= SQ_BB(SQUARE(r, c));
+            }
+            for (int r = SQ_ROW(sq) - r_step, c = SQ_COL(sq) - c_step; on_board(r, c); r -= r_step, c -= c_step) {
+                full |= SQ_BB(SQUARE(r, c));
+            }
+            for (int r = SQ_ROW(sq) + r_step, c = SQ_COL(sq) + c_step; on_board(r, c); r += r_step, c += c_step) {
+                between[sq][SQUARE(r, c)] = path;
+                line[sq][SQUARE(r, c)] = full;
+                path |= SQ_BB(SQUARE(r, c));
+            }
+        }
+    }
+}
+
+// Function to write one table of bitboards, four to a line
+static void write_bitboards(FILE *out, const Bitboard *values, int count, const char *indent) {
+    for (int i = 0; i < count; i++) {
+        if (i % 4 == 0) fprintf(out, "%s", indent);
+        fprintf(out, "0x%016llXULL,%s", (unsigned long long)values[i], i % 4 == 3 ? "\n" : " ");
+    }
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    FILE *out;
+
+    if (argc != 2 || !(out = fopen(argv[1], "w"))) {
+        fprintf(stderr, "Usage: gen_tables <output.c>\n");
+        return 1;
+    }
+    build_tables();
+
+    fprintf(out, "// Generated by gen_tables at build time; do not edit\n#include \"bitboard.h\"\n\n");
+    fprintf(out, "const Bitboard knight_attacks[64] = {\n");
+    write_bitboards(out, knight, 64, "    ");
+    fprintf(out, "};\n\nconst Bitboard king_attacks[64] = {\n");
+    write_bitboards(out, king, 64, "    ");
+    fprintf(out, "};\n\nconst Bitboard pawn_attacks[2][64] = {\n");
+    for (int ci = 0; ci < 2; ci++) {
+        fprintf(out, "    {\n");
+        write_bitboards(out, pawn[ci], 64, "        ");
+        fprintf(out, "    },\n");
+    }
+    const char *names[2] = {"between_bb", "line_bb"};
+    for (int t = 0; t < 2; t++) {
+        fprintf(out, "};\n\nconst Bitboard %s[64][64] = {\n", names[t]);
+        for (int sq = 0; sq < 64; sq++) {
+            fprintf(out, "    {\n");
+            write_bitboards(out, t == 0 ? between[sq] : line[sq], 64, "        ");
+            fprintf(out, "    },\n");
+        }
+    }
+    fprintf(out, "};\n\nconst uint8_t distance_table[64][64] = {\n");
+    for (int sq = 0; sq < 64; sq++) {
+        fprintf(out, "    {");
+        for (int to = 0; to < 64; to++) fprintf(out, "%d%s", distance[sq][to], to < 63 ? ", " : "");
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n");
+    return fclose(out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "legacy.h"
+#include "movegen.h"
+#include "search.h"
+
+int board[8][8] = {
+    {BLACK_ROOK, BLACK_KNIGHT, BLACK_BISHOP, BLACK_QUEEN, BLACK_KING, BLACK_BISHOP, BLACK_KNIGHT, BLACK_ROOK},
+    {BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN},
+    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
+    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
+    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
+    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
+    {WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN},
+    {WHITE_ROOK, WHITE_KNIGHT, WHITE_BISHOP, WHITE_QUEEN, WHITE_KING, WHITE_BISHOP, WHITE_KNIGHT, WHITE_ROOK}
+};
+
+// Game state; board[8][8] mirrors it for printing and the move predicates
+Position game;
+
+// Function to print the chessboard
+void print_board() {
+    printf("  0 1 2 3 4 5 6 7\n");
+    printf("  ---------------\n");
+    for (int r = 0; r < 8; r++) {
+        printf("%d |",  r);
+        for (int c = 0; c < 8; c++) {
+            int piece = board[r][c];
+            switch (piece) {
+              case EMPTY: printf(". "); break;
+                case WHITE_PAWN: printf("♟ "); break;
+                case WHITE_KNIGHT: printf("♞ "); break;
+                case WHITE_BISHOP: printf("♝ "); break;
+                case WHITE_ROOK: printf("♜ "); break;
+                case WHITE_QUEEN: printf("♛ "); break;
+                case WHITE_KING: printf("♚ "); break;
+                case BLACK_PAWN: printf("♙ "); break;
+                case BLACK_KNIGHT: printf("♘ "); break;
+                case BLACK_BISHOP: printf("♗ "); break;
+                case BLACK_ROOK: printf("♖ "); break;
+                case BLACK_QUEEN: printf("♕ "); break;
+                case BLACK_KING: printf("♔ "); break;
+                default: printf("? "); break;
+            }
+        }
+        printf("\n");
+    }
+}
+               
+// Function to check if a square is a valid position on the board
+int is_valid_square(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+// Function to check if a square is empty
+int is_square_empty(int r, int c) {
+    return is_valid_square(r, c) && board[r][c] == EMPTY;
+}
+
+// Function to check if a square contains an opponent's piece
+int is_opponent_piece(int r, int c, int color) {
+    return is_valid_square(r, c) && (board[r][c] & color) == 0 && board[r][c] != EMPTY;
+}
+
+// Function to read board[8][8] by square number
+static inline int board_at(int sq) {
+    return board[SQ_ROW(sq)][SQ_COL(sq)];
+}
+
+// Function to check if no piece stands on any square of a mask
+static inline int board_empty_on(Bitboard squares) {
+    while (squares) {
+        if (board_at(pop_lsb(&squares)) != EMPTY) return 0;
+    }
+    return 1;
+}
+
+// The predicates below take on-board squares and are table lookups: no bounds checks
+// and no direction loops. A target square is free for color when it holds no piece of it
+
+// Function to check if a pawn move is legal
+int is_legal_pawn_move(int sr, int sc, int dr, int dc) {
+    int from = SQUARE(sr, sc), to = SQUARE(dr, dc);
+    int black = (board_at(from) & BLACK) != 0;
+    int up = black ? 8 : -8;
+
+    if (dc == sc && board_at(to) == EMPTY) {
+        if (to == from + up) return 1;  // Single move
+        return sr == (black ? 1 : 6) && to == from + 2 * up && board_at(from + up) == EMPTY;  // Double move
+    }
+    // Capture; the target must hold a piece without the opponent's color bit
+    return (pawn_attacks[black][from] & SQ_BB(to)) && board_at(to) != EMPTY && !(board_at(to) & (black ? WHITE : BLACK));
+}
+
+// Function to check if a knight move is legal
+int is_legal_knight_move(int sr, int sc, int dr, int dc, int color) {
+    int to = SQUARE(dr, dc);
+    return (knight_attacks[SQUARE(sr, sc)] & SQ_BB(to)) && !(board_at(to) & color);
+}
+
+// Function to check if a bishop move is legal
+int is_legal_bishop_move(int sr, int sc, int dr, int dc, int color) {
+    int from = SQUARE(sr, sc), to = SQUARE(dr, dc);
+    // Diagonal neighbours share a line but no row or column
+    return line_bb[from][to] && sr != dr && sc != dc && board_empty_on(between_bb[from][to]) && !(board_at(to) & color);
+}
+
+// Function to check if a rook move is legal
+int is_legal_rook_move(int sr, int sc, int dr, int dc, int color) {
+    int from = SQUARE(sr, sc), to = SQUARE(dr, dc);
+    return (sr == dr || sc == dc) && from != to && board_empty_on(between_bb[from][to]) && !(board_at(to) & color);
+}
+
+// Function to check if a queen move is legal
+int is_legal_queen_move(int sr, int sc, int dr, int dc, int color) {
+    int from = SQUARE(sr, sc), to = SQUARE(dr, dc);
+    return line_bb[from][to] && board_empty_on(between_bb[from][to]) && !(board_at(to) & color);
+}
+
+// Function to check if a king move is legal
+int is_legal_king_move(int sr, int sc, int dr, int dc, int color) {
+    int to = SQUARE(dr, dc);
+    return (king_attacks[SQUARE(sr, sc)] & SQ_BB(to)) && !(board_at(to) & color);
+}
+
+// Function to check if neither side has enough material left to ever mate
+// (bare kings, a single minor piece, or only bishops all on one square color)
+int is_draw_by_insufficient_material() {
+    return is_insufficient_material(&game);
+}
+
+// Function to check if the specified king is in check
+int is_in_check(int king_row, int king_col, int color) {
+    return is_square_attacked(&game, SQUARE(king_row, king_col), OPPONENT(color));
+}
+
+// Function to check if the specified color is in checkmate
+int is_checkmate(int color) {
+    Position pos;
+    MoveList list;
+    position_from_board(&pos, board, color);
+    generate_legal_moves(&pos, &list);
+    return list.count == 0 && in_check(&pos);
+}
+
+// Function to check if the specified color is in stalemate
+int is_stalemate(int color) {
+    Position pos;
+    MoveList list;
+    position_from_board(&pos, board, color);
+    generate_legal_moves(&pos, &list);
+    return list.count == 0 && !in_check(&pos);
+}
@@ -0,0 +1,42 @@
+#ifndef LEGACY_H
+#define LEGACY_H
+
+#include "position.h"
+
+// The interactive game: an 8x8 array of piece codes, row 0 at the top (Black's
+// back rank), kept in step with the engine position it was built from
+extern int board[8][8];
+extern Position game;
+
+// Function to print the chessboard
+void print_board();
+
+// Function to check if a square is a valid position on the board
+int is_valid_square(int r, int c);
+
+// Function to check if a square is empty
+int is_square_empty(int r, int c);
+
+// Function to check if a square contains an opponent's piece
+int is_opponent_piece(int r, int c, int color);
+
+// Functions to check if a piece move on board is legal, ignoring pins and checks;
+// color is the mover's color, the pawn's is read from the board
+int is_legal_pawn_move(int sr, int sc, int dr, int dc);
+int is_legal_knight_move(int sr, int sc, int dr, int dc, int color);
+int is_legal_bishop_move(int sr, int sc, int dr, int dc, int color);
+int is_legal_rook_move(int sr, int sc, int dr, int dc, int color);
+int is_legal_queen_move(int sr, int sc, int dr, int dc, int color);
+int is_legal_king_move(int sr, int sc, int dr, int dc, int color);
+
+// Function to check if neither side has enough material left to ever mate
+int is_draw_by_insufficient_material();
+
+// Function to check if the specified king is in check (in the game position)
+int is_in_check(int king_row, int king_col, int color);
+
+// Functions to check if the specified color is mated or stalemated on board
+int is_checkmate(int color);
+int is_stalemate(int color);
+
+#endif
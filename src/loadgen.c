@@ -0,0 +1,420 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "server.h"
+#include "game.h"
+#include "misc.h"
+
+#define LOAD_INPUT 65536
+#define LOAD_MAX_PLIES 200        // longer games are closed and replaced
+#define LOAD_DRAIN_MS 10000       // wait this long for the last replies
+#define LOAD_EVENTS 64
+
+// One synthetic game as the client sees it
+typedef struct {
+    GameState state;
+    int id;                   // server id; -1 while waiting for "game"
+    int connection;
+    int64_t sent_ns;
+    int64_t ready_ns;         // when the client's next move is due
+} LoadGame;
+
+// One non-blocking connection and the games whose "new" it is still waiting on, oldest first
+typedef struct {
+    int fd;
+    uint32_t events;          // epoll events currently registered
+    char in[LOAD_INPUT];
+    size_t in_used;
+    char *out;
+    size_t out_used, out_sent, out_size;
+    int *pending_new;
+    int pending_head, pending_count, pending_size;
+} LoadConnection;
+
+typedef struct {
+    const LoadSettings *settings;
+    LoadGame *games;
+    LoadConnection *connections;
+    int *by_id;               // local game index per server id, -1 if none
+    int by_id_size;
+    int *thinking;            // games waiting out the think time, a min-heap on ready_ns
+    int thinking_count;
+    int32_t *latency_us;
+    size_t latency_count, latency_size;
+    uint64_t finished, errors, in_flight;
+    int running;
+    uint64_t rng;
+    Position pos;
+    char stats[256];          // last stats reply
+} Load;
+
+// Function to get the next pseudo-random number (xorshift64*)
+static uint64_t next_random(Load *load) {
+    load->rng ^= load->rng >> 12;
+    load->rng ^= load->rng << 25;
+    load->rng ^= load->rng >> 27;
+    return load->rng * 2685821657736338717ULL;
+}
+
+// Function to queue a request line on a connection; flush_connections sends it
+static void queue_line(LoadConnection *c, const char *line) {
+    size_t length = strlen(line);
+    if (c->out_used + length > c->out_size && c->out_sent) {
+        // Drop what the socket already took before growing the buffer
+        memmove(c->out, c->out + c->out_sent, c->out_used - c->out_sent);
+        c->out_used -= c->out_sent;
+        c->out_sent = 0;
+    }
+    if (c->out_used + length > c->out_size) {
+        c->out_size = c->out_size ? 2 * c->out_size + length : 4096 + length;
+        c->out = realloc(c->out, c->out_size);
+        if (!c->out) exit(1);
+    }
+    memcpy(c->out + c->out_used, line, length);
+    c->out_used += length;
+}
+
+// Function to send as much queued output as every connection's socket takes. What is
+// left waits for EPOLLOUT, so a server that stops reading cannot block the replies
+static int flush_connections(Load *load, int epoll_fd) {
+    for (int i = 0; i < load->settings->connections; i++) {
+        LoadConnection *c = &load->connections[i];
+        while (c->out_sent < c->out_used) {
+            ssize_t n = send(c->fd, c->out + c->out_sent, c->out_used - c->out_sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0) {
+                perror("send");
+                return 0;
+            }
+            c->out_sent += (size_t)n;
+        }
+        if (c->out_sent == c->out_used) c->out_sent = c->out_used = 0;
+
+        uint32_t events = EPOLLIN | (c->out_used ? EPOLLOUT : 0);
+        if (events != c->events) {
+            struct epoll_event ev = {.events = events, .data.ptr = c};
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+            c->events = events;
+        }
+    }
+    return 1;
+}
+
+// Function to ask for a new game for local game i
+static void request_game(Load *load, int i) {
+    LoadConnection *c = &load->connections[load->games[i].connection];
+    if (c->pending_count == c->pending_size) {
+        // Never more pending than the games on the connection, so this only happens at start
+        int size = c->pending_size ? 2 * c->pending_size : 64;
+        int *ring = malloc(size * sizeof(int));
+        for (int k = 0; k < c->pending_count; k++) ring[k] = c->pending_new[(c->pending_head + k) % c->pending_size];
+        free(c->pending_new);
+        c->pending_new = ring;
+        c->pending_head = 0;
+        c->pending_size = size;
+    }
+    c->pending_new[(c->pending_head + c->pending_count++) % c->pending_size] = i;
+    load->games[i].id = -1;
+    queue_line(c, "new\n");
+}
+
+// Function to play a random legal move for the client and send it
+static void send_move(Load *load, int i) {
+    LoadGame *g = &load->games[i];
+    MoveList list;
+    char line[64], text[6];
+
+    game_position(&g->state, &load->pos);
+    generate_legal_moves(&load->pos, &list);
+    Move move = list.moves[next_random(load) % (uint64_t)list.count];
+    game_play(&g->state, &load->pos, move);
+    move_to_uci(move, text);
+    snprintf(line, sizeof(line), "move %d %s\n", g->id, text);
+    queue_line(&load->connections[g->connection], line);
+    g->sent_ns = now_ns();
+    load->in_flight++;
+}
+
+// Function to schedule the client's next move after a think time drawn uniformly from
+// half to one and a half times the setting, so the games do not move in lockstep
+static void schedule_move(Load *load, int i) {
+    if (!load->running) return;
+    if (load->settings->think_ms <= 0) {
+        send_move(load, i);
+        return;
+    }
+    int64_t think = (int64_t)load->settings->think_ms * 1000000;
+    load->games[i].ready_ns = now_ns() + think / 2 + (int64_t)(next_random(load) % (uint64_t)think);
+
+    // Sift up
+    int k = load->thinking_count++;
+    while (k > 0 && load->games[load->thinking[(k - 1) / 2]].ready_ns > load->games[i].ready_ns) {
+        load->thinking[k] = load->thinking[(k - 1) / 2];
+        k = (k - 1) / 2;
+    }
+    load->thinking[k] = i;
+}
+
+// Function to take the game due first off the heap
+static void pop_thinking(Load *load) {
+    int last = load->thinking[--load->thinking_count];
+    int k = 0;
+
+    // Sift the last entry down from the root
+    for (;;) {
+        int child = 2 * k + 1;
+        if (child >= load->thinking_count) break;
+        if (child + 1 < load->thinking_count &&
+            load->games[load->thinking[child + 1]].ready_ns < load->games[load->thinking[child]].ready_ns) child++;
+        if (load->games[load->thinking[child]].ready_ns >= load->games[last].ready_ns) break;
+        load->thinking[k] = load->thinking[child];
+        k = child;
+    }
+    load->thinking[k] = last;
+}
+
+// Function to send the moves whose think time is over; returns ms until the next is due
+static int send_due_moves(Load *load) {
+    int64_t now = now_ns();
+
+    while (load->thinking_count) {
+        int i = load->thinking[0];
+        if (load->games[i].ready_ns > now) return (int)((load->games[i].ready_ns - now) / 1000000) + 1;
+        pop_thinking(load);
+        if (load->running) send_move(load, i);
+    }
+    return 100;
+}
+
+// Function to close the game with this server id and start another in its place
+static void replace_game(Load *load, int id) {
+    int i = load->by_id[id];
+    char line[32];
+
+    load->by_id[id] = -1;
+    snprintf(line, sizeof(line), "close %d\n", id);
+    queue_line(&load->connections[load->games[i].connection], line);
+    if (load->running) request_game(load, i);
+}
+
+// Function to handle a "bestmove <id> <move> <result>" reply
+static void handle_bestmove(Load *load, int id, const char *move, const char *result) {
+    if (id < 0 || id >= load->by_id_size || load->by_id[id] < 0) return;
+    int i = load->by_id[id];
+    LoadGame *g = &load->games[i];
+
+    if (load->latency_count == load->latency_size) {
+        load->latency_size = load->latency_size ? 2 * load->latency_size : 65536;
+        load->latency_us = realloc(load->latency_us, load->latency_size * sizeof(int32_t));
+        if (!load->latency_us) exit(1);
+    }
+    load->latency_us[load->latency_count++] = (int32_t)((now_ns() - g->sent_ns) / 1000);
+    load->in_flight--;
+
+    if (strcmp(move, "0000") != 0) {
+        game_position(&g->state, &load->pos);
+        Move reply = parse_uci_move(&load->pos, move);
+        if (reply == MOVE_NONE) {
+            load->errors++;
+            replace_game(load, id);
+            return;
+        }
+        game_play(&g->state, &load->pos, reply);
+    }
+
+    if (strcmp(result, "*") != 0 || g->state.ply >= LOAD_MAX_PLIES) {
+        load->finished++;
+        replace_game(load, id);
+        return;
+    }
+    schedule_move(load, i);
+}
+
+// Function to handle one reply line from a connection
+static void handle_reply(Load *load, LoadConnection *c, char *line) {
+    char *save = NULL;
+    char *kind = strtok_r(line, " ", &save);
+    char *first = strtok_r(NULL, " ", &save);
+
+    if (!kind) return;
+    if (strcmp(kind, "game") == 0 && first && c->pending_count) {
+        int i = c->pending_new[c->pending_head];
+        int id = atoi(first);
+        c->pending_head = (c->pending_head + 1) % c->pending_size;
+        c->pending_count--;
+        if (id >= load->by_id_size) {
+            int size = load->by_id_size ? load->by_id_size : 1024;
+            while (size <= id) size *= 2;
+            load->by_id = realloc(load->by_id, size * sizeof(int));
+            for (int k = load->by_id_size; k < size; k++) load->by_id[k] = -1;
+            load->by_id_size = size;
+        }
+        load->by_id[id] = i;
+        load->games[i].id = id;
+        game_init(&load->games[i].state, START_FEN);
+        schedule_move(load, i);
+    } else if (strcmp(kind, "bestmove") == 0 && first) {
+        char *move = strtok_r(NULL, " ", &save);
+        char *result = strtok_r(NULL, " ", &save);
+        if (move && result) handle_bestmove(load, atoi(first), move, result);
+    } else if (strcmp(kind, "stats") == 0) {
+        snprintf(load->stats, sizeof(load->stats), "%s %s", first ? first : "", save ? save : "");
+    } else if (strcmp(kind, "error") == 0) {
+        if (load->errors++ < 5) printf("Server error: %s %s\n", first ? first : "", save ? save : "");
+        // A failed new gives up its place in the queue; a failed move ends the wait for it,
+        // and the game is replaced so the load stays at the requested number of games
+        if (first && strcmp(first, "-") == 0 && c->pending_count) {
+            c->pending_head = (c->pending_head + 1) % c->pending_size;
+            c->pending_count--;
+        } else if (first && strcmp(first, "-") != 0) {
+            int id = atoi(first);
+            if (id >= 0 && id < load->by_id_size && load->by_id[id] >= 0) {
+                load->in_flight--;
+                replace_game(load, id);
+            }
+        }
+    }
+}
+
+// Function to read and handle every complete reply line waiting on a connection; returns 0 if it closed
+static int read_replies(Load *load, LoadConnection *c) {
+    for (;;) {
+        ssize_t n = recv(c->fd, c->in + c->in_used, sizeof(c->in) - c->in_used, MSG_DONTWAIT);
+        if (n == 0) return 0;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        size_t start = 0;
+        c->in_used += (size_t)n;
+        for (size_t i = c->in_used - (size_t)n; i < c->in_used; i++) {
+            if (c->in[i] != '\n') continue;
+            c->in[i] = '\0';
+            handle_reply(load, c, c->in + start);
+            start = i + 1;
+        }
+        memmove(c->in, c->in + start, c->in_used - start);
+        c->in_used -= start;
+    }
+}
+
+// Function to handle replies until the deadline, or until done says to stop; returns 0 on a lost connection
+static int pump(Load *load, int epoll_fd, int64_t deadline, int (*done)(const Load *)) {
+    struct epoll_event events[LOAD_EVENTS];
+
+    while (now_ms() < deadline && !(done && done(load))) {
+        int wait = send_due_moves(load);
+        if (!flush_connections(load, epoll_fd)) return 0;
+        int64_t left = deadline - now_ms();
+        if (wait > left) wait = left > 0 ? (int)left : 0;
+
+        int n = epoll_wait(epoll_fd, events, LOAD_EVENTS, wait);
+        for (int i = 0; i < n; i++) {
+            LoadConnection *c = events[i].data.ptr;
+            // Writable sockets are flushed at the top of the loop
+            if (events[i].events == EPOLLOUT) continue;
+            if (!read_replies(load, c)) {
+                printf("Server closed the connection\n");
+                return 0;
+            }
+        }
+    }
+    return flush_connections(load, epoll_fd);
+}
+
+// Function to tell when every outstanding move has been answered
+static int drained(const Load *load) {
+    return load->in_flight == 0;
+}
+
+// Function to tell when a stats reply has arrived
+static int have_stats(const Load *load) {
+    return load->stats[0] != '\0';
+}
+
+// Function to ask the server for its counters: workers, search time and moves searched
+static int server_stats(Load *load, int epoll_fd, int *workers, int64_t *busy_ms, uint64_t *jobs) {
+    load->stats[0] = '\0';
+    queue_line(&load->connections[0], "stats\n");
+    if (!pump(load, epoll_fd, now_ms() + LOAD_DRAIN_MS, have_stats) || !have_stats(load)) return 0;
+    return sscanf(load->stats, "workers %d games %*d jobs %" SCNu64 " busy_ms %" SCNd64, workers, jobs, busy_ms) == 3;
+}
+
+// Function to load a running server with synthetic games and report move latency
+// percentiles and throughput per core; returns the process exit code
+int run_load_generator(const LoadSettings *settings) {
+    static Load load;
+    int epoll_fd = epoll_create1(0);
+    int workers = 0, workers_end = 0;
+    int64_t busy_start = 0, busy_end = 0;
+    uint64_t jobs_start = 0, jobs_end = 0;
+
+    load.settings = settings;
+    load.rng = 0x9E3779B97F4A7C15ULL;
+    load.games = calloc((size_t)settings->games, sizeof(LoadGame));
+    load.thinking = calloc((size_t)settings->games, sizeof(int));
+    load.connections = calloc((size_t)settings->connections, sizeof(LoadConnection));
+    if (!load.games || !load.thinking || !load.connections || epoll_fd < 0) return 1;
+
+    for (int i = 0; i < settings->connections; i++) {
+        LoadConnection *c = &load.connections[i];
+        c->fd = server_socket(settings->address, 0);
+        if (c->fd < 0) return 1;
+        fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+        c->events = EPOLLIN;
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+    }
+    if (!server_stats(&load, epoll_fd, &workers, &busy_start, &jobs_start)) {
+        printf("No stats reply from %s\n", settings->address);
+        return 1;
+    }
+
+    printf("%d games over %d connections for %d s, think time %d ms\n", settings->games, settings->connections,
+           settings->seconds, settings->think_ms);
+    int64_t start = now_ms();
+    load.running = 1;
+    for (int i = 0; i < settings->games; i++) {
+        load.games[i].connection = i % settings->connections;
+        request_game(&load, i);
+    }
+    if (!pump(&load, epoll_fd, start + settings->seconds * 1000LL, NULL)) return 1;
+
+    // Stop making moves and collect the answers still on their way
+    load.running = 0;
+    if (!pump(&load, epoll_fd, now_ms() + LOAD_DRAIN_MS, drained)) return 1;
+    double seconds = (now_ms() - start) / 1000.0;
+    if (!server_stats(&load, epoll_fd, &workers_end, &busy_end, &jobs_end)) return 1;
+
+    size_t moves = load.latency_count;
+    double busy = (busy_end - busy_start) / 1000.0;
+    uint64_t jobs = jobs_end - jobs_start;
+    printf("Moves: %zu (%.0f per second), games finished: %" PRIu64 ", errors: %" PRIu64 "\n", moves,
+           moves / seconds, load.finished, load.errors);
+    printf("Latency: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           percentile_int32(load.latency_us, moves, 50) / 1000.0, percentile_int32(load.latency_us, moves, 90) / 1000.0,
+           percentile_int32(load.latency_us, moves, 99) / 1000.0, percentile_int32(load.latency_us, moves, 100) / 1000.0);
+    printf("Server: %d workers, %.1f%% busy, %.2f ms of search per move\n", workers,
+           100.0 * busy / (seconds * workers), jobs ? 1000.0 * busy / jobs : 0.0);
+    printf("Per core: %.0f moves per busy second, %.1f concurrent games, %.0f finished games per hour\n",
+           busy > 0 ? jobs / busy : 0.0, (double)settings->games / workers,
+           load.finished * 3600.0 / seconds / workers);
+
+    for (int i = 0; i < settings->connections; i++) {
+        close(load.connections[i].fd);
+        free(load.connections[i].out);
+        free(load.connections[i].pending_new);
+    }
+    close(epoll_fd);
+    free(load.connections);
+    free(load.games);
+    free(load.thinking);
+    free(load.by_id);
+    free(load.latency_us);
+    return 0;
+}
@@ -1,758 +1,493 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
-
-#define EMPTY 0
-#define PAWN 1
-#define KNIGHT 2
-#define BISHOP 3
-#define ROOK 4
-#define QUEEN 5
-#define KING 6
-
-#define WHITE 8
-#define BLACK 16
-
-#define WHITE_PAWN (WHITE | PAWN)
-#define WHITE_KNIGHT (WHITE | KNIGHT)
-#define WHITE_BISHOP (WHITE | BISHOP)
-#define WHITE_ROOK (WHITE | ROOK)
-#define WHITE_QUEEN (WHITE | QUEEN)
-#define WHITE_KING (WHITE | KING)
-
-#define BLACK_PAWN (BLACK | PAWN)
-#define BLACK_KNIGHT (BLACK | KNIGHT)
-#define BLACK_BISHOP (BLACK | BISHOP)
-#define BLACK_ROOK (BLACK | ROOK)
-#define BLACK_QUEEN (BLACK | QUEEN)
-#define BLACK_KING (BLACK | KING)
-
-int board[8][8] = {
-    {BLACK_ROOK, BLACK_KNIGHT, BLACK_BISHOP, BLACK_QUEEN, BLACK_KING, BLACK_BISHOP, BLACK_KNIGHT, BLACK_ROOK},
-    {BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN, BLACK_PAWN},
-    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-    {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
-    {WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN, WHITE_PAWN},
-    {WHITE_ROOK, WHITE_KNIGHT, WHITE_BISHOP, WHITE_QUEEN, WHITE_KING, WHITE_BISHOP, WHITE_KNIGHT, WHITE_ROOK}
-};
-
-// Function to print the chessboard
-void print_board() {
-    printf("  0 1 2 3 4 5 6 7\n");
-    printf("  ---------------\n");
-    for (int r = 0; r < 8; r++) {
-        printf("%d |",  r);
-        for (int c = 0; c < 8; c++) {
-            int piece = board[r][c];
-            switch (piece) {
-              case EMPTY: printf(". "); break;
-                case WHITE_PAWN: printf("♟ "); break;
-                case WHITE_KNIGHT: printf("♞ "); break;
-                case WHITE_BISHOP: printf("♝ "); break;
-                case WHITE_ROOK: printf("♜ "); break;
-                case WHITE_QUEEN: printf("♛ "); break;
-                case WHITE_KING: printf("♚ "); break;
-                case BLACK_PAWN: printf("♙ "); break;
-                case BLACK_KNIGHT: printf("♘ "); break;
-                case BLACK_BISHOP: printf("♗ "); break;
-                case BLACK_ROOK: printf("♖ "); break;
-                case BLACK_QUEEN: printf("♕ "); break;
-                case BLACK_KING: printf("♔ "); break;
-                default: printf("? "); break;
-            }
-        }
-        printf("\n");
+#include <unistd.h>
+#include "position.h"
+#include "movegen.h"
+#include "perft.h"
+#include "misc.h"
+#include "search.h"
+#include "eval.h"
+#include "smp.h"
+#include "bench.h"
+#include "batch.h"
+#include "uci.h"
+#include "book.h"
+#include "bitbase.h"
+#include "tournament.h"
+#include "record.h"
+#include "legacy.h"
+#include "server.h"
+#include "pgn.h"
+
+#define AI_MOVE_TIME_MS 1000
+
+// Transposition table shared by every search in this process
+TranspositionTable tt;
+size_t hash_mb = TT_DEFAULT_MB;
+
+// Search threads used for the AI's moves
+SearchPool pool;
+int thread_count = 1;
+
+// Opening book consulted before searching; empty unless --book was given
+Book book;
+const char *book_path = NULL;
+
+// Directory of endgame bitbases used by every search; none unless --bitbases was given
+const char *bitbase_dir = NULL;
+
+// JSON Lines file receiving the search counters (per search, or per batch); none by default
+FILE *stats_json = NULL;
+
+// Function for the user's move; returns 1 once a legal move has been played
+int make_user_move() {
+    int sr, sc, dr, dc;
+    printf("Enter your move (source_row source_col dest_row dest_col): ");
+    if (scanf("%d %d %d %d", &sr, &sc, &dr, &dc) != 4) {
+        if (feof(stdin)) exit(0);
+        while (getchar() != '\n');
+        printf("Invalid input.\n");
+        return 0;
     }
-}
-               
-// Function to check if a square is a valid position on the board
-int is_valid_square(int r, int c) {
-    return r >= 0 && r < 8 && c >= 0 && c < 8;
-}
 
-// Function to check if a square is empty
-int is_square_empty(int r, int c) {
-    return is_valid_square(r, c) && board[r][c] == EMPTY;
-}
-
-// Function to check if a square contains an opponent's piece
-int is_opponent_piece(int r, int c, int color) {
-    return is_valid_square(r, c) && (board[r][c] & color) == 0 && board[r][c] != EMPTY;
-}
-
-// Function to check if a pawn move is legal
-int is_legal_pawn_move(int sr, int sc, int dr, int dc) {
-    int piece = board[sr][sc];
-    int direction = (piece & BLACK) ? 1 : -1;
-    int start_row = (piece & BLACK) ? 1 : 6;
-    int opponent_color = (piece & BLACK) ? WHITE : BLACK;
-
-    if (dc == sc && is_square_empty(dr, dc)) {
-        if (dr == sr + direction) return 1;  // Single move
-        if (sr == start_row && dr == sr + 2 * direction && is_square_empty(sr + direction, sc)) return 1;  // Double move
-    } else if ((dc == sc + 1 || dc == sc - 1) && dr == sr + direction && is_opponent_piece(dr, dc, opponent_color)) {
-        return 1;  // Capture
+    if (!is_valid_square(sr, sc) || !is_valid_square(dr, dc)) {
+        printf("Invalid square.\n");
+        return 0;
     }
-    return 0;
-}
-
-// Function to check if a knight move is legal
-int is_legal_knight_move(int sr, int sc, int dr, int dc, int color) {
-    int row_diff = abs(dr - sr);
-    int col_diff = abs(dc - sc);
 
-    if ((row_diff == 2 && col_diff == 1) || (row_diff == 1 && col_diff == 2)) {
-        if (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color)) {
-            return 1;
+    MoveList list;
+    Move move = MOVE_NONE;
+    int from = SQUARE(sr, sc), to = SQUARE(dr, dc);
+    generate_legal_moves(&game, &list);
+    for (int i = 0; i < list.count; i++) {
+        if (MOVE_FROM(list.moves[i]) == from && MOVE_TO(list.moves[i]) == to) {
+            move = list.moves[i];
+            break;
         }
     }
-    return 0;
-}
-
-// Function to check if a bishop move is legal
-int is_legal_bishop_move(int sr, int sc, int dr, int dc, int color) {
-    if (abs(dr - sr) == abs(dc - sc)) {
-        int row_step = (dr - sr) / abs(dr - sr);
-        int col_step = (dc - sc) / abs(dc - sc);
-        int r = sr + row_step;
-        int c = sc + col_step;
-
-        while (r != dr && c != dc) {
-            if (!is_square_empty(r, c)) return 0;
-            r += row_step;
-            c += col_step;
-        }
+    if (move == MOVE_NONE) {
+        printf("Illegal move.\n");
+        return 0;
+    }
 
-        if (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color)) {
-            return 1;
+    // Pawn promotion
+    if (MOVE_KIND(move) == MOVE_PROMOTION) {
+        int choice;
+        printf("Enter promotion choice for pawn at %d,%d (1 - Knight, 2 - Bishop, 3 - Rook, 4 - Queen): ", dr, dc);
+        if (scanf("%d", &choice) != 1 || choice < 1 || choice > 4) {
+            printf("Invalid choice. Defaulting to Queen promotion.\n");
+            choice = 4;
         }
+        move = MAKE_PROMOTION(from, to, KNIGHT + choice - 1);
+        printf("Pawn promoted at %d,%d\n", dr, dc);
     }
-    return 0;
-}
 
-// Function to check if a rook move is legal
-int is_legal_rook_move(int sr, int sc, int dr, int dc, int color) {
-    if (sr == dr || sc == dc) {
-        int row_step = (dr - sr) ? (dr - sr) / abs(dr - sr) : 0;
-        int col_step = (dc - sc) ? (dc - sc) / abs(dc - sc) : 0;
-        int r = sr + row_step;
-        int c = sc + col_step;
-
-        while (r != dr || c != dc) {
-            if (!is_square_empty(r, c)) return 0;
-            r+= row_step;
-            c += col_step;
-        }
+    make_move(&game, move);
+    position_to_board(&game, board);
+    printf("Move applied.\n");
+    return 1;
+}
 
-        if (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color)) {
-            return 1;
-        }
+// Function for the AI's move
+void make_ai_move() {
+    SearchLimits limits = {.movetime = AI_MOVE_TIME_MS};
+    char text[6];
+
+    Move move = book_probe(&book, &game);
+    if (move != MOVE_NONE) {
+        move_to_uci(move, text);
+        printf("AI plays %s (book)\n", text);
+        make_move(&game, move);
+        position_to_board(&game, board);
+        return;
     }
-    return 0;
-}
 
-// Function to check if a queen move is legal
-int is_legal_queen_move(int sr, int sc, int dr, int dc, int color) {
-    return is_legal_bishop_move(sr, sc, dr, dc, color) || is_legal_rook_move(sr, sc, dr, dc, color);
+    move = pool_search(&pool, &game, &limits);
+    if (move == MOVE_NONE) return;
+
+    SearchThread *ai = pool.best;
+    uint64_t nodes = search_total_nodes(ai);
+    SearchStats stats;
+    search_total_stats(ai, &stats);
+    if (stats_json) stats_write_json(stats_json, "search", &stats, search_elapsed(ai), &pool.threads[0]);
+
+    move_to_uci(move, text);
+    printf("AI plays %s (depth %d, score %d, %llu nodes)\n", text, ai->completed_depth, ai->best_score,
+           (unsigned long long)nodes);
+    printf("Hash: %.1f%% hit rate, %.1f%% full\n",
+           stats.tt_probes ? 100.0 * stats.tt_hits / stats.tt_probes : 0.0, tt_hashfull(&tt) / 10.0);
+    printf("Ordering: %.1f%% of cutoffs on the first move\n",
+           stats.cutoffs ? 100.0 * stats.cutoffs_by_move[0] / stats.cutoffs : 0.0);
+    printf("Quiescence: %llu nodes, %.1f%% of the search\n", (unsigned long long)stats.qnodes,
+           nodes ? 100.0 * stats.qnodes / nodes : 0.0);
+    printf("Pawn hash: %.1f%% hit rate\n", stats.pawn_probes ? 100.0 * stats.pawn_hits / stats.pawn_probes : 0.0);
+    make_move(&game, move);
+    position_to_board(&game, board);
 }
 
-// Function to check if a king move is legal
-int is_legal_king_move(int sr, int sc, int dr, int dc, int color) {
-    int row_diff = abs(dr - sr);
-    int col_diff = abs(dc - sc);
-
-    if ((row_diff <= 1 && col_diff <= 1) && (is_square_empty(dr, dc) || is_opponent_piece(dr, dc, color))) {
+// Function to announce the result if the side to move has no legal moves or the game is drawn
+int game_over() {
+    MoveList list;
+    generate_legal_moves(&game, &list);
+    if (list.count == 0) {
+        print_board();
+        if (in_check(&game)) printf("Checkmate! %s wins.\n", game.side == WHITE ? "Black" : "White");
+        else printf("Stalemate!\n");
+        return 1;
+    }
+    if (is_draw(&game) || is_draw_by_insufficient_material()) {
+        print_board();
+        printf("Draw.\n");
         return 1;
     }
     return 0;
 }
 
-// Function to generate possible knight moves
-void generate_knight_moves(int r, int c) {
-    int color = board[r][c] & WHITE ? WHITE : BLACK;
-    int dr[8] = {2, 2, -2, -2, 1, 1, -1, -1};
-    int dc[8] = {1, -1, 1, -1, 2, -2, 2, -2};
-
-    for (int i = 0; i < 8; i++) {
-        int nr = r + dr[i];
-        int nc = c + dc[i];
-
-        if (is_valid_square(nr, nc) && (is_square_empty(nr, nc) || is_opponent_piece(nr, nc, color))) {
-            printf("Knight move from %d,%d to %d,%d\n", r, c, nr, nc);
-            board[nr][nc] = board[r][c];  // Move the knight
-            board[r][c] = EMPTY;          // Empty the source square
-            return;
-        }
-    }
+// Function to print the command-line usage
+void print_usage(const char *prog) {
+    printf("Usage: %s [options]              play against the AI\n", prog);
+    printf("       %s perft <depth> [fen]     count leaf nodes\n", prog);
+    printf("       %s divide <depth> [fen]    count leaf nodes per root move\n", prog);
+    printf("       %s perftsuite [depth]      check the standard perft positions\n", prog);
+    printf("       %s bench [depth]           fixed-depth search of the bench positions; prints the\n", prog);
+    printf("                                  node count signature and nps (depth %d by default)\n", BENCH_DEFAULT_DEPTH);
+    printf("       %s smpbench [threads] [depth]  time-to-depth scaling with 1, 2, 4 ... threads\n", prog);
+    printf("       %s evalbench [depth]       static evaluation cost against move generation\n", prog);
+    printf("       %s orderbench [depth]      search tree size with and without move ordering\n", prog);
+    printf("       %s pawnbench [depth]       search speed with and without the pawn hash table\n", prog);
+    printf("       %s prunebench [depth]      tree size, EBF and time to depth with null move, LMR,\n", prog);
+    printf("                                  futility, aspiration windows and PVS each on and off\n");
+    printf("       %s nnuebench [depth]       network eval speed per SIMD path, full and incremental,\n", prog);
+    printf("                                  against the classical eval; checks incremental updates\n");
+    printf("       %s nnuegen <file>          write a network that mimics the piece-square tables\n", prog);
+    printf("       %s batch <file|-> [--depth N] [--nodes N] [--out file]\n", prog);
+    printf("                                  analyse every FEN/EPD line; prints fen, move, score, depth, nodes\n");
+    printf("       %s book [fen]              list the book moves for a position and time the probe\n", prog);
+    printf("       %s genbitbases <dir>       generate the KPK, KRK, KQK and KBNK bitbases\n", prog);
+    printf("       %s match [new] [base] [--games N] [--concurrency N] [--nodes N | --depth N |\n", prog);
+    printf("             --movetime ms | --tc s+inc] [--openings file] [--pgn file] [--records file]\n");
+    printf("             [--sprt elo0 elo1]\n");
+    printf("                                  self-play match between two settings lists such as\n");
+    printf("                                  name=staged,nodes=20000 (keys: name nodes depth movetime\n");
+    printf("                                  tc hash order=plain|staged eval=classical|nnue\n");
+    printf("                                  nullmove lmr futility aspiration pvs=on|off); stops once the SPRT decides\n");
+    printf("       %s pack <fens|-> <file>    convert FEN/EPD lines to 32-byte packed positions\n", prog);
+    printf("       %s unpack <file>           print a position or game record file as text\n", prog);
+    printf("       %s scan <file>             replay every position of a record file and time it\n", prog);
+    printf("       %s pgnimport <file> [--records file]\n", prog);
+    printf("                                  replay every game of a PGN file (on --threads threads),\n");
+    printf("                                  report illegal and malformed games, save the good ones\n");
+    printf("       %s serve <port|host:port|unix:path> [--workers N] [--nodes N | --depth N | --movetime ms]\n", prog);
+    printf("                                  host many games over a line protocol (see server.h);\n");
+    printf("                                  %d nodes per move by default, one worker per core\n", SERVER_DEFAULT_NODES);
+    printf("       %s loadgen <address> [--games N] [--connections N] [--seconds N] [--think ms]\n", prog);
+    printf("                                  drive a server with random-move games; reports latency\n");
+    printf("                                  percentiles and moves and games per core\n");
+    printf("       %s uci                     speak the UCI protocol on stdin/stdout\n", prog);
+    printf("Options: --hash <MB>              transposition table size (default %d)\n", TT_DEFAULT_MB);
+    printf("         --threads <N>            search threads (default 1)\n");
+    printf("         --book <file>            Polyglot opening book for the AI's moves\n");
+    printf("         --bitbases <dir>         endgame bitbases made by genbitbases\n");
+    printf("         --nnue <file>            evaluate with a HalfKP network (Stockfish 12 format)\n");
+    printf("         --stats-json <file>      append search counters as JSON lines, one per search\n");
+    printf("                                  (one per run for batch)\n");
 }
 
-// Function to generate possible pawn moves
-void generate_pawn_moves(int r, int c) {
-    int color = board[r][c] & WHITE ? WHITE : BLACK;
-    int direction = (color == WHITE) ? -1 : 1; // Direction of movement for pawns
-    int start_row = (color == WHITE) ? 6 : 1; // Starting row for pawns
-    int promote_row = (color == WHITE) ? 0 : 7; // Promotion row for pawns
-
-    // Forward move
-    int nr = r + direction;
-    if (is_valid_square(nr, c) && is_square_empty(nr, c)) {
-        printf("Pawn move from %d,%d to %d,%d\n", r, c, nr, c);
-        board[nr][c] = board[r][c];
-        board[r][c] = EMPTY;
-
-        // Double move from starting row
-        if (r == start_row) {
-            nr = r + 2 * direction;
-            if (is_valid_square(nr, c) && is_square_empty(nr, c)) {
-                printf("Pawn move from %d,%d to %d,%d\n", r, c, nr, c);
-                board[nr][c] = board[r][c];
-                board[r][c] = EMPTY;
+// Function to take the global --options out of argv, leaving command options in place;
+// returns 0 on a bad option
+int parse_options(int *argc, char *argv[]) {
+    int n = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], "--hash") == 0 && i + 1 < *argc) {
+            hash_mb = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < *argc) {
+            thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < *argc) {
+            book_path = argv[++i];
+        } else if (strcmp(argv[i], "--bitbases") == 0 && i + 1 < *argc) {
+            bitbase_dir = argv[++i];
+        } else if (strcmp(argv[i], "--nnue") == 0 && i + 1 < *argc) {
+            if (!nnue_load(argv[++i])) {
+                printf("Could not load the network %s\n", argv[i]);
+                return 0;
             }
-        }
-
-        // Promotion
-        if (nr == promote_row) {
-            int choice;
-            printf("Enter promotion choice for pawn at %d,%d (1 - Knight, 2 - Bishop, 3 - Rook, 4 - Queen): ", nr, c);
-            scanf("%d", &choice);
-            switch(choice) {
-                case 1:
-                    board[nr][c] = (color == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
-                    break;
-                case 2:
-                    board[nr][c] = (color == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
-                    break;
-                case 3:
-                    board[nr][c] = (color == WHITE) ? WHITE_ROOK : BLACK_ROOK;
-                    break;
-                case 4:
-                    board[nr][c] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
-                    break;
-                default:
-                    printf("Invalid choice. Defaulting to Queen promotion.\n");
-                    board[nr][c] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
+        } else if (strcmp(argv[i], "--stats-json") == 0 && i + 1 < *argc) {
+            stats_json = fopen(argv[++i], "a");
+            if (!stats_json) {
+                printf("Could not open %s\n", argv[i]);
+                return 0;
             }
-            printf("Pawn promoted at %d,%d\n", nr, c);
+        } else {
+            argv[n++] = argv[i];
         }
     }
+    *argc = n;
+    return 1;
+}
 
-    // Captures
-    int capture_cols[2] = {c - 1, c + 1};
-    for (int i = 0; i < 2; i++) {
-        int nc = capture_cols[i];
-        if (is_valid_square(nr, nc) && is_opponent_piece(nr, nc, color)) {
-            printf("Pawn capture from %d,%d to %d,%d\n", r, c, nr, nc);
-            board[nr][nc] = board[r][c];
-            board[r][c] = EMPTY;
-
-            // Promotion on capture
-            if (nr == promote_row) {
-                int choice;
-                printf("Enter promotion choice for pawn at %d,%d (1 - Knight, 2 - Bishop, 3 - Rook, 4 - Queen): ", nr, nc);
-                scanf("%d", &choice);
-                switch(choice) {
-                    case 1:
-                        board[nr][nc] = (color == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
-                        break;
-                    case 2:
-                        board[nr][nc] = (color == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
-                        break;
-                    case 3:
-                        board[nr][nc] = (color == WHITE) ? WHITE_ROOK : BLACK_ROOK;
-                        break;
-                    case 4:
-                        board[nr][nc] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
-                        break;
-                    default:
-                        printf("Invalid choice. Defaulting to Queen promotion.\n");
-                        board[nr][nc] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
-                }
-                printf("Pawn promoted at %d,%d\n", nr, nc);
-            }
-        }
-    }
+// Function to open the book given on the command line; returns 0 only if one was asked for and failed
+int open_book() {
+    if (!book_path) return 1;
+    return book_open(&book, book_path);
 }
 
-// Function for the user's move
-// Function for the user's move
-void make_user_move() {
-    int sr, sc, dr, dc;
-    printf("Enter your move (source_row source_col dest_row dest_col): ");
-    scanf("%d %d %d %d", &sr, &sc, &dr, &dc);
-
-    if (is_valid_square(sr, sc) && is_valid_square(dr, dc)) {
-        int piece = board[sr][sc];
-        int color = piece & WHITE ? WHITE : BLACK;
-
-        int is_legal = 0;
-        switch (piece & 0x7) { // Mask to get piece type
-            case PAWN:
-                is_legal = is_legal_pawn_move(sr, sc, dr, dc);
-                break;
-            case KNIGHT:
-                is_legal = is_legal_knight_move(sr, sc, dr, dc, color);
-                break;
-            case BISHOP:
-                is_legal = is_legal_bishop_move(sr, sc, dr, dc, color);
-                break;
-            case ROOK:
-                is_legal = is_legal_rook_move(sr, sc, dr, dc, color);
-                break;
-            case QUEEN:
-                is_legal = is_legal_queen_move(sr, sc, dr, dc, color);
-                break;
-            case KING:
-                is_legal = is_legal_king_move(sr, sc, dr, dc, color);
-                break;
-            default:
-                printf("Invalid piece.\n");
-                return;
-        }
+// Function to list the book moves for a position and time the lookup
+int run_book_probe(int argc, char *argv[]) {
+    char fen[256];
+    Position pos;
+    const int rounds = 100000;
 
-        if (is_legal) {
-            board[dr][dc] = board[sr][sc];
-            board[sr][sc] = EMPTY;
-
-            // Pawn promotion
-            if ((piece == WHITE_PAWN && dr == 0) || (piece == BLACK_PAWN && dr == 7)) {
-                int choice;
-                printf("Enter promotion choice for pawn at %d,%d (1 - Knight, 2 - Bishop, 3 - Rook, 4 - Queen): ", dr, dc);
-                scanf("%d", &choice);
-                switch (choice) {
-                    case 1:
-                        board[dr][dc] = (color == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
-                        break;
-                    case 2:
-                        board[dr][dc] = (color == WHITE) ? WHITE_BISHOP : BLACK_BISHOP;
-                        break;
-                    case 3:
-                        board[dr][dc] = (color == WHITE) ? WHITE_ROOK : BLACK_ROOK;
-                        break;
-                    case 4:
-                        board[dr][dc] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
-                        break;
-                    default:
-                        printf("Invalid choice. Defaulting to Queen promotion.\n");
-                        board[dr][dc] = (color == WHITE) ? WHITE_QUEEN : BLACK_QUEEN;
-                }
-                printf("Pawn promoted at %d,%d\n", dr, dc);
-            }
+    if (!book_path) {
+        printf("book needs --book <file>\n");
+        return 1;
+    }
+    if (argc > 2) join_args(argc - 2, argv + 2, fen, sizeof(fen));
+    else strcpy(fen, START_FEN);
+    if (!position_set_fen(&pos, fen)) {
+        printf("Invalid FEN\n");
+        return 1;
+    }
 
-            printf("Move applied.\n");
+    int64_t start = now_ns();
+    if (!open_book()) return 1;
+    printf("Opened %zu entries in %.1f us\n", book.count, (now_ns() - start) / 1000.0);
+
+    int found = book_print_moves(&book, &pos);
+    start = now_ns();
+    for (int i = 0; i < rounds; i++) book_probe(&book, &pos);
+    printf("%d move(s), %.2f us per probe\n", found, (now_ns() - start) / 1000.0 / rounds);
+    book_close(&book);
+    return 0;
+}
+
+// Function to parse the match command line and run a self-play match
+int run_match_command(int argc, char *argv[]) {
+    MatchSettings ms = {
+        .engines = {{.name = "new", .hash_mb = 16}, {.name = "base", .hash_mb = 16}},
+        .games = 1000,
+        .concurrency = thread_count > 1 ? thread_count : (int)sysconf(_SC_NPROCESSORS_ONLN),
+        .max_plies = 400,
+        .elo0 = 0.0, .elo1 = 5.0, .alpha = 0.05, .beta = 0.05,
+    };
+    const char *settings[2] = {NULL, NULL};
+    int engines = 0;
+
+    // Options shared by both engines are applied first, so "key=value" lists can override them
+    for (int i = 2; i < argc; i++) {
+        char common[64];
+        int have_value = i + 1 < argc;
+        common[0] = '\0';
+        if (strchr(argv[i], '=') && argv[i][0] != '-' && engines < 2) settings[engines++] = argv[i];
+        else if (strcmp(argv[i], "--games") == 0 && have_value) ms.games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--concurrency") == 0 && have_value) ms.concurrency = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--openings") == 0 && have_value) ms.openings_path = argv[++i];
+        else if (strcmp(argv[i], "--pgn") == 0 && have_value) ms.pgn_path = argv[++i];
+        else if (strcmp(argv[i], "--records") == 0 && have_value) ms.records_path = argv[++i];
+        else if (strcmp(argv[i], "--max-plies") == 0 && have_value) ms.max_plies = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && have_value) ms.alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--beta") == 0 && have_value) ms.beta = atof(argv[++i]);
+        else if (strcmp(argv[i], "--sprt") == 0 && i + 2 < argc) {
+            ms.elo0 = atof(argv[++i]);
+            ms.elo1 = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--nodes") == 0 || strcmp(argv[i], "--depth") == 0
+                    || strcmp(argv[i], "--movetime") == 0 || strcmp(argv[i], "--tc") == 0) && have_value) {
+            snprintf(common, sizeof(common), "%s=%s", argv[i] + 2, argv[i + 1]);
+            i++;
         } else {
-            printf("Illegal move.\n");
+            printf("Unknown match option %s\n", argv[i]);
+            return 1;
+        }
+        if (common[0] && (!parse_engine_config(&ms.engines[0], common) || !parse_engine_config(&ms.engines[1], common))) {
+            return 1;
         }
-    } else {
-        printf("Invalid square.\n");
     }
-}
-// Function for the AI's move
-void make_ai_move() {
-    // Placeholder implementation, just generates knight moves for the first knight found.
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if ((board[r][c] & 0x7) == KNIGHT && (board[r][c] & BLACK)) {
-                generate_knight_moves(r, c);
-                return;
-            }
+    for (int e = 0; e < 2; e++) {
+        if (settings[e] && !parse_engine_config(&ms.engines[e], settings[e])) return 1;
+        const EngineConfig *engine = &ms.engines[e];
+        if (!engine->limits.depth && !engine->limits.nodes && !engine->limits.movetime && !engine->base_ms) {
+            ms.engines[e].limits.nodes = MATCH_DEFAULT_NODES;
         }
     }
+    if (ms.max_plies > MAX_GAME_PLY - MAX_PLY - 1) ms.max_plies = MAX_GAME_PLY - MAX_PLY - 1;
+    if (ms.alpha <= 0 || ms.alpha >= 1 || ms.beta <= 0 || ms.beta >= 1 || ms.elo1 <= ms.elo0) {
+        printf("SPRT needs elo0 < elo1 and error rates between 0 and 1\n");
+        return 1;
+    }
+    return run_match(&ms);
 }
 
-// Function to check if the specified king is in check
-int is_in_check(int king_row, int king_col, int color) {
-    // Iterate over the board to find opponent's pieces
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if ((board[r][c] & color) == 0 && board[r][c] != EMPTY) { // Opponent's piece
-                switch (board[r][c] & 0x7) {
-                    case PAWN:
-                        if (is_legal_pawn_move(r, c, king_row, king_col)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    case KNIGHT:
-                        if (is_legal_knight_move(r, c, king_row, king_col, color)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    case BISHOP:
-                        if (is_legal_bishop_move(r, c, king_row, king_col, color)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    case ROOK:
-                        if (is_legal_rook_move(r, c, king_row, king_col, color)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    case QUEEN:
-                        if (is_legal_queen_move(r, c, king_row, king_col, color)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    case KING:
-                        if (is_legal_king_move(r, c, king_row, king_col, color)) {
-                            return 1; // King is in check
-                        }
-                        break;
-                    default:
-                        break;
-                }
-            }
+// Function to parse the serve command and run the game server
+int run_serve_command(int argc, char *argv[]) {
+    ServerSettings ss = {.address = argv[2], .workers = (int)sysconf(_SC_NPROCESSORS_ONLN), .hash_mb = hash_mb};
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) ss.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) ss.limits.nodes = (uint64_t)atoll(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) ss.limits.depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) ss.limits.movetime = atoll(argv[++i]);
+        else {
+            printf("Unknown serve option %s\n", argv[i]);
+            return 1;
         }
     }
-    return 0; // King is not in check
+    if (!ss.limits.nodes && !ss.limits.depth && !ss.limits.movetime) ss.limits.nodes = SERVER_DEFAULT_NODES;
+    return run_server(&ss);
 }
 
-// Function to check if the specified color is in checkmate
-int is_checkmate(int color) {
-    // Iterate over the board to find all pieces of the specified color
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if ((board[r][c] & color) != 0) { // Piece of the specified color
-                int piece = board[r][c] & 0x7; // Get the piece type
-                // Generate all possible moves for the piece
-                switch (piece) {
-                    case PAWN:
-                        // Iterate over all possible pawn moves
-                        for (int dr = -1; dr <= 1; dr++) {
-                            for (int dc = -1; dc <= 1; dc++) {
-                                if (is_legal_pawn_move(r, c, r + dr, c + dc)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in checkmate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case KNIGHT:
-                        // Iterate over all possible knight moves
-                        for (int dr = -2; dr <= 2; dr++) {
-                            for (int dc = -2; dc <= 2; dc++) {
-                                if (abs(dr) + abs(dc) == 3 && is_legal_knight_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in checkmate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case BISHOP:
-                        // Iterate over all possible bishop moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if (abs(dr) == abs(dc) && is_legal_bishop_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that theboard[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case ROOK:
-                        // Iterate over all possible rook moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if ((abs(dr) == 0 || abs(dc) == 0) && is_legal_rook_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in checkmate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case QUEEN:
-                        // Iterate over all possible queen moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if ((abs(dr) == 0 || abs(dc) == 0 || abs(dr) == abs(dc)) &&
-                                    is_legal_queen_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in checkmate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case KING:
-                        // Iterate over all possible king moves
-                        for (int dr = -1; dr <= 1; dr++) {
-                            for (int dc = -1; dc <= 1; dc++) {
-                                if ((dr != 0 || dc != 0) && is_legal_king_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in checkmate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // King is not in checkmate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    default:
-                        break;
-                }
-            }
+// Function to parse the loadgen command and run the load generator
+int run_loadgen_command(int argc, char *argv[]) {
+    LoadSettings ls = {.address = argv[2], .games = 1000, .connections = 8, .seconds = 10};
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) ls.games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) ls.connections = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) ls.seconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--think") == 0 && i + 1 < argc) ls.think_ms = atoi(argv[++i]);
+        else {
+            printf("Unknown loadgen option %s\n", argv[i]);
+            return 1;
         }
     }
-    return 1; // King is in checkmate
+    if (ls.games < 1 || ls.connections < 1 || ls.seconds < 1) {
+        printf("loadgen needs at least one game, connection and second\n");
+        return 1;
+    }
+    if (ls.connections > ls.games) ls.connections = ls.games;
+    return run_load_generator(&ls);
 }
 
-// Function to check if the specified color is in stalemate
-int is_stalemate(int color) {
-    // Iterate over the board to find all pieces of the specified color
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if ((board[r][c] & color) != 0) { // Piece of the specified color
-                int piece = board[r][c] & 0x7; // Get the piece type
-                // Generate all possible moves for the piece
-                switch (piece) {
-                    case PAWN:
-                        // Iterate over all possible pawn moves
-                        for (int dr = -1; dr <= 1; dr++) {
-                            for (int dc = -1; dc <= 1; dc++) {
-                                if (is_legal_pawn_move(r, c, r + dr, c + dc)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case KNIGHT:
-                        // Iterate over all possible knight moves
-                        for (int dr = -2; dr <= 2; dr++) {
-                            for (int dc = -2; dc <= 2; dc++) {
-                                if (abs(dr) + abs(dc) == 3 && is_legal_knight_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case BISHOP:
-                        // Iterate over all possible bishop moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if (abs(dr) == abs(dc) && is_legal_bishop_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case ROOK:
-                        // Iterate over all possible rook moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if ((abs(dr) == 0 || abs(dc) == 0) && is_legal_rook_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case QUEEN:
-                        // Iterate over all possible queen moves
-                        for (int dr = -7; dr <= 7; dr++) {
-                            for (int dc = -7; dc <= 7; dc++) {
-                                if ((abs(dr) == 0 || abs(dc) == 0 || abs(dr) == abs(dc)) &&
-                                    is_legal_queen_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    case KING:
-                        // Iterate over all possible king moves
-                        for (int dr = -1; dr <= 1; dr++) {
-                            for (int dc = -1; dc <= 1; dc++) {
-                                if ((dr != 0 || dc != 0) && is_legal_king_move(r, c, r + dr, c + dc, color)) {
-                                    // Simulate the move
-                                    int temp = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = board[r][c];
-                                    board[r][c] = EMPTY;
-                                    // Check if the king is still in check after the move
-                                    if (!is_in_check(r, c, color)) {
-                                        // Undo the move and return that the king is not in stalemate
-                                        board[r][c] = board[r + dr][c + dc];
-                                        board[r + dr][c + dc] = temp;
-                                        return 0; // Not in stalemate
-                                    }
-                                    // Undo the move
-                                    board[r][c] = board[r + dr][c + dc];
-                                    board[r + dr][c + dc] = temp;
-                                }
-                            }
-                        }
-                        break;
-                    default:
-                        break;
-                }
+// Function to run a non-interactive command; returns the process exit code
+int run_command(int argc, char *argv[]) {
+    char fen[256];
+
+    if ((strcmp(argv[1], "perft") == 0 || strcmp(argv[1], "divide") == 0) && argc >= 3) {
+        if (argc > 3) join_args(argc - 3, argv + 3, fen, sizeof(fen));
+        else strcpy(fen, START_FEN);
+        return run_perft(fen, atoi(argv[2]), argv[1][0] == 'd');
+    }
+    if (strcmp(argv[1], "genbitbases") == 0 && argc >= 3) {
+        int threads = thread_count > 1 ? thread_count : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        return bitbase_generate(argv[2], threads) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "book") == 0) {
+        return run_book_probe(argc, argv);
+    }
+    if (strcmp(argv[1], "pack") == 0 && argc >= 4) {
+        return run_pack_fens(argv[2], argv[3]);
+    }
+    if (strcmp(argv[1], "unpack") == 0 && argc >= 3) {
+        return run_unpack(argv[2]);
+    }
+    if (strcmp(argv[1], "pgnimport") == 0 && argc >= 3) {
+        const char *records = NULL;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--records") == 0 && i + 1 < argc) records = argv[++i];
+            else {
+                printf("Unknown pgnimport option %s\n", argv[i]);
+                return 1;
             }
         }
+        return run_pgn_import(argv[2], thread_count, records);
     }
-    return 1; // Stalemate
-}
-
-// Function to check if the specified color is in draw by insufficient material
-int is_draw_by_insufficient_material(int color) {
-    // Count the number of pieces remaining for the specified color
-    int num_pieces = 0;
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if ((board[r][c] & color) != 0) { // Piece of the specified color
-                num_pieces++;
+    if (strcmp(argv[1], "scan") == 0 && argc >= 3) {
+        return run_record_scan(argv[2]);
+    }
+    if (strcmp(argv[1], "match") == 0) {
+        return run_match_command(argc, argv);
+    }
+    if (strcmp(argv[1], "serve") == 0 && argc >= 3) {
+        return run_serve_command(argc, argv);
+    }
+    if (strcmp(argv[1], "loadgen") == 0 && argc >= 3) {
+        return run_loadgen_command(argc, argv);
+    }
+    if (strcmp(argv[1], "uci") == 0) {
+        return run_uci(hash_mb, thread_count, stats_json);
+    }
+    if (strcmp(argv[1], "perftsuite") == 0) {
+        return run_perft_suite(argc > 2 ? atoi(argv[2]) : 4) ? 1 : 0;
+    }
+    if (strcmp(argv[1], "evalbench") == 0) {
+        return run_eval_bench(argc > 2 ? atoi(argv[2]) : 3);
+    }
+    if (strcmp(argv[1], "orderbench") == 0) {
+        return run_order_bench(argc > 2 ? atoi(argv[2]) : 5, hash_mb);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return run_search_bench(argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH);
+    }
+    if (strcmp(argv[1], "pawnbench") == 0) {
+        return run_pawn_bench(argc > 2 ? atoi(argv[2]) : 6, hash_mb);
+    }
+    if (strcmp(argv[1], "prunebench") == 0) {
+        return run_prune_bench(argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH, hash_mb);
+    }
+    if (strcmp(argv[1], "nnuebench") == 0) {
+        return run_nnue_bench(argc > 2 ? atoi(argv[2]) : 3, hash_mb);
+    }
+    if (strcmp(argv[1], "nnuegen") == 0 && argc >= 3) {
+        nnue_init_bootstrap();
+        if (!nnue_loaded() || !nnue_save(argv[2])) {
+            printf("Could not write %s\n", argv[2]);
+            return 1;
+        }
+        printf("Wrote the bootstrap network to %s\n", argv[2]);
+        return 0;
+    }
+    if (strcmp(argv[1], "batch") == 0 && argc >= 3) {
+        SearchLimits limits = {0};
+        const char *out = NULL;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) limits.depth = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) limits.nodes = (uint64_t)atoll(argv[++i]);
+            else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out = argv[++i];
+            else {
+                printf("Unknown batch option %s\n", argv[i]);
+                return 1;
             }
         }
+        if (!limits.depth && !limits.nodes) limits.depth = 8;
+        return run_batch(argv[2], out, &limits, thread_count, hash_mb, stats_json);
     }
-
-    // Draw by insufficient material occurs when:
-    // - Both players have only a king left
-    // - Both players have only a king and a knight left
-    // - Both players have only a king and a bishop left (of the same color)
-    // - Both players have only kings and bishops left (of the same color)
-    if (num_pieces == 1 || (num_pieces == 2 && ((color == WHITE && num_pieces == 2 && is_draw_by_insufficient_material(BLACK)) ||
-        (color == BLACK && num_pieces == 2 && is_draw_by_insufficient_material(WHITE))))) {
-        return 1; // Draw by insufficient material
+    if (strcmp(argv[1], "smpbench") == 0) {
+        int max_threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        return run_smp_bench(max_threads, argc > 3 ? atoi(argv[3]) : 8, hash_mb);
     }
 
-    return 0; // Not a draw by insufficient material
+    print_usage(argv[0]);
+    return 1;
 }
+
 // Main function
-int main() {
+int main(int argc, char *argv[]) {
+    init_bitboards();
+    init_zobrist();
+    init_eval();
+    init_pawns();
+    if (!parse_options(&argc, argv)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (bitbase_dir && !bitbase_load(bitbase_dir)) {
+        printf("No bitbases found in %s\n", bitbase_dir);
+        return 1;
+    }
+    if (argc > 1) return run_command(argc, argv);
+    if (!tt_init(&tt, hash_mb) || !pool_init(&pool, thread_count, &tt) || !open_book()) return 1;
+
+    position_set_fen(&game, START_FEN);
+    position_to_board(&game, board);
     while (1) {
         print_board();
         printf("Your move (White):\n");
-        make_user_move();
+        while (!make_user_move());
+        if (game_over()) break;
         print_board();
         printf("AI's move(Black):\n");
         make_ai_move();
+        if (game_over()) break;
     }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "misc.h"
+
+// Function to get a monotonic timestamp in milliseconds
+int64_t now_ms(void) {
+    return now_ns() / 1000000;
+}
+
+// Function to get a monotonic timestamp in nanoseconds
+int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Function to sleep for a number of milliseconds
+void sleep_ms(int ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+// Function to join argv words back into one space-separated string
+void join_args(int argc, char *argv[], char *buf, int size) {
+    int n = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < argc && n < size - 1; i++) {
+        int len = (int)strlen(argv[i]);
+        if (i > 0) buf[n++] = ' ';
+        if (n + len >= size) len = size - 1 - n;
+        memcpy(buf + n, argv[i], (size_t)len);
+        n += len;
+        buf[n] = '\0';
+    }
+}
+
+// Function to order two int32_t values for qsort
+static int compare_int32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to sort values in place and return the p-th percentile (0-100), nearest rank
+int32_t percentile_int32(int32_t *values, size_t count, double p) {
+    if (!count) return 0;
+    qsort(values, count, sizeof(int32_t), compare_int32);
+    return values[(size_t)(p / 100.0 * (count - 1) + 0.5)];
+}
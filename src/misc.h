@@ -0,0 +1,22 @@
+#ifndef MISC_H
+#define MISC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Function to get a monotonic timestamp in milliseconds
+int64_t now_ms(void);
+
+// Function to get a monotonic timestamp in nanoseconds
+int64_t now_ns(void);
+
+// Function to sleep for a number of milliseconds
+void sleep_ms(int ms);
+
+// Function to join argv words back into one space-separated string
+void join_args(int argc, char *argv[], char *buf, int size);
+
+// Function to sort values in place and return the p-th percentile (0-100), nearest rank
+int32_t percentile_int32(int32_t *values, size_t count, double p);
+
+#endif
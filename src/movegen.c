@@ -0,0 +1,461 @@
+#include <string.h>
+#include "movegen.h"
+
+static inline void add_move(MoveList *list, Move move) {
+    list->moves[list->count++] = move;
+}
+
+// Function to add the promotion moves for one pawn move, split by kind: queen promotions
+// and capturing underpromotions are captures, quiet underpromotions are quiets
+static void add_promotions(MoveList *list, int from, int to, int kinds, int capture) {
+    if (kinds & GEN_CAPTURES) add_move(list, MAKE_PROMOTION(from, to, QUEEN));
+    if ((capture && (kinds & GEN_CAPTURES)) || (!capture && (kinds & GEN_QUIETS))) {
+        add_move(list, MAKE_PROMOTION(from, to, ROOK));
+        add_move(list, MAKE_PROMOTION(from, to, BISHOP));
+        add_move(list, MAKE_PROMOTION(from, to, KNIGHT));
+    }
+}
+
+// Function to generate pawn pushes, captures, promotions and en passant;
+// destinations outside allowed are skipped (en passant is left to is_legal_move)
+static void generate_pawn_moves(const Position *pos, MoveList *list, int kinds, Bitboard allowed) {
+    int us = pos->side;
+    int ci = COLOR_INDEX(us);
+    int up = (us == WHITE) ? -8 : 8;
+    int start_row = (us == WHITE) ? 6 : 1;
+    int promote_row = (us == WHITE) ? 0 : 7;
+    Bitboard enemies = pos->by_color[ci ^ 1];
+    Bitboard empty = ~occupied_bb(pos);
+    Bitboard pawns = pieces_of(pos, us, PAWN);
+    Bitboard allowed_empty = empty & allowed;
+
+    while (pawns) {
+        int from = pop_lsb(&pawns);
+        int to = from + up;
+
+        // Pushes
+        if (empty & SQ_BB(to)) {
+            if (allowed & SQ_BB(to)) {
+                if (SQ_ROW(to) == promote_row) add_promotions(list, from, to, kinds, 0);
+                else if (kinds & GEN_QUIETS) add_move(list, MAKE_MOVE(from, to, MOVE_NORMAL));
+            }
+            if ((kinds & GEN_QUIETS) && SQ_ROW(from) == start_row && (allowed_empty & SQ_BB(to + up))) {
+                add_move(list, MAKE_MOVE(from, to + up, MOVE_NORMAL));
+            }
+        }
+
+        // Captures
+        Bitboard targets = pawn_attacks[ci][from] & enemies & allowed;
+        while (targets) {
+            to = pop_lsb(&targets);
+            if (SQ_ROW(to) == promote_row) {
+                add_promotions(list, from, to, kinds, 1);
+            } else if (kinds & GEN_CAPTURES) {
+                add_move(list, MAKE_MOVE(from, to, MOVE_NORMAL));
+            }
+        }
+
+        if ((kinds & GEN_CAPTURES) && pos->ep_square != SQ_NONE
+            && (pawn_attacks[ci][from] & SQ_BB(pos->ep_square))) {
+            add_move(list, MAKE_MOVE(from, pos->ep_square, MOVE_EN_PASSANT));
+        }
+    }
+}
+
+// Function to check if any square in a mask is attacked by the given color
+static int any_attacked(const Position *pos, Bitboard squares, int by_color) {
+    while (squares) {
+        if (is_square_attacked(pos, pop_lsb(&squares), by_color)) return 1;
+    }
+    return 0;
+}
+
+// Function to generate castling moves; the king path must be empty and safe
+static void generate_castling(const Position *pos, MoveList *list) {
+    if (pos->checkers) return;
+
+    int us = pos->side;
+    int them = OPPONENT(us);
+    int king_from = (us == WHITE) ? 60 : 4;
+    int rights_k = (us == WHITE) ? CASTLE_WK : CASTLE_BK;
+    int rights_q = (us == WHITE) ? CASTLE_WQ : CASTLE_BQ;
+    Bitboard occ = occupied_bb(pos);
+
+    if (pos->squares[king_from] != (us | KING)) return;
+
+    // King side: f and g files empty, king passes e, f, g
+    if ((pos->castling & rights_k) && pos->squares[king_from + 3] == (us | ROOK)
+        && !(occ & (SQ_BB(king_from + 1) | SQ_BB(king_from + 2)))
+        && !any_attacked(pos, SQ_BB(king_from) | SQ_BB(king_from + 1) | SQ_BB(king_from + 2), them)) {
+        add_move(list, MAKE_MOVE(king_from, king_from + 2, MOVE_CASTLING));
+    }
+
+    // Queen side: b, c and d files empty, king passes e, d, c
+    if ((pos->castling & rights_q) && pos->squares[king_from - 4] == (us | ROOK)
+        && !(occ & (SQ_BB(king_from - 1) | SQ_BB(king_from - 2) | SQ_BB(king_from - 3)))
+        && !any_attacked(pos, SQ_BB(king_from) | SQ_BB(king_from - 1) | SQ_BB(king_from - 2), them)) {
+        add_move(list, MAKE_MOVE(king_from, king_from - 2, MOVE_CASTLING));
+    }
+}
+
+// Function to append pseudo-legal moves of the requested kinds to the list
+void generate_moves(const Position *pos, MoveList *list, int kinds) {
+    int us = pos->side;
+    Bitboard occ = occupied_bb(pos);
+    Bitboard targets = 0;
+    Bitboard allowed = ~0ULL;
+
+    if (kinds & GEN_CAPTURES) targets |= pos->by_color[COLOR_INDEX(us) ^ 1];
+    if (kinds & GEN_QUIETS) targets |= ~occ;
+
+    // In check only the king may move, unless a single checker can be captured or blocked
+    if (pos->checkers) {
+        allowed = more_than_one(pos->checkers) ? 0
+                : between_bb[king_square(pos, us)][lsb(pos->checkers)] | pos->checkers;
+    }
+
+    if (allowed) generate_pawn_moves(pos, list, kinds, allowed);
+
+    for (int type = KNIGHT; type <= KING; type++) {
+        Bitboard pieces = pieces_of(pos, us, type);
+        while (pieces) {
+            int from = pop_lsb(&pieces);
+            Bitboard attacks;
+            switch (type) {
+                case KNIGHT: attacks = knight_attacks[from]; break;
+                case BISHOP: attacks = bishop_attacks(from, occ); break;
+                case ROOK: attacks = rook_attacks(from, occ); break;
+                case QUEEN: attacks = queen_attacks(from, occ); break;
+                default: attacks = king_attacks[from]; break;
+            }
+            attacks &= (type == KING) ? targets : targets & allowed;
+            while (attacks) {
+                add_move(list, MAKE_MOVE(from, pop_lsb(&attacks), MOVE_NORMAL));
+            }
+        }
+    }
+
+    if (kinds & GEN_QUIETS) generate_castling(pos, list);
+}
+
+// Function to check that a move (from the hash table or a killer slot) could have been
+// generated in this position by generate_moves with GEN_ALL
+int is_pseudo_legal(const Position *pos, Move move) {
+    int us = pos->side;
+    int ci = COLOR_INDEX(us);
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int piece = pos->squares[from];
+
+    if (move == MOVE_NONE || piece == EMPTY || PIECE_COLOR(piece) != us) return 0;
+    if (pos->by_color[ci] & SQ_BB(to)) return 0;
+
+    // Castling and en passant are rare enough to simply ask the generator
+    if (MOVE_KIND(move) == MOVE_CASTLING || MOVE_KIND(move) == MOVE_EN_PASSANT) {
+        MoveList list;
+        list.count = 0;
+        generate_moves(pos, &list, MOVE_KIND(move) == MOVE_CASTLING ? GEN_QUIETS : GEN_CAPTURES);
+        for (int i = 0; i < list.count; i++) {
+            if (list.moves[i] == move) return 1;
+        }
+        return 0;
+    }
+
+    Bitboard occ = occupied_bb(pos);
+    int type = PIECE_TYPE(piece);
+    if (type == PAWN) {
+        int up = (us == WHITE) ? -8 : 8;
+        int start_row = (us == WHITE) ? 6 : 1;
+        int promote_row = (us == WHITE) ? 0 : 7;
+
+        if ((SQ_ROW(to) == promote_row) != (MOVE_KIND(move) == MOVE_PROMOTION)) return 0;
+        if (pos->by_color[ci ^ 1] & SQ_BB(to)) {
+            if (!(pawn_attacks[ci][from] & SQ_BB(to))) return 0;
+        } else if (to == from + up) {
+            if (occ & SQ_BB(to)) return 0;
+        } else if (to != from + 2 * up || SQ_ROW(from) != start_row || (occ & (SQ_BB(from + up) | SQ_BB(to)))) {
+            return 0;
+        }
+    } else {
+        Bitboard attacks;
+        if (MOVE_KIND(move) != MOVE_NORMAL) return 0;
+        switch (type) {
+            case KNIGHT: attacks = knight_attacks[from]; break;
+            case BISHOP: attacks = bishop_attacks(from, occ); break;
+            case ROOK: attacks = rook_attacks(from, occ); break;
+            case QUEEN: attacks = queen_attacks(from, occ); break;
+            default: attacks = king_attacks[from]; break;
+        }
+        if (!(attacks & SQ_BB(to))) return 0;
+    }
+
+    // The generator only produces evasions when in check
+    if (pos->checkers && type != KING) {
+        if (more_than_one(pos->checkers)) return 0;
+        if (!((between_bb[king_square(pos, us)][lsb(pos->checkers)] | pos->checkers) & SQ_BB(to))) return 0;
+    }
+    return 1;
+}
+
+// Function to check that a pseudo-legal move does not leave the king attacked
+int is_legal_move(const Position *pos, Move move) {
+    int us = pos->side;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int ksq = king_square(pos, us);
+    Bitboard them = pos->by_color[COLOR_INDEX(us) ^ 1];
+
+    // En passant removes two pieces from a line at once, so test the resulting occupancy
+    if (MOVE_KIND(move) == MOVE_EN_PASSANT) {
+        Bitboard captured = SQ_BB(to + ((us == WHITE) ? 8 : -8));
+        Bitboard occ = (occupied_bb(pos) ^ SQ_BB(from) ^ captured) | SQ_BB(to);
+        return !(attackers_to(pos, ksq, occ) & them & ~captured);
+    }
+
+    // King moves: the destination must be safe with the king lifted off its square,
+    // castling paths were already checked during generation
+    if (from == ksq) {
+        if (MOVE_KIND(move) == MOVE_CASTLING) return 1;
+        return !(attackers_to(pos, to, occupied_bb(pos) ^ SQ_BB(from)) & them);
+    }
+
+    // Other moves must resolve a single check and keep a pinned piece on its pin line
+    if (pos->checkers) {
+        if (more_than_one(pos->checkers)) return 0;
+        if (!((between_bb[ksq][lsb(pos->checkers)] | pos->checkers) & SQ_BB(to))) return 0;
+    }
+    return !(pos->pinned & SQ_BB(from)) || (line_bb[from][ksq] & SQ_BB(to));
+}
+
+// Function to check if a pseudo-legal move puts the opponent's king in check
+int gives_check(const Position *pos, Move move) {
+    int us = pos->side;
+    int ci = COLOR_INDEX(us);
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    Bitboard target = SQ_BB(king_square(pos, OPPONENT(us)));
+    Bitboard occ = (occupied_bb(pos) ^ SQ_BB(from)) | SQ_BB(to);
+    Bitboard ours = (pos->by_color[ci] ^ SQ_BB(from)) | SQ_BB(to);
+    Bitboard rooks = pos->by_type[ROOK];
+
+    if (MOVE_KIND(move) == MOVE_EN_PASSANT) {
+        occ ^= SQ_BB(to + (us == WHITE ? 8 : -8));
+    } else if (MOVE_KIND(move) == MOVE_CASTLING) {
+        int rook_from = to > from ? from + 3 : from - 4;
+        int rook_to = to > from ? from + 1 : from - 1;
+        occ ^= SQ_BB(rook_from) | SQ_BB(rook_to);
+        ours ^= SQ_BB(rook_from) | SQ_BB(rook_to);
+        rooks ^= SQ_BB(rook_from) | SQ_BB(rook_to);
+    }
+
+    // Direct check by the piece on its new square
+    int type = MOVE_KIND(move) == MOVE_PROMOTION ? MOVE_PROMO(move) : PIECE_TYPE(pos->squares[from]);
+    switch (type) {
+        case PAWN: if (pawn_attacks[ci][to] & target) return 1; break;
+        case KNIGHT: if (knight_attacks[to] & target) return 1; break;
+        case BISHOP: if (bishop_attacks(to, occ) & target) return 1; break;
+        case ROOK: if (rook_attacks(to, occ) & target) return 1; break;
+        case QUEEN: if (queen_attacks(to, occ) & target) return 1; break;
+        default: break;
+    }
+
+    // Discovered check (or the castling rook) by a slider that did not move
+    int ksq = lsb(target);
+    ours &= ~SQ_BB(to);
+    return ((bishop_attacks(ksq, occ) & ours & (pos->by_type[BISHOP] | pos->by_type[QUEEN]))
+          | (rook_attacks(ksq, occ) & ours & (rooks | pos->by_type[QUEEN]))) != 0;
+}
+
+// Function to fill the list with every legal move in the position
+void generate_legal_moves(const Position *pos, MoveList *list) {
+    MoveList pseudo;
+    pseudo.count = 0;
+    generate_moves(pos, &pseudo, GEN_ALL);
+
+    list->count = 0;
+    for (int i = 0; i < pseudo.count; i++) {
+        if (is_legal_move(pos, pseudo.moves[i])) add_move(list, pseudo.moves[i]);
+    }
+}
+
+// Function to format a move in coordinate notation ("e7e8q"); buf needs 6 bytes
+void move_to_uci(Move move, char *buf) {
+    if (move == MOVE_NONE) {
+        strcpy(buf, "0000");
+        return;
+    }
+    square_name(MOVE_FROM(move), buf);
+    square_name(MOVE_TO(move), buf + 2);
+    if (MOVE_KIND(move) == MOVE_PROMOTION) {
+        buf[4] = " pnbrqk"[MOVE_PROMO(move)];
+        buf[5] = '\0';
+    }
+}
+
+// Function to format a legal move in standard algebraic notation ("Nbd7", "exd8=Q+");
+// buf needs 10 bytes. The move is played and taken back to detect check and mate
+void move_to_san(Position *pos, Move move, char *buf) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int type = PIECE_TYPE(pos->squares[from]);
+    int capture = pos->squares[to] != EMPTY || MOVE_KIND(move) == MOVE_EN_PASSANT;
+    int n = 0;
+
+    if (MOVE_KIND(move) == MOVE_CASTLING) {
+        strcpy(buf, to > from ? "O-O" : "O-O-O");
+        n = (int)strlen(buf);
+    } else {
+        if (type == PAWN) {
+            if (capture) buf[n++] = (char)('a' + SQ_COL(from));
+        } else {
+            MoveList list;
+            int ambiguous = 0, same_col = 0, same_row = 0;
+
+            // Other pieces of the same kind that can legally reach the target square
+            generate_legal_moves(pos, &list);
+            for (int i = 0; i < list.count; i++) {
+                int other = MOVE_FROM(list.moves[i]);
+                if (MOVE_TO(list.moves[i]) != to || other == from || pos->squares[other] != pos->squares[from]) continue;
+                ambiguous = 1;
+                same_col |= SQ_COL(other) == SQ_COL(from);
+                same_row |= SQ_ROW(other) == SQ_ROW(from);
+            }
+            buf[n++] = " PNBRQK"[type];
+            if (ambiguous && (!same_col || same_row)) buf[n++] = (char)('a' + SQ_COL(from));
+            if (ambiguous && same_col) buf[n++] = (char)('8' - SQ_ROW(from));
+        }
+        if (capture) buf[n++] = 'x';
+        square_name(to, buf + n);
+        n += 2;
+        if (MOVE_KIND(move) == MOVE_PROMOTION) {
+            buf[n++] = '=';
+            buf[n++] = " PNBRQK"[MOVE_PROMO(move)];
+        }
+    }
+
+    make_move(pos, move);
+    if (in_check(pos)) {
+        MoveList replies;
+        generate_legal_moves(pos, &replies);
+        buf[n++] = replies.count ? '+' : '#';
+    }
+    unmake_move(pos, move);
+    buf[n] = '\0';
+}
+
+// Function to find the legal move matching coordinate notation; MOVE_NONE if none
+Move parse_uci_move(const Position *pos, const char *text) {
+    MoveList list;
+    char buf[6];
+
+    generate_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        move_to_uci(list.moves[i], buf);
+        if (strncmp(buf, text, strlen(buf)) == 0 && (text[strlen(buf)] == '\0' || text[strlen(buf)] == ' '
+            || text[strlen(buf)] == '\n')) {
+            return list.moves[i];
+        }
+    }
+    return MOVE_NONE;
+}
+
+// Function to get the piece type a SAN piece letter names; EMPTY for anything else
+static inline int san_piece(char c) {
+    switch (c) {
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default: return EMPTY;
+    }
+}
+
+// Function to find the legal move matching standard algebraic notation ("Nbd7", "exd8=Q+",
+// "O-O"); MOVE_NONE if no legal move or more than one matches. The text need not be
+// terminated: length characters are read. Only the pieces that could reach the target
+// are tried, so no move list is generated except for en passant
+Move parse_san_move(const Position *pos, const char *text, int length) {
+    int us = pos->side;
+    int ci = COLOR_INDEX(us);
+    int type = PAWN, from_col = -1, from_row = -1, promo = EMPTY;
+    int n = length;
+
+    // Check, mate and annotation marks carry no information for finding the move
+    while (n > 0 && (text[n - 1] == '+' || text[n - 1] == '#' || text[n - 1] == '!' || text[n - 1] == '?')) n--;
+    if (n < 2) return MOVE_NONE;
+
+    if (text[0] == 'O' || text[0] == '0') {
+        int from = king_square(pos, us);
+        int to;
+        if (n == 3 && text[1] == '-' && text[2] == text[0]) to = from + 2;
+        else if (n == 5 && text[1] == '-' && text[2] == text[0] && text[3] == '-' && text[4] == text[0]) to = from - 2;
+        else return MOVE_NONE;
+        // The generator's castling moves are legal already
+        MoveList list;
+        list.count = 0;
+        generate_castling(pos, &list);
+        for (int i = 0; i < list.count; i++) {
+            if (MOVE_TO(list.moves[i]) == to) return list.moves[i];
+        }
+        return MOVE_NONE;
+    }
+
+    // Promotion suffix: "=Q" or a bare "Q"
+    if (n >= 3 && san_piece(text[n - 1]) >= KNIGHT && san_piece(text[n - 1]) <= QUEEN) {
+        promo = san_piece(text[n - 1]);
+        n -= text[n - 2] == '=' ? 2 : 1;
+    }
+    if (n < 2 || text[n - 2] < 'a' || text[n - 2] > 'h' || text[n - 1] < '1' || text[n - 1] > '8') return MOVE_NONE;
+    int to = SQUARE('8' - text[n - 1], text[n - 2] - 'a');
+
+    // What lies between the piece letter and the target: disambiguation and the capture mark
+    int i = 0;
+    if (san_piece(text[0]) != EMPTY) {
+        type = san_piece(text[0]);
+        i = 1;
+    }
+    for (; i < n - 2; i++) {
+        if (text[i] >= 'a' && text[i] <= 'h') from_col = text[i] - 'a';
+        else if (text[i] >= '1' && text[i] <= '8') from_row = '8' - text[i];
+        else if (text[i] != 'x' && text[i] != ':') return MOVE_NONE;
+    }
+    if (promo != EMPTY && type != PAWN) return MOVE_NONE;
+
+    Bitboard occ = occupied_bb(pos);
+    Bitboard candidates;
+    switch (type) {
+        case PAWN:
+            if (from_col < 0 || from_col == SQ_COL(to)) {
+                // A push: the pawn stands one or two squares behind the target
+                int behind = to + (us == WHITE ? 8 : -8);
+                if (behind < 0 || behind > 63) return MOVE_NONE;
+                if (pos->squares[behind] == EMPTY) behind += us == WHITE ? 8 : -8;
+                candidates = behind >= 0 && behind < 64 ? SQ_BB(behind) : 0;
+            } else {
+                candidates = pawn_attacks[ci ^ 1][to];
+            }
+            break;
+        case KNIGHT: candidates = knight_attacks[to]; break;
+        case BISHOP: candidates = bishop_attacks(to, occ); break;
+        case ROOK: candidates = rook_attacks(to, occ); break;
+        case QUEEN: candidates = queen_attacks(to, occ); break;
+        default: candidates = king_attacks[to]; break;
+    }
+    candidates &= pieces_of(pos, us, type);
+
+    Move found = MOVE_NONE;
+    while (candidates) {
+        int from = pop_lsb(&candidates);
+        if ((from_col >= 0 && SQ_COL(from) != from_col) || (from_row >= 0 && SQ_ROW(from) != from_row)) continue;
+
+        Move move;
+        if (promo != EMPTY) move = MAKE_PROMOTION(from, to, promo);
+        else if (type == PAWN && to == pos->ep_square && SQ_COL(from) != SQ_COL(to)) move = MAKE_MOVE(from, to, MOVE_EN_PASSANT);
+        else move = MAKE_MOVE(from, to, MOVE_NORMAL);
+        if (!is_pseudo_legal(pos, move) || !is_legal_move(pos, move)) continue;
+        if (found != MOVE_NONE) return MOVE_NONE;
+        found = move;
+    }
+    return found;
+}
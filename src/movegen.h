@@ -0,0 +1,49 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "position.h"
+
+#define MAX_MOVES 256
+
+#define GEN_CAPTURES 1   // captures (underpromotions included) and queen promotions
+#define GEN_QUIETS 2     // everything else, including castling
+#define GEN_ALL (GEN_CAPTURES | GEN_QUIETS)
+
+// Fixed-capacity move list; lives on the caller's stack
+typedef struct {
+    Move moves[MAX_MOVES];
+    int count;
+} MoveList;
+
+// Function to append pseudo-legal moves of the requested kinds to the list
+void generate_moves(const Position *pos, MoveList *list, int kinds);
+
+// Function to check that a move (from the hash table or a killer slot) could have been
+// generated in this position by generate_moves with GEN_ALL
+int is_pseudo_legal(const Position *pos, Move move);
+
+// Function to check that a pseudo-legal move does not leave the king attacked
+int is_legal_move(const Position *pos, Move move);
+
+// Function to check if a pseudo-legal move puts the opponent's king in check
+int gives_check(const Position *pos, Move move);
+
+// Function to fill the list with every legal move in the position
+void generate_legal_moves(const Position *pos, MoveList *list);
+
+// Function to format a move in coordinate notation ("e7e8q"); buf needs 6 bytes
+void move_to_uci(Move move, char *buf);
+
+// Function to format a legal move in standard algebraic notation ("Nbd7", "exd8=Q+");
+// buf needs 10 bytes. The move is played and taken back to detect check and mate
+void move_to_san(Position *pos, Move move, char *buf);
+
+// Function to find the legal move matching coordinate notation; MOVE_NONE if none
+Move parse_uci_move(const Position *pos, const char *text);
+
+// Function to find the legal move matching standard algebraic notation ("Nbd7", "exd8=Q+",
+// "O-O"); MOVE_NONE if no legal move or more than one matches. The text need not be
+// terminated: length characters are read
+Move parse_san_move(const Position *pos, const char *text, int length);
+
+#endif
@@ -0,0 +1,192 @@
+#include <stddef.h>
+#include "movepick.h"
+
+// Function to start picking moves for pos; tt_move and killers may be MOVE_NONE
+void picker_init(MovePicker *mp, const Position *pos, Move tt_move, const Move killers[2],
+                 const HistoryTable *history) {
+    mp->pos = pos;
+    mp->history = history;
+    mp->tt_move = is_pseudo_legal(pos, tt_move) ? tt_move : MOVE_NONE;
+    mp->killers[0] = killers ? killers[0] : MOVE_NONE;
+    mp->killers[1] = killers ? killers[1] : MOVE_NONE;
+    mp->stage = mp->tt_move != MOVE_NONE ? STAGE_TT_MOVE : STAGE_CAPTURES_INIT;
+    mp->plain = 0;
+    mp->with_checks = 0;
+    mp->killer_index = 0;
+    mp->bad_count = 0;
+}
+
+// Function to start handing out every move of pos in plain generation order,
+// the baseline for measuring what the ordering saves
+void picker_init_plain(MovePicker *mp, const Position *pos) {
+    picker_init(mp, pos, MOVE_NONE, NULL, NULL);
+    mp->stage = STAGE_QUIETS_INIT;
+    mp->plain = 1;
+}
+
+// Function to start picking quiescence moves: the hash move if tactical, captures and
+// queen promotions by MVV-LVA, then quiet checks when with_checks is set
+void picker_init_qsearch(MovePicker *mp, const Position *pos, Move tt_move, int with_checks) {
+    picker_init(mp, pos, MOVE_NONE, NULL, NULL);
+    if (is_pseudo_legal(pos, tt_move) && (is_tactical_move(pos, tt_move) || (with_checks && gives_check(pos, tt_move)))) {
+        mp->tt_move = tt_move;
+    }
+    mp->stage = mp->tt_move != MOVE_NONE ? STAGE_QS_TT_MOVE : STAGE_QS_CAPTURES_INIT;
+    mp->with_checks = with_checks;
+}
+
+// Function to give every capture its most-valuable-victim / least-valuable-attacker score
+static void score_captures(MovePicker *mp) {
+    const Position *pos = mp->pos;
+    for (int i = 0; i < mp->list.count; i++) {
+        Move move = mp->list.moves[i];
+        int victim = MOVE_KIND(move) == MOVE_EN_PASSANT ? PAWN : PIECE_TYPE(pos->squares[MOVE_TO(move)]);
+        int score = piece_value[victim] * 8 - PIECE_TYPE(pos->squares[MOVE_FROM(move)]);
+        if (MOVE_KIND(move) == MOVE_PROMOTION) score += piece_value[MOVE_PROMO(move)] * 8;
+        mp->scores[i] = score;
+    }
+}
+
+// Function to order quiet moves by how often they caused cutoffs before
+static void score_quiets(MovePicker *mp) {
+    int ci = COLOR_INDEX(mp->pos->side);
+    for (int i = 0; i < mp->list.count; i++) {
+        Move move = mp->list.moves[i];
+        mp->scores[i] = mp->history ? (*mp->history)[ci][MOVE_FROM(move)][MOVE_TO(move)] : 0;
+    }
+}
+
+// Function to swap the best remaining move to the current slot and return it;
+// one selection step per call instead of sorting moves that may never be searched
+static Move pick_best(MovePicker *mp) {
+    int best = mp->current;
+    // Strictly greater keeps equal scores in generation order
+    for (int i = mp->current + 1; i < mp->list.count; i++) {
+        if (mp->scores[i] > mp->scores[best]) best = i;
+    }
+
+    Move move = mp->list.moves[best];
+    int score = mp->scores[best];
+    mp->list.moves[best] = mp->list.moves[mp->current];
+    mp->scores[best] = mp->scores[mp->current];
+    mp->list.moves[mp->current] = move;
+    mp->scores[mp->current] = score;
+    mp->current++;
+    return move;
+}
+
+// Function to get the next pseudo-legal move, or MOVE_NONE when all were returned
+Move picker_next(MovePicker *mp) {
+    Move move;
+
+    switch (mp->stage) {
+        case STAGE_TT_MOVE:
+            mp->stage = STAGE_CAPTURES_INIT;
+            return mp->tt_move;
+
+        case STAGE_CAPTURES_INIT:
+            mp->list.count = 0;
+            mp->current = 0;
+            generate_moves(mp->pos, &mp->list, GEN_CAPTURES);
+            score_captures(mp);
+            mp->stage = STAGE_CAPTURES;
+            // fall through
+
+        case STAGE_CAPTURES:
+            while (mp->current < mp->list.count) {
+                move = pick_best(mp);
+                if (move == mp->tt_move) continue;
+                if (see(mp->pos, move) < 0) {
+                    mp->bad_captures[mp->bad_count++] = move;
+                    continue;
+                }
+                return move;
+            }
+            mp->stage = STAGE_KILLERS;
+            // fall through
+
+        case STAGE_KILLERS:
+            while (mp->killer_index < 2) {
+                move = mp->killers[mp->killer_index++];
+                if (move != MOVE_NONE && move != mp->tt_move && !is_tactical_move(mp->pos, move)
+                    && is_pseudo_legal(mp->pos, move)) {
+                    return move;
+                }
+            }
+            mp->stage = STAGE_QUIETS_INIT;
+            // fall through
+
+        case STAGE_QUIETS_INIT:
+            mp->list.count = 0;
+            mp->current = 0;
+            generate_moves(mp->pos, &mp->list, mp->plain ? GEN_ALL : GEN_QUIETS);
+            score_quiets(mp);
+            mp->stage = STAGE_QUIETS;
+            // fall through
+
+        case STAGE_QUIETS:
+            while (mp->current < mp->list.count) {
+                move = pick_best(mp);
+                if (move != mp->tt_move && move != mp->killers[0] && move != mp->killers[1]) return move;
+            }
+            mp->stage = STAGE_BAD_CAPTURES;
+            mp->current = 0;
+            // fall through
+
+        case STAGE_BAD_CAPTURES:
+            if (mp->current < mp->bad_count) return mp->bad_captures[mp->current++];
+            mp->stage = STAGE_DONE;
+            return MOVE_NONE;
+
+        case STAGE_QS_TT_MOVE:
+            mp->stage = STAGE_QS_CAPTURES_INIT;
+            return mp->tt_move;
+
+        case STAGE_QS_CAPTURES_INIT:
+            mp->list.count = 0;
+            mp->current = 0;
+            generate_moves(mp->pos, &mp->list, GEN_CAPTURES);
+            score_captures(mp);
+            mp->stage = STAGE_QS_CAPTURES;
+            // fall through
+
+        case STAGE_QS_CAPTURES:
+            while (mp->current < mp->list.count) {
+                move = pick_best(mp);
+                if (move != mp->tt_move) return move;
+            }
+            if (!mp->with_checks) {
+                mp->stage = STAGE_DONE;
+                return MOVE_NONE;
+            }
+            mp->stage = STAGE_QS_CHECKS_INIT;
+            // fall through
+
+        case STAGE_QS_CHECKS_INIT:
+            mp->list.count = 0;
+            mp->current = 0;
+            generate_moves(mp->pos, &mp->list, GEN_QUIETS);
+            mp->stage = STAGE_QS_CHECKS;
+            // fall through
+
+        case STAGE_QS_CHECKS:
+            while (mp->current < mp->list.count) {
+                move = mp->list.moves[mp->current++];
+                if (move != mp->tt_move && gives_check(mp->pos, move)) return move;
+            }
+            mp->stage = STAGE_DONE;
+            return MOVE_NONE;
+
+        default:
+            return MOVE_NONE;
+    }
+}
+
+// Function to reward a quiet move that caused a cutoff, or punish one that did not;
+// the update shrinks as the entry approaches HISTORY_MAX so scores never overflow
+void history_update(HistoryTable *history, int color, Move move, int bonus) {
+    int16_t *entry = &(*history)[COLOR_INDEX(color)][MOVE_FROM(move)][MOVE_TO(move)];
+    if (bonus > HISTORY_MAX) bonus = HISTORY_MAX;
+    if (bonus < -HISTORY_MAX) bonus = -HISTORY_MAX;
+    *entry += bonus - *entry * (bonus < 0 ? -bonus : bonus) / HISTORY_MAX;
+}
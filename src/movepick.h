@@ -0,0 +1,75 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "position.h"
+#include "movegen.h"
+
+// History scores saturate at this magnitude
+#define HISTORY_MAX 16384
+
+// Quiet-move success counts indexed by [color index][from][to]
+typedef int16_t HistoryTable[2][64][64];
+
+// Stages of the move picker, in the order moves are returned
+enum {
+    STAGE_TT_MOVE,
+    STAGE_CAPTURES_INIT,
+    STAGE_CAPTURES,
+    STAGE_KILLERS,
+    STAGE_QUIETS_INIT,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE,
+
+    // Quiescence search: captures, then quiet checks if asked for
+    STAGE_QS_TT_MOVE,
+    STAGE_QS_CAPTURES_INIT,
+    STAGE_QS_CAPTURES,
+    STAGE_QS_CHECKS_INIT,
+    STAGE_QS_CHECKS
+};
+
+// Function to check if a move is searched with the captures rather than the quiets
+static inline int is_tactical_move(const Position *pos, Move move) {
+    return pos->squares[MOVE_TO(move)] != EMPTY || MOVE_KIND(move) == MOVE_EN_PASSANT
+        || (MOVE_KIND(move) == MOVE_PROMOTION && MOVE_PROMO(move) == QUEEN);
+}
+
+// Hands out pseudo-legal moves best-first, generating and scoring each group
+// only when the previous one did not already cause a cutoff; captures that lose
+// material by SEE wait until after the quiet moves
+typedef struct {
+    const Position *pos;
+    const HistoryTable *history;
+    Move tt_move;
+    Move killers[2];
+    int stage;
+    int plain;                // no ordering at all: every move in generation order
+    int with_checks;          // quiescence search also wants quiet checking moves
+    int killer_index;
+    int current;
+    MoveList list;
+    int scores[MAX_MOVES];
+    Move bad_captures[MAX_MOVES];  // captures losing material by SEE, tried after the quiets
+    int bad_count;
+} MovePicker;
+
+// Function to start picking moves for pos; tt_move and killers may be MOVE_NONE
+void picker_init(MovePicker *mp, const Position *pos, Move tt_move, const Move killers[2],
+                 const HistoryTable *history);
+
+// Function to start handing out every move of pos in plain generation order,
+// the baseline for measuring what the ordering saves
+void picker_init_plain(MovePicker *mp, const Position *pos);
+
+// Function to start picking quiescence moves: the hash move if tactical, captures and
+// queen promotions by MVV-LVA, then quiet checks when with_checks is set
+void picker_init_qsearch(MovePicker *mp, const Position *pos, Move tt_move, int with_checks);
+
+// Function to get the next pseudo-legal move, or MOVE_NONE when all were returned
+Move picker_next(MovePicker *mp);
+
+// Function to reward a quiet move that caused a cutoff, or punish one that did not
+void history_update(HistoryTable *history, int color, Move move, int bonus);
+
+#endif
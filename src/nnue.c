@@ -0,0 +1,495 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nnue.h"
+#include "eval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#else
+#define NNUE_X86 0
+#endif
+
+// Stockfish 12 layer hashes, written to files we save; only the version is checked on load
+#define NNUE_FT_HASH 0x5D69D7B9u
+#define NNUE_NET_HASH 0x63337156u
+#define NNUE_MAX_ACTIVE 30        // non-king pieces, so features active per perspective
+#define NNUE_MAX_REPLAY 8         // plies replayed before a refresh is cheaper
+#define NNUE_DESCRIPTION "HalfKP 256x2-32-32"
+
+// Bootstrap net: BOOT_RAMPS first-layer neurons each clip the same material sum, in
+// BOOT_UNIT net units, to a different 127-wide band; together they pass it on unclipped
+#define BOOT_RAMPS 32
+#define BOOT_UNIT 4
+#define BOOT_OFFSET (BOOT_RAMPS * 127 / 2)
+
+typedef struct {
+    _Alignas(32) int16_t ft_biases[NNUE_HALF_DIMS];
+    int16_t *ft_weights;      // NNUE_HALF_DIMS per feature, feature after feature
+    _Alignas(32) int8_t l1_weights[NNUE_HIDDEN][2 * NNUE_HALF_DIMS];
+    _Alignas(32) int8_t l2_weights[NNUE_HIDDEN][NNUE_HIDDEN];
+    _Alignas(32) int8_t out_weights[NNUE_HIDDEN];
+    int32_t l1_biases[NNUE_HIDDEN];
+    int32_t l2_biases[NNUE_HIDDEN];
+    int32_t out_bias;
+} Network;
+
+// The kernels one SIMD path provides
+typedef struct {
+    // dst = src + the add columns - the sub columns, NNUE_HALF_DIMS wide
+    void (*update)(int16_t *dst, const int16_t *src, const int16_t **add, int add_count,
+                   const int16_t **sub, int sub_count);
+    // Clip both accumulator halves to 0..127 bytes, side to move first
+    void (*transform)(const int16_t *us, const int16_t *them, uint8_t *out);
+    // out[r] = dot product of the n input bytes (n a multiple of 32) with weight row r;
+    // rows are n bytes apart and number either one or a multiple of four
+    void (*affine)(const uint8_t *in, const int8_t *weights, int n, int rows, int32_t *out);
+} Kernels;
+
+static Network *net = NULL;
+static int simd_level = NNUE_SCALAR;
+
+static void update_scalar(int16_t *dst, const int16_t *src, const int16_t **add, int add_count,
+                          const int16_t **sub, int sub_count) {
+    for (int i = 0; i < NNUE_HALF_DIMS; i++) {
+        int16_t v = src[i];
+        for (int a = 0; a < add_count; a++) v = (int16_t)(v + add[a][i]);
+        for (int s = 0; s < sub_count; s++) v = (int16_t)(v - sub[s][i]);
+        dst[i] = v;
+    }
+}
+
+static void transform_scalar(const int16_t *us, const int16_t *them, uint8_t *out) {
+    for (int i = 0; i < NNUE_HALF_DIMS; i++) {
+        out[i] = (uint8_t)(us[i] < 0 ? 0 : us[i] > 127 ? 127 : us[i]);
+        out[NNUE_HALF_DIMS + i] = (uint8_t)(them[i] < 0 ? 0 : them[i] > 127 ? 127 : them[i]);
+    }
+}
+
+static void affine_scalar(const uint8_t *in, const int8_t *weights, int n, int rows, int32_t *out) {
+    for (int r = 0; r < rows; r++) {
+        int32_t sum = 0;
+        for (int i = 0; i < n; i++) sum += in[i] * weights[r * n + i];
+        out[r] = sum;
+    }
+}
+
+#if NNUE_X86
+__attribute__((target("sse4.1")))
+static void update_sse41(int16_t *dst, const int16_t *src, const int16_t **add, int add_count,
+                         const int16_t **sub, int sub_count) {
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        for (int a = 0; a < add_count; a++) v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i *)(add[a] + i)));
+        for (int s = 0; s < sub_count; s++) v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i *)(sub[s] + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void transform_sse41(const int16_t *us, const int16_t *them, uint8_t *out) {
+    const __m128i zero = _mm_setzero_si128();
+    for (int half = 0; half < 2; half++) {
+        const int16_t *acc = half ? them : us;
+        for (int i = 0; i < NNUE_HALF_DIMS; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(acc + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(acc + i + 8));
+            __m128i packed = _mm_max_epi8(_mm_packs_epi16(a, b), zero);
+            _mm_storeu_si128((__m128i *)(out + half * NNUE_HALF_DIMS + i), packed);
+        }
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i dot16_sse41(__m128i sum, __m128i x, const int8_t *weights) {
+    // Byte products summed in pairs (at most 2 * 127 * 128, so no saturation), then in fours
+    __m128i pairs = _mm_maddubs_epi16(x, _mm_loadu_si128((const __m128i *)weights));
+    return _mm_add_epi32(sum, _mm_madd_epi16(pairs, _mm_set1_epi16(1)));
+}
+
+__attribute__((target("sse4.1")))
+static void affine_sse41(const uint8_t *in, const int8_t *weights, int n, int rows, int32_t *out) {
+    // Four rows at a time share each input load and one horizontal reduction
+    for (int r = 0; r + 4 <= rows; r += 4) {
+        const int8_t *w = weights + r * n;
+        __m128i s0 = _mm_setzero_si128(), s1 = s0, s2 = s0, s3 = s0;
+        for (int i = 0; i < n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            s0 = dot16_sse41(s0, x, w + i);
+            s1 = dot16_sse41(s1, x, w + n + i);
+            s2 = dot16_sse41(s2, x, w + 2 * n + i);
+            s3 = dot16_sse41(s3, x, w + 3 * n + i);
+        }
+        _mm_storeu_si128((__m128i *)(out + r), _mm_hadd_epi32(_mm_hadd_epi32(s0, s1), _mm_hadd_epi32(s2, s3)));
+    }
+    if (rows == 1) {
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < n; i += 16) sum = dot16_sse41(sum, _mm_loadu_si128((const __m128i *)(in + i)), weights + i);
+        sum = _mm_hadd_epi32(sum, sum);
+        out[0] = _mm_cvtsi128_si32(_mm_hadd_epi32(sum, sum));
+    }
+}
+
+__attribute__((target("avx2")))
+static void update_avx2(int16_t *dst, const int16_t *src, const int16_t **add, int add_count,
+                        const int16_t **sub, int sub_count) {
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        for (int a = 0; a < add_count; a++) v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i *)(add[a] + i)));
+        for (int s = 0; s < sub_count; s++) v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i *)(sub[s] + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+}
+
+__attribute__((target("avx2")))
+static void transform_avx2(const int16_t *us, const int16_t *them, uint8_t *out) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (int half = 0; half < 2; half++) {
+        const int16_t *acc = half ? them : us;
+        for (int i = 0; i < NNUE_HALF_DIMS; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(acc + i + 16));
+            // packs works within 128-bit lanes; the permute puts the quarters back in order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            _mm256_storeu_si256((__m256i *)(out + half * NNUE_HALF_DIMS + i), _mm256_max_epi8(packed, zero));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i dot32_avx2(__m256i sum, __m256i x, const int8_t *weights) {
+    __m256i pairs = _mm256_maddubs_epi16(x, _mm256_loadu_si256((const __m256i *)weights));
+    return _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+
+__attribute__((target("avx2")))
+static void affine_avx2(const uint8_t *in, const int8_t *weights, int n, int rows, int32_t *out) {
+    for (int r = 0; r + 4 <= rows; r += 4) {
+        const int8_t *w = weights + r * n;
+        __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+        for (int i = 0; i < n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+            s0 = dot32_avx2(s0, x, w + i);
+            s1 = dot32_avx2(s1, x, w + n + i);
+            s2 = dot32_avx2(s2, x, w + 2 * n + i);
+            s3 = dot32_avx2(s3, x, w + 3 * n + i);
+        }
+        // Fold each row's eight lanes to four, then add the halves: lane k is row r + k
+        __m256i quad = _mm256_hadd_epi32(_mm256_hadd_epi32(s0, s1), _mm256_hadd_epi32(s2, s3));
+        __m128i total = _mm_add_epi32(_mm256_castsi256_si128(quad), _mm256_extracti128_si256(quad, 1));
+        _mm_storeu_si128((__m128i *)(out + r), total);
+    }
+    if (rows == 1) {
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < n; i += 32) sum = dot32_avx2(sum, _mm256_loadu_si256((const __m256i *)(in + i)), weights + i);
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_hadd_epi32(half, half);
+        out[0] = _mm_cvtsi128_si32(_mm_hadd_epi32(half, half));
+    }
+}
+#endif
+
+static const Kernels kernels[3] = {
+    {update_scalar, transform_scalar, affine_scalar},
+#if NNUE_X86
+    {update_sse41, transform_sse41, affine_sse41},
+    {update_avx2, transform_avx2, affine_avx2},
+#endif
+};
+
+// Function to get the best SIMD path this CPU supports
+int nnue_best_simd(void) {
+#if NNUE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return NNUE_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return NNUE_SSE41;
+#endif
+    return NNUE_SCALAR;
+}
+
+// Function to select the SIMD path (at most the best supported); returns the one in use
+int nnue_set_simd(int level) {
+    int best = nnue_best_simd();
+    simd_level = level < NNUE_SCALAR ? NNUE_SCALAR : level > best ? best : level;
+    return simd_level;
+}
+
+// Function to name a SIMD path
+const char *nnue_simd_name(int level) {
+    static const char *names[3] = {"scalar", "sse4.1", "avx2"};
+    return names[level];
+}
+
+// Function to check if a network is loaded
+int nnue_loaded(void) {
+    return net != NULL;
+}
+
+// Function to map a square to a perspective's view: Black sees the board turned round.
+// Network squares count from a1, ours from a8
+static inline int orient(int ci, int sq) {
+    return ci == 0 ? sq ^ 56 : sq ^ 7;
+}
+
+// Function to get the first-layer column of a piece on a square, seen from perspective ci
+static inline const int16_t *feature_column(int ci, int king, int piece, int sq) {
+    int enemy = COLOR_INDEX(PIECE_COLOR(piece)) != ci;
+    int index = orient(ci, sq) + 1 + 64 * (2 * (PIECE_TYPE(piece) - 1) + enemy) + NNUE_PS_END * orient(ci, king);
+    return net->ft_weights + (size_t)index * NNUE_HALF_DIMS;
+}
+
+// Function to allocate an empty network; returns NULL when out of memory
+static Network *allocate_network(void) {
+    Network *fresh = aligned_alloc(32, sizeof(Network));
+    int16_t *weights = aligned_alloc(32, (size_t)NNUE_INPUTS * NNUE_HALF_DIMS * sizeof(int16_t));
+    if (!fresh || !weights) {
+        free(fresh);
+        free(weights);
+        return NULL;
+    }
+    memset(fresh, 0, sizeof(Network));
+    fresh->ft_weights = weights;
+    return fresh;
+}
+
+// Function to free a network and its weights
+static void free_network(Network *n) {
+    if (n) free(n->ft_weights);
+    free(n);
+}
+
+// Function to read exactly size bytes; returns 0 on a short read
+static int read_block(FILE *in, void *data, size_t size) {
+    return fread(data, 1, size, in) == size;
+}
+
+// Function to read a network file into n; returns 0 if it cannot be read or has the wrong shape.
+// Multi-byte values are little-endian, as on every host this engine builds for
+static int read_network(FILE *in, Network *n) {
+    uint32_t version, hash, length;
+    char description[1024];
+
+    if (!read_block(in, &version, 4) || !read_block(in, &hash, 4) || !read_block(in, &length, 4)) return 0;
+    if (version != NNUE_VERSION) return 0;
+    while (length > 0) {
+        size_t chunk = length < sizeof(description) ? length : sizeof(description);
+        if (!read_block(in, description, chunk)) return 0;
+        length -= (uint32_t)chunk;
+    }
+
+    // A file with the same version but other layer sizes fails on the lengths below
+    return read_block(in, &hash, 4) && read_block(in, n->ft_biases, sizeof(n->ft_biases)) &&
+           read_block(in, n->ft_weights, (size_t)NNUE_INPUTS * NNUE_HALF_DIMS * sizeof(int16_t)) &&
+           read_block(in, &hash, 4) &&
+           read_block(in, n->l1_biases, sizeof(n->l1_biases)) &&
+           read_block(in, n->l1_weights, sizeof(n->l1_weights)) &&
+           read_block(in, n->l2_biases, sizeof(n->l2_biases)) &&
+           read_block(in, n->l2_weights, sizeof(n->l2_weights)) &&
+           read_block(in, &n->out_bias, sizeof(n->out_bias)) &&
+           read_block(in, n->out_weights, sizeof(n->out_weights)) && fgetc(in) == EOF;
+}
+
+// Function to load a network file; returns 0 if it cannot be read or has the wrong shape
+int nnue_load(const char *path) {
+    FILE *in = fopen(path, "rb");
+    Network *fresh = in ? allocate_network() : NULL;
+    int ok = fresh && read_network(in, fresh);
+
+    if (in) fclose(in);
+    // A failed load keeps whatever network was in use
+    if (!ok) {
+        free_network(fresh);
+        return 0;
+    }
+    free_network(net);
+    net = fresh;
+    nnue_set_simd(NNUE_AVX2);
+    return 1;
+}
+
+// Function to write the loaded network to a file in the same format; returns 1 on success
+int nnue_save(const char *path) {
+    uint32_t header[3] = {NNUE_VERSION, NNUE_FT_HASH ^ NNUE_NET_HASH, sizeof(NNUE_DESCRIPTION) - 1};
+    uint32_t ft_hash = NNUE_FT_HASH, net_hash = NNUE_NET_HASH;
+    FILE *out;
+
+    if (!net || !(out = fopen(path, "wb"))) return 0;
+    fwrite(header, 4, 3, out);
+    fwrite(NNUE_DESCRIPTION, 1, header[2], out);
+    fwrite(&ft_hash, 4, 1, out);
+    fwrite(net->ft_biases, sizeof(net->ft_biases), 1, out);
+    fwrite(net->ft_weights, sizeof(int16_t), (size_t)NNUE_INPUTS * NNUE_HALF_DIMS, out);
+    fwrite(&net_hash, 4, 1, out);
+    fwrite(net->l1_biases, sizeof(net->l1_biases), 1, out);
+    fwrite(net->l1_weights, sizeof(net->l1_weights), 1, out);
+    fwrite(net->l2_biases, sizeof(net->l2_biases), 1, out);
+    fwrite(net->l2_weights, sizeof(net->l2_weights), 1, out);
+    fwrite(&net->out_bias, sizeof(net->out_bias), 1, out);
+    fwrite(net->out_weights, sizeof(net->out_weights), 1, out);
+    int ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
+
+// Function to build a network that reproduces the material and piece-square tables
+// (no file needed); lets the inference path run before a trained net is available
+void nnue_init_bootstrap(void) {
+    Network *fresh = allocate_network();
+    if (!fresh) return;
+    free_network(net);
+    net = fresh;
+
+    // Every feature adds its piece's value, averaged over the phases, to all the ramps;
+    // the king square is ignored, so all 64 king buckets hold the same columns
+    for (int ci = 0; ci < 2; ci++) {
+        for (int piece = WHITE_PAWN; piece <= BLACK_QUEEN; piece++) {
+            if (PIECE_TYPE(piece) < PAWN || PIECE_TYPE(piece) > QUEEN) continue;
+            for (int sq = 0; sq < 64; sq++) {
+                int value = (psq_mg[piece][sq] + psq_eg[piece][sq]) / 2 * (ci == 0 ? 1 : -1);
+                int units = value * NNUE_PAWN_VALUE / (100 * BOOT_UNIT);
+                for (int king = 0; king < 64; king++) {
+                    int16_t *column = (int16_t *)feature_column(ci, king, piece, sq);
+                    for (int j = 0; j < BOOT_RAMPS; j++) column[j] = (int16_t)units;
+                }
+            }
+        }
+    }
+
+    // Ramp j passes the band [127 j, 127 (j + 1)) of sum + BOOT_OFFSET; each hidden layer
+    // rebuilds the sum from the side to move's ramps and splits it into bands again
+    for (int j = 0; j < BOOT_RAMPS; j++) {
+        net->ft_biases[j] = (int16_t)(BOOT_OFFSET - 127 * j);
+        net->l1_biases[j] = -127 * j * (1 << NNUE_WEIGHT_SHIFT);
+        net->l2_biases[j] = -127 * j * (1 << NNUE_WEIGHT_SHIFT);
+        for (int i = 0; i < BOOT_RAMPS; i++) {
+            net->l1_weights[j][i] = 1 << NNUE_WEIGHT_SHIFT;
+            net->l2_weights[j][i] = 1 << NNUE_WEIGHT_SHIFT;
+        }
+        net->out_weights[j] = NNUE_FV_SCALE * BOOT_UNIT;
+    }
+    net->out_bias = -BOOT_OFFSET * NNUE_FV_SCALE * BOOT_UNIT;
+    nnue_set_simd(NNUE_AVX2);
+}
+
+// Function to note what a legal move is about to change; call before make_move
+void nnue_record_move(const Position *pos, Move move, DirtyPieces *dirty) {
+    int from = MOVE_FROM(move), to = MOVE_TO(move), kind = MOVE_KIND(move);
+    int piece = pos->squares[from];
+
+    dirty->count = 1;
+    dirty->piece[0] = piece;
+    dirty->from[0] = from;
+    dirty->to[0] = to;
+
+    if (kind == MOVE_CASTLING) {
+        dirty->count = 2;
+        dirty->piece[1] = PIECE_COLOR(piece) | ROOK;
+        dirty->from[1] = to > from ? from + 3 : from - 4;
+        dirty->to[1] = to > from ? from + 1 : from - 1;
+        return;
+    }
+
+    int captured_sq = kind == MOVE_EN_PASSANT ? to + (pos->side == WHITE ? 8 : -8) : to;
+    if (pos->squares[captured_sq] != EMPTY) {
+        dirty->piece[dirty->count] = pos->squares[captured_sq];
+        dirty->from[dirty->count] = captured_sq;
+        dirty->to[dirty->count] = SQ_NONE;
+        dirty->count++;
+    }
+    if (kind == MOVE_PROMOTION) {
+        // The pawn leaves the board and the new piece appears in its place
+        dirty->to[0] = SQ_NONE;
+        dirty->piece[dirty->count] = PIECE_COLOR(piece) | MOVE_PROMO(move);
+        dirty->from[dirty->count] = SQ_NONE;
+        dirty->to[dirty->count] = to;
+        dirty->count++;
+    }
+}
+
+// Function to compute one perspective of an accumulator from scratch
+static void refresh(const Position *pos, NnueAccumulator *acc, int ci) {
+    const int16_t *columns[NNUE_MAX_ACTIVE];
+    int count = 0;
+    int king = lsb(pos->by_color[ci] & pos->by_type[KING]);
+    Bitboard b = occupied_bb(pos) & ~pos->by_type[KING];
+
+    while (b && count < NNUE_MAX_ACTIVE) {
+        int sq = pop_lsb(&b);
+        columns[count++] = feature_column(ci, king, pos->squares[sq], sq);
+    }
+    kernels[simd_level].update(acc->values[ci], net->ft_biases, columns, count, NULL, 0);
+    acc->computed[ci] = 1;
+}
+
+// Function to derive one perspective of an accumulator from its parent's and the move between them
+static void apply_move(NnueAccumulator *acc, const NnueAccumulator *parent, const DirtyPieces *dirty,
+                       int ci, int king) {
+    const int16_t *add[3], *sub[3];
+    int add_count = 0, sub_count = 0;
+
+    for (int i = 0; i < dirty->count; i++) {
+        if (PIECE_TYPE(dirty->piece[i]) == KING) continue;
+        if (dirty->from[i] != SQ_NONE) sub[sub_count++] = feature_column(ci, king, dirty->piece[i], dirty->from[i]);
+        if (dirty->to[i] != SQ_NONE) add[add_count++] = feature_column(ci, king, dirty->piece[i], dirty->to[i]);
+    }
+    kernels[simd_level].update(acc->values[ci], parent->values[ci], add, add_count, sub, sub_count);
+    acc->computed[ci] = 1;
+}
+
+// Function to check if a move moved the king whose square a perspective's features depend on
+static inline int moves_king(const DirtyPieces *dirty, int ci) {
+    return PIECE_TYPE(dirty->piece[0]) == KING && COLOR_INDEX(PIECE_COLOR(dirty->piece[0])) == ci;
+}
+
+// Function to run the dense layers on an up-to-date accumulator; returns net units
+static int propagate(const NnueAccumulator *acc, int side) {
+    const Kernels *k = &kernels[simd_level];
+    _Alignas(32) uint8_t input[2 * NNUE_HALF_DIMS];
+    _Alignas(32) uint8_t hidden1[NNUE_HIDDEN];
+    _Alignas(32) uint8_t hidden2[NNUE_HIDDEN];
+    int32_t sums[NNUE_HIDDEN];
+    int us = COLOR_INDEX(side);
+
+    k->transform(acc->values[us], acc->values[us ^ 1], input);
+    k->affine(input, &net->l1_weights[0][0], 2 * NNUE_HALF_DIMS, NNUE_HIDDEN, sums);
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int32_t v = (net->l1_biases[i] + sums[i]) >> NNUE_WEIGHT_SHIFT;
+        hidden1[i] = (uint8_t)(v < 0 ? 0 : v > 127 ? 127 : v);
+    }
+    k->affine(hidden1, &net->l2_weights[0][0], NNUE_HIDDEN, NNUE_HIDDEN, sums);
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int32_t v = (net->l2_biases[i] + sums[i]) >> NNUE_WEIGHT_SHIFT;
+        hidden2[i] = (uint8_t)(v < 0 ? 0 : v > 127 ? 127 : v);
+    }
+    k->affine(hidden2, net->out_weights, NNUE_HIDDEN, 1, sums);
+    return (net->out_bias + sums[0]) / NNUE_FV_SCALE;
+}
+
+// Function to evaluate pos from the side to move's point of view, in centipawns.
+// acc[ply] belongs to pos; it is brought up to date from the nearest computed
+// ancestor by replaying dirty[], or refreshed when that is cheaper or impossible
+int nnue_evaluate(const Position *pos, NnueAccumulator *acc, const DirtyPieces *dirty, int ply) {
+    for (int ci = 0; ci < 2; ci++) {
+        if (acc[ply].computed[ci]) continue;
+
+        // Walk back to a computed ancestor; a move of this side's king changes every feature
+        int a = ply;
+        while (a > 0 && !acc[a].computed[ci] && !moves_king(&dirty[a], ci) && ply - a < NNUE_MAX_REPLAY) a--;
+        if (!acc[a].computed[ci]) {
+            refresh(pos, &acc[ply], ci);
+            continue;
+        }
+        int king = lsb(pos->by_color[ci] & pos->by_type[KING]);
+        for (int b = a + 1; b <= ply; b++) apply_move(&acc[b], &acc[b - 1], &dirty[b], ci, king);
+    }
+    return propagate(&acc[ply], pos->side) * 100 / NNUE_PAWN_VALUE;
+}
+
+// Function to evaluate pos with a full accumulator refresh
+int nnue_evaluate_full(const Position *pos) {
+    NnueAccumulator acc;
+
+    refresh(pos, &acc, 0);
+    refresh(pos, &acc, 1);
+    return propagate(&acc, pos->side) * 100 / NNUE_PAWN_VALUE;
+}
@@ -0,0 +1,73 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdint.h>
+#include "position.h"
+
+// HalfKP 256x2-32-32 network in the Stockfish 12 file format. Each side's half of the
+// first layer sees (own king square, piece, square) for every piece but the kings,
+// from its own point of view; the two halves go through two 32-wide layers to one output
+#define NNUE_HALF_DIMS 256
+#define NNUE_PS_END 641           // piece-square features per king square
+#define NNUE_INPUTS (64 * NNUE_PS_END)
+#define NNUE_HIDDEN 32
+#define NNUE_VERSION 0x7AF32F16
+#define NNUE_FV_SCALE 16          // output units per net unit
+#define NNUE_WEIGHT_SHIFT 6       // hidden layer sums are scaled down by 2^6
+#define NNUE_PAWN_VALUE 208       // net units per pawn
+
+// SIMD paths for the network kernels, best last
+#define NNUE_SCALAR 0
+#define NNUE_SSE41 1
+#define NNUE_AVX2 2
+
+// First-layer sums for both perspectives (indexed by color index) of one position
+typedef struct {
+    _Alignas(32) int16_t values[2][NNUE_HALF_DIMS];
+    int computed[2];
+} NnueAccumulator;
+
+// Pieces a move put on or took off the board: from is SQ_NONE for a piece that
+// appeared (promotion), to is SQ_NONE for one that left (capture)
+typedef struct {
+    int count;
+    int piece[3];
+    int from[3];
+    int to[3];
+} DirtyPieces;
+
+// Function to load a network file; returns 0 if it cannot be read or has the wrong shape,
+// in which case the network in use (if any) stays loaded
+int nnue_load(const char *path);
+
+// Function to build a network that reproduces the material and piece-square tables
+// (no file needed); lets the inference path run before a trained net is available
+void nnue_init_bootstrap(void);
+
+// Function to write the loaded network to a file in the same format; returns 1 on success
+int nnue_save(const char *path);
+
+// Function to check if a network is loaded
+int nnue_loaded(void);
+
+// Function to get the best SIMD path this CPU supports
+int nnue_best_simd(void);
+
+// Function to select the SIMD path (at most the best supported); returns the one in use
+int nnue_set_simd(int level);
+
+// Function to name a SIMD path
+const char *nnue_simd_name(int level);
+
+// Function to note what a legal move is about to change; call before make_move
+void nnue_record_move(const Position *pos, Move move, DirtyPieces *dirty);
+
+// Function to evaluate pos from the side to move's point of view, in centipawns.
+// acc[ply] belongs to pos; it is brought up to date from the nearest computed
+// ancestor by replaying dirty[], or refreshed when that is cheaper or impossible
+int nnue_evaluate(const Position *pos, NnueAccumulator *acc, const DirtyPieces *dirty, int ply);
+
+// Function to evaluate pos with a full accumulator refresh
+int nnue_evaluate_full(const Position *pos);
+
+#endif
@@ -0,0 +1,133 @@
+#include "pawns.h"
+#include "stats.h"
+
+#define DOUBLED_MG (-10)
+#define DOUBLED_EG (-20)
+#define ISOLATED_MG (-10)
+#define ISOLATED_EG (-15)
+#define BACKWARD_MG (-8)
+#define BACKWARD_EG (-12)
+#define SHIELD_ADVANCED (-10)   // shield pawn pushed one square
+#define SHIELD_MISSING (-25)    // no shield pawn close to the king on that file
+
+// Passed pawn bonus by rank counted from the pawn's own side (1 = second rank)
+static const int passed_mg[8] = {0, 0, 5, 10, 20, 35, 60, 0};
+static const int passed_eg[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+
+static Bitboard file_bb[8];
+static Bitboard adjacent_files_bb[8];
+static Bitboard forward_rows_bb[2][8];     // rows strictly ahead of a row, per color index
+static Bitboard forward_file_bb[2][64];    // squares ahead of a pawn on its own file
+static Bitboard passed_span_bb[2][64];     // squares ahead on its own and adjacent files
+static Bitboard support_span_bb[2][64];    // adjacent-file squares level with or behind a pawn
+
+// Function to build the pawn-structure masks; must run once before any evaluation
+void init_pawns(void) {
+    for (int c = 0; c < 8; c++) file_bb[c] = COL_A_BB << c;
+    for (int c = 0; c < 8; c++) {
+        adjacent_files_bb[c] = (c > 0 ? file_bb[c - 1] : 0) | (c < 7 ? file_bb[c + 1] : 0);
+    }
+
+    // White moves towards row 0, Black towards row 7
+    for (int r = 0; r < 8; r++) {
+        forward_rows_bb[0][r] = r > 0 ? ~0ULL >> (8 * (8 - r)) : 0;
+        forward_rows_bb[1][r] = r < 7 ? ~0ULL << (8 * (r + 1)) : 0;
+    }
+    for (int ci = 0; ci < 2; ci++) {
+        for (int sq = 0; sq < 64; sq++) {
+            int r = SQ_ROW(sq), c = SQ_COL(sq);
+            forward_file_bb[ci][sq] = forward_rows_bb[ci][r] & file_bb[c];
+            passed_span_bb[ci][sq] = forward_rows_bb[ci][r] & (file_bb[c] | adjacent_files_bb[c]);
+            support_span_bb[ci][sq] = ~forward_rows_bb[ci][r] & adjacent_files_bb[c];
+        }
+    }
+}
+
+// Function to score the pawns in front of a king on its file and the two next to it
+static int king_shield(const Position *pos, int ci, int ksq) {
+    Bitboard ours = pos->by_color[ci] & pos->by_type[PAWN];
+    int center = SQ_COL(ksq) < 1 ? 1 : SQ_COL(ksq) > 6 ? 6 : SQ_COL(ksq);
+    int score = 0;
+
+    for (int c = center - 1; c <= center + 1; c++) {
+        Bitboard front = ours & file_bb[c] & forward_rows_bb[ci][SQ_ROW(ksq)];
+        if (!front) {
+            score += SHIELD_MISSING;
+            continue;
+        }
+        // The shield pawn is the one closest to the king
+        int sq = ci == 0 ? 63 - __builtin_clzll(front) : lsb(front);
+        int distance = SQ_ROW(sq) > SQ_ROW(ksq) ? SQ_ROW(sq) - SQ_ROW(ksq) : SQ_ROW(ksq) - SQ_ROW(sq);
+        if (distance == 2) score += SHIELD_ADVANCED;
+        else if (distance > 2) score += SHIELD_MISSING;
+    }
+    return score;
+}
+
+// Function to recompute the shields of the kings that are not where the entry saw them
+static void update_shields(const Position *pos, PawnEntry *entry) {
+    for (int ci = 0; ci < 2; ci++) {
+        int ksq = lsb(pos->by_color[ci] & pos->by_type[KING]);
+        if (entry->king_square[ci] != ksq) {
+            entry->king_square[ci] = (int8_t)ksq;
+            entry->shield[ci] = (int16_t)king_shield(pos, ci, ksq);
+        }
+    }
+}
+
+// Function to evaluate the pawn structure and king shields of pos into entry
+void pawn_evaluate(const Position *pos, PawnEntry *entry) {
+    int mg[2] = {0, 0}, eg[2] = {0, 0};
+
+    entry->key = pos->pawn_key;
+    for (int ci = 0; ci < 2; ci++) {
+        Bitboard ours = pos->by_color[ci] & pos->by_type[PAWN];
+        Bitboard theirs = pos->by_color[ci ^ 1] & pos->by_type[PAWN];
+        Bitboard b = ours;
+
+        entry->passed[ci] = 0;
+        while (b) {
+            int sq = pop_lsb(&b);
+            int rank = ci == 0 ? 7 - SQ_ROW(sq) : SQ_ROW(sq);
+            int stop = sq + (ci == 0 ? -8 : 8);
+
+            // Only the rear pawn of a doubled pair is penalised, and only the front one can be passed
+            if (ours & forward_file_bb[ci][sq]) {
+                mg[ci] += DOUBLED_MG;
+                eg[ci] += DOUBLED_EG;
+            } else if (!(theirs & passed_span_bb[ci][sq])) {
+                entry->passed[ci] |= SQ_BB(sq);
+                mg[ci] += passed_mg[rank];
+                eg[ci] += passed_eg[rank];
+            }
+
+            if (!(ours & adjacent_files_bb[SQ_COL(sq)])) {
+                mg[ci] += ISOLATED_MG;
+                eg[ci] += ISOLATED_EG;
+            } else if (!(ours & support_span_bb[ci][sq]) && (pawn_attacks[ci][stop] & theirs)) {
+                // No neighbour can come up to defend it and it cannot advance safely
+                mg[ci] += BACKWARD_MG;
+                eg[ci] += BACKWARD_EG;
+            }
+        }
+    }
+    entry->mg = (int16_t)(mg[0] - mg[1]);
+    entry->eg = (int16_t)(eg[0] - eg[1]);
+    entry->king_square[0] = entry->king_square[1] = (int8_t)SQ_NONE;
+    update_shields(pos, entry);
+}
+
+// Function to get the entry for pos's pawns, evaluating them on a miss and
+// refreshing the shields of any king that moved since they were computed
+const PawnEntry *pawn_probe(PawnTable *table, const Position *pos) {
+    PawnEntry *entry = &table->entries[pos->pawn_key & (PAWN_TABLE_SIZE - 1)];
+
+    STAT_INC(table->probes);
+    if (entry->key == pos->pawn_key) {
+        STAT_INC(table->hits);
+        update_shields(pos, entry);
+    } else {
+        pawn_evaluate(pos, entry);
+    }
+    return entry;
+}
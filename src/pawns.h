@@ -0,0 +1,36 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "position.h"
+
+#define PAWN_TABLE_SIZE 16384   // entries per thread; must be a power of two
+
+// Pawn-structure evaluation of one pawn configuration, cached under the pawn key
+typedef struct {
+    uint64_t key;
+    Bitboard passed[2];       // passed pawns per color index
+    int16_t mg;               // doubled, isolated, backward and passed terms, White minus Black
+    int16_t eg;
+    int16_t shield[2];        // middlegame pawn shield in front of each king
+    int8_t king_square[2];    // king squares the shields were computed for
+} PawnEntry;
+
+// Pawn hash table; each search thread owns one, so it needs no locking. Entries
+// depend on the pawns alone and never go stale, so the table is never cleared
+typedef struct {
+    PawnEntry entries[PAWN_TABLE_SIZE];
+    uint64_t probes;          // counted only when search statistics are compiled in
+    uint64_t hits;
+} PawnTable;
+
+// Function to build the pawn-structure masks; must run once before any evaluation
+void init_pawns(void);
+
+// Function to evaluate the pawn structure and king shields of pos into entry
+void pawn_evaluate(const Position *pos, PawnEntry *entry);
+
+// Function to get the entry for pos's pawns, evaluating them on a miss and
+// refreshing the shields of any king that moved since they were computed
+const PawnEntry *pawn_probe(PawnTable *table, const Position *pos);
+
+#endif
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include "perft.h"
+#include "movegen.h"
+#include "book.h"
+#include "misc.h"
+
+typedef struct {
+    const char *name;
+    const char *fen;
+    uint64_t counts[7];   // expected leaf counts for depth 1, 2, ... (0 ends the list)
+} PerftCase;
+
+// Reference counts from the Chess Programming Wiki perft results page
+static const PerftCase perft_cases[] = {
+    {"startpos", START_FEN,
+     {20, 400, 8902, 197281, 4865609, 119060324, 0}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033, 0}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551, 0}},
+};
+
+// Function to count the leaf nodes of the legal move tree to a fixed depth
+uint64_t perft(Position *pos, int depth) {
+    MoveList list;
+    uint64_t nodes = 0;
+
+    generate_legal_moves(pos, &list);
+    if (depth <= 1) return depth == 1 ? (uint64_t)list.count : 1;
+
+    for (int i = 0; i < list.count; i++) {
+        make_move(pos, list.moves[i]);
+        nodes += perft(pos, depth - 1);
+        unmake_move(pos, list.moves[i]);
+    }
+    return nodes;
+}
+
+// Function to run perft and print the leaf count below each root move
+uint64_t perft_divide(Position *pos, int depth) {
+    MoveList list;
+    uint64_t total = 0;
+    char text[6];
+
+    generate_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        make_move(pos, list.moves[i]);
+        uint64_t nodes = depth > 1 ? perft(pos, depth - 1) : 1;
+        unmake_move(pos, list.moves[i]);
+        move_to_uci(list.moves[i], text);
+        printf("%s: %" PRIu64 "\n", text, nodes);
+        total += nodes;
+    }
+    printf("\nMoves: %d\n", list.count);
+    return total;
+}
+
+// Function to print the node count, elapsed time and speed of one run
+static void print_speed(uint64_t nodes, int64_t elapsed_ns) {
+    double seconds = elapsed_ns / 1e9;
+    printf("Nodes: %" PRIu64 "\n", nodes);
+    printf("Time: %.3f s\n", seconds);
+    printf("NPS: %.0f\n", seconds > 0 ? nodes / seconds : 0.0);
+}
+
+// Function to run perft or divide on a FEN and print time and nodes/sec
+int run_perft(const char *fen, int depth, int divide) {
+    Position pos;
+    if (!position_set_fen(&pos, fen)) {
+        printf("Invalid FEN: %s\n", fen);
+        return 1;
+    }
+
+    int64_t start = now_ns();
+    uint64_t nodes = divide ? perft_divide(&pos, depth) : perft(&pos, depth);
+    print_speed(nodes, now_ns() - start);
+    return 0;
+}
+
+// Function to check the standard perft positions up to max_depth; returns the failure count
+int run_perft_suite(int max_depth) {
+    uint64_t total_nodes = 0;
+    int failures = 0;
+    int64_t start = now_ns();
+
+    for (size_t i = 0; i < sizeof(perft_cases) / sizeof(perft_cases[0]); i++) {
+        const PerftCase *pc = &perft_cases[i];
+        Position pos;
+        position_set_fen(&pos, pc->fen);
+
+        for (int depth = 1; depth <= max_depth && depth <= 7 && pc->counts[depth - 1]; depth++) {
+            int64_t t0 = now_ns();
+            uint64_t nodes = perft(&pos, depth);
+            int64_t elapsed = now_ns() - t0;
+            int ok = nodes == pc->counts[depth - 1];
+
+            printf("%-10s depth %d: %12" PRIu64 " %s (%.0f nps)\n", pc->name, depth, nodes,
+                   ok ? "ok" : "FAILED", elapsed > 0 ? nodes * 1e9 / elapsed : 0.0);
+            if (!ok) {
+                printf("  expected %" PRIu64 "\n", pc->counts[depth - 1]);
+                failures++;
+            }
+            total_nodes += nodes;
+        }
+    }
+
+    // The book hashes positions its own way; check it against the published keys
+    int key_failures = book_check_keys();
+    printf("Polyglot keys: %s\n", key_failures ? "FAILED" : "ok");
+    failures += key_failures;
+
+    printf("\n%s, %d failure(s)\n", failures ? "Perft suite FAILED" : "Perft suite passed", failures);
+    print_speed(total_nodes, now_ns() - start);
+    return failures;
+}
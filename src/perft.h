@@ -0,0 +1,19 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <stdint.h>
+#include "position.h"
+
+// Function to count the leaf nodes of the legal move tree to a fixed depth
+uint64_t perft(Position *pos, int depth);
+
+// Function to run perft and print the leaf count below each root move
+uint64_t perft_divide(Position *pos, int depth);
+
+// Function to run perft or divide on a FEN and print time and nodes/sec
+int run_perft(const char *fen, int depth, int divide);
+
+// Function to check the standard perft positions up to max_depth; returns the failure count
+int run_perft_suite(int max_depth);
+
+#endif
@@ -0,0 +1,458 @@
+#define _GNU_SOURCE  // memrchr
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pgn.h"
+#include "movegen.h"
+#include "record.h"
+#include "misc.h"
+
+#define PGN_REPORTED_ERRORS 8     // per worker
+#define PGN_MAX_THREADS 64
+
+// A failed game, kept to be reported once the import is over
+typedef struct {
+    size_t offset;
+    int status;
+    char token[24];
+} PgnError;
+
+// Per-thread importer: one part of the file, its own board and its own record file
+typedef struct {
+    PgnReader reader;
+    Position pos;
+    PgnReplay replay;
+    RecordWriter records;
+    int writing;
+    uint64_t games;
+    uint64_t plies;
+    uint64_t illegal;
+    uint64_t malformed;
+    int64_t busy_ns;
+    int error_count;
+    PgnError errors[PGN_REPORTED_ERRORS];
+    pthread_t handle;
+} PgnWorker;
+
+static inline int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Function to map a PGN file for reading; returns 1 on success
+int pgn_open(PgnReader *r, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    memset(r, 0, sizeof(*r));
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Could not open PGN file %s\n", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Could not map PGN file %s\n", path);
+        return 0;
+    }
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    r->data = data;
+    r->size = (size_t)st.st_size;
+    r->end = r->size;
+    // A UTF-8 byte order mark is not part of the first game
+    if (r->size >= 3 && memcmp(r->data, "\xEF\xBB\xBF", 3) == 0) r->offset = 3;
+    return 1;
+}
+
+// Function to unmap a PGN file
+void pgn_close(PgnReader *r) {
+    if (r->data) munmap((void *)r->data, r->size);
+    r->data = NULL;
+}
+
+// Function to check if the line before the one starting at offset opens with '['
+static int follows_tag_line(const PgnReader *r, size_t offset) {
+    if (offset < 2) return 0;
+    const char *line = memrchr(r->data, '\n', offset - 1);
+    size_t start = line ? (size_t)(line - r->data) + 1 : 0;
+    return r->data[start] == '[';
+}
+
+// Function to cut the file into parts at game starts: part i runs from bounds[i] to
+// bounds[i + 1], so bounds needs parts + 1 entries. A game starts at a line opening with
+// '[' that does not follow another such line
+void pgn_split(const PgnReader *r, int parts, size_t *bounds) {
+    bounds[0] = r->offset;
+    bounds[parts] = r->end;
+    for (int i = 1; i < parts; i++) {
+        size_t at = r->offset + (r->end - r->offset) / (size_t)parts * (size_t)i;
+        if (at < bounds[i - 1]) at = bounds[i - 1];
+
+        // Step from line start to line start until one opens a game
+        bounds[i] = r->end;
+        while (at < r->end) {
+            const char *nl = memchr(r->data + at, '\n', r->end - at);
+            if (!nl) break;
+            at = (size_t)(nl - r->data) + 1;
+            if (at < r->end && r->data[at] == '[' && !follows_tag_line(r, at)) {
+                bounds[i] = at;
+                break;
+            }
+        }
+    }
+}
+
+// Function to read one "[Name "value"]" line into a tag; returns 0 if it has no name
+static int parse_tag(const char *p, const char *line_end, PgnTag *tag) {
+    p++;
+    while (p < line_end && is_blank(*p)) p++;
+    tag->name = p;
+    while (p < line_end && !is_blank(*p) && *p != '"' && *p != ']') p++;
+    tag->name_length = (int)(p - tag->name);
+    while (p < line_end && *p != '"') p++;
+    if (p == line_end) {
+        tag->value = p;
+        tag->value_length = 0;
+        return tag->name_length > 0;
+    }
+    tag->value = ++p;
+    while (p < line_end && *p != '"') p += *p == '\\' ? 2 : 1;
+    if (p > line_end) p = line_end;
+    tag->value_length = (int)(p - tag->value);
+    return tag->name_length > 0;
+}
+
+// Function to step to the next game; returns 1 on a game and 0 at the end. The movetext
+// runs to the next game start, so a comment holding a line that opens with '[' splits it
+int pgn_next_game(PgnReader *r, PgnGame *game) {
+    const char *data = r->data;
+    size_t p = r->offset, end = r->end;
+
+    while (p < end && is_blank(data[p])) p++;
+    if (p >= end) {
+        r->offset = end;
+        return 0;
+    }
+
+    game->text = data + p;
+    game->tag_count = 0;
+    while (p < end && data[p] == '[') {
+        const char *nl = memchr(data + p, '\n', end - p);
+        const char *line_end = nl ? nl : data + end;
+        if (game->tag_count < PGN_MAX_TAGS && parse_tag(data + p, line_end, &game->tags[game->tag_count])) {
+            game->tag_count++;
+        }
+        p = (size_t)(line_end - data);
+        while (p < end && is_blank(data[p])) p++;
+    }
+
+    // Tags and movetext are parsed elsewhere; here the game only has to be delimited
+    game->movetext = data + p;
+    while (p < end) {
+        const char *nl = memchr(data + p, '\n', end - p);
+        if (!nl) {
+            p = end;
+            break;
+        }
+        p = (size_t)(nl - data) + 1;
+        if (p < end && data[p] == '[') break;
+    }
+    game->movetext_length = (size_t)(data + p - game->movetext);
+    game->length = (size_t)(data + p - game->text);
+    r->offset = p;
+    return 1;
+}
+
+// Function to find a tag by name; NULL if the game does not have it
+const PgnTag *pgn_find_tag(const PgnGame *game, const char *name) {
+    int length = (int)strlen(name);
+    for (int i = 0; i < game->tag_count; i++) {
+        if (game->tags[i].name_length == length && memcmp(game->tags[i].name, name, length) == 0) return &game->tags[i];
+    }
+    return NULL;
+}
+
+// Function to read a game termination marker; returns its RESULT_* code and its length
+// through length, or -1 if the text does not start with one
+static int parse_result(const char *p, const char *end, int *length) {
+    int result = -1, n = 0;
+
+    // Move numbers reach here too, so the first byte decides quickly
+    if (p[0] == '*') result = RESULT_UNKNOWN, n = 1;
+    else if (end - p >= 3 && p[0] == '0' && p[1] == '-' && p[2] == '1') result = RESULT_BLACK_WINS, n = 3;
+    else if (end - p >= 3 && p[0] == '1' && p[1] == '-' && p[2] == '0') result = RESULT_WHITE_WINS, n = 3;
+    else if (end - p >= 7 && p[0] == '1' && memcmp(p, "1/2-1/2", 7) == 0) result = RESULT_DRAW, n = 7;
+    if (result < 0 || (end - p > n && !is_blank(p[n]) && p[n] != '{')) return -1;
+    *length = n;
+    return result;
+}
+
+static Position standard_position;
+
+// Function to set up the standard start position once, for set_start_position to copy
+static void set_standard_position(void) {
+    position_set_fen(&standard_position, START_FEN);
+}
+
+// Function to set up a game's start position: its FEN tag, else the standard one;
+// returns 0 on a bad FEN
+static int set_start_position(const PgnGame *game, Position *pos) {
+    static pthread_once_t standard_once = PTHREAD_ONCE_INIT;
+    const PgnTag *fen = pgn_find_tag(game, "FEN");
+    char buf[128];
+
+    if (!fen) {
+        // Copying the set-up start position is cheaper than parsing its FEN every game;
+        // the undo stack is empty there, so it is left out
+        pthread_once(&standard_once, set_standard_position);
+        memcpy(pos, &standard_position, offsetof(Position, history));
+        return 1;
+    }
+    if (fen->value_length >= (int)sizeof(buf)) return 0;
+    memcpy(buf, fen->value, fen->value_length);
+    buf[fen->value_length] = '\0';
+    return position_set_fen(pos, buf);
+}
+
+// Function to note where a replay stopped and why; returns the status
+static int replay_error(PgnReplay *replay, const char *token, const char *end, int status) {
+    const char *p = token;
+    while (p < end && !is_blank(*p)) p++;
+    replay->error = token;
+    replay->error_length = (int)(p - token);
+    return status;
+}
+
+// Function to play the SAN move at *p and step past it; returns PGN_OK or the failure
+static int play_san(Position *pos, PgnReplay *replay, const char **p, const char *end) {
+    const char *token = *p, *q = token;
+
+    while (q < end && !is_blank(*q) && *q != '{' && *q != '(' && *q != ')' && *q != ';' && *q != '$') q++;
+    Move move = parse_san_move(pos, token, (int)(q - token));
+    if (move == MOVE_NONE) return replay_error(replay, token, end, PGN_ILLEGAL);
+    if (replay->ply_count == PGN_MAX_PLIES) return replay_error(replay, token, end, PGN_MALFORMED);
+    replay->moves[replay->ply_count++] = move;
+    // Keep room in the undo stack: nothing here ever unmakes a move
+    if (pos->game_ply >= MAX_GAME_PLY - 1) position_compact_history(pos);
+    make_move(pos, move);
+    *p = q;
+    return PGN_OK;
+}
+
+// Function to play a game's moves from its start position (the FEN tag, else the
+// standard one) into pos and replay; returns PGN_OK, PGN_ILLEGAL or PGN_MALFORMED
+int pgn_replay(const PgnGame *game, Position *pos, PgnReplay *replay) {
+    const char *p = game->movetext, *end = p + game->movetext_length;
+    const PgnTag *tag = pgn_find_tag(game, "Result");
+    int length;
+
+    replay->ply_count = 0;
+    replay->result = RESULT_UNKNOWN;
+    replay->error = NULL;
+    replay->error_length = 0;
+    if (tag) {
+        int result = parse_result(tag->value, tag->value + tag->value_length, &length);
+        if (result >= 0) replay->result = result;
+    }
+    if (!set_start_position(game, pos)) {
+        const PgnTag *fen = pgn_find_tag(game, "FEN");
+        return replay_error(replay, fen->value, fen->value + fen->value_length, PGN_MALFORMED);
+    }
+
+    while (p < end) {
+        char c = *p;
+        if (is_blank(c)) {
+            p++;
+        } else if (c == '{') {
+            // Comments do not nest
+            const char *close = memchr(p, '}', end - p);
+            if (!close) return replay_error(replay, p, end, PGN_MALFORMED);
+            p = close + 1;
+        } else if (c == ';' || (c == '%' && (p == game->movetext || p[-1] == '\n'))) {
+            // Rest-of-line comment or escaped line
+            const char *nl = memchr(p, '\n', end - p);
+            p = nl ? nl + 1 : end;
+        } else if (c == '(') {
+            // Variations are skipped with everything nested in them
+            const char *start = p;
+            int depth = 0;
+            for (; p < end; p++) {
+                if (*p == '{') {
+                    const char *close = memchr(p, '}', end - p);
+                    if (!close) break;
+                    p = close;
+                } else if (*p == '(') {
+                    depth++;
+                } else if (*p == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            if (p >= end) return replay_error(replay, start, end, PGN_MALFORMED);
+            p++;
+        } else if (c == '$') {
+            // Numeric annotation glyph
+            for (p++; p < end && *p >= '0' && *p <= '9'; p++);
+        } else if ((c >= '0' && c <= '9') || c == '*') {
+            int result = parse_result(p, end, &length);
+            if (result >= 0) {
+                // The termination marker ends the game; what follows belongs to nobody
+                replay->result = result;
+                return PGN_OK;
+            }
+            if (c == '0' && p + 1 < end && p[1] == '-') {
+                // Castling written with zeros
+                int status = play_san(pos, replay, &p, end);
+                if (status != PGN_OK) return status;
+                continue;
+            }
+            // Move number, with or without its dots
+            for (; p < end && *p >= '0' && *p <= '9'; p++);
+            for (; p < end && *p == '.'; p++);
+        } else if (c == 'e' && replay->ply_count && end - p >= 4 && memcmp(p, "e.p.", 4) == 0 &&
+                   (end - p == 4 || is_blank(p[4]))) {
+            // En passant suffix after a capture ("exd6 e.p."); the move says it all
+            p += 4;
+        } else if ((c >= 'a' && c <= 'h') || c == 'N' || c == 'B' || c == 'R' || c == 'Q' || c == 'K' || c == 'O') {
+            int status = play_san(pos, replay, &p, end);
+            if (status != PGN_OK) return status;
+        } else {
+            return replay_error(replay, p, end, PGN_MALFORMED);
+        }
+    }
+    // A game cut off without a termination marker still counts; its result is the tag's
+    return PGN_OK;
+}
+
+// Function to replay every game of one worker's part of the file
+static void *import_worker(void *arg) {
+    PgnWorker *w = arg;
+    PgnGame game;
+    Position start;
+    int64_t begin = now_ns();
+
+    while (pgn_next_game(&w->reader, &game)) {
+        int status = pgn_replay(&game, &w->pos, &w->replay);
+        w->games++;
+        w->plies += (uint64_t)w->replay.ply_count;
+        if (status == PGN_OK) {
+            if (w->writing && set_start_position(&game, &start)) {
+                record_write_game(&w->records, &start, w->replay.moves, w->replay.ply_count, w->replay.result);
+            }
+            continue;
+        }
+
+        if (status == PGN_ILLEGAL) w->illegal++;
+        else w->malformed++;
+        if (w->error_count < PGN_REPORTED_ERRORS) {
+            PgnError *e = &w->errors[w->error_count++];
+            int n = w->replay.error_length < (int)sizeof(e->token) - 1 ? w->replay.error_length : (int)sizeof(e->token) - 1;
+            e->offset = (size_t)(game.text - w->reader.data);
+            e->status = status;
+            memcpy(e->token, w->replay.error, n);
+            e->token[n] = '\0';
+        }
+    }
+    w->busy_ns = now_ns() - begin;
+    return NULL;
+}
+
+// Function to append the games of a part's record file to the first part's, then delete it
+static int append_records(const char *path, const char *part_path) {
+    FILE *out = fopen(path, "ab");
+    FILE *in = fopen(part_path, "rb");
+    char buf[1 << 16];
+    size_t n;
+    int ok = out && in && fseek(in, RECORD_HEADER_SIZE, SEEK_SET) == 0;
+
+    while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0) ok = fwrite(buf, 1, n, out) == n;
+    if (in) fclose(in);
+    if (out && fclose(out) != 0) ok = 0;
+    remove(part_path);
+    return ok;
+}
+
+// Function to replay every game of a PGN file on a pool of threads, counting illegal
+// and malformed games and optionally writing the good ones as game records; returns
+// the process exit code
+int run_pgn_import(const char *path, int threads, const char *records_path) {
+    PgnReader r;
+    PgnWorker *workers;
+    size_t bounds[PGN_MAX_THREADS + 1];
+    char part_path[PGN_MAX_THREADS][512];
+    uint64_t games = 0, plies = 0, illegal = 0, malformed = 0;
+    int64_t busy_ns = 0;
+    int ok = 1;
+
+    if (threads < 1) threads = 1;
+    if (threads > PGN_MAX_THREADS) threads = PGN_MAX_THREADS;
+    if (!pgn_open(&r, path)) return 1;
+    workers = calloc((size_t)threads, sizeof(PgnWorker));
+    if (!workers) {
+        pgn_close(&r);
+        return 1;
+    }
+
+    int64_t start = now_ns();
+    pgn_split(&r, threads, bounds);
+    for (int i = 0; i < threads; i++) {
+        PgnWorker *w = &workers[i];
+        w->reader = r;
+        w->reader.offset = bounds[i];
+        w->reader.end = bounds[i + 1];
+        if (records_path) {
+            // Each part writes its own file; they are joined in file order at the end
+            if (i == 0) snprintf(part_path[i], sizeof(part_path[i]), "%s", records_path);
+            else snprintf(part_path[i], sizeof(part_path[i]), "%s.part%d", records_path, i);
+            if (!record_writer_open(&w->records, part_path[i], RECORD_GAMES)) {
+                printf("Could not create %s\n", part_path[i]);
+                ok = 0;
+                break;
+            }
+            w->writing = 1;
+        }
+    }
+    for (int i = 0; ok && i < threads; i++) pthread_create(&workers[i].handle, NULL, import_worker, &workers[i]);
+    for (int i = 0; ok && i < threads; i++) pthread_join(workers[i].handle, NULL);
+    for (int i = 0; i < threads; i++) {
+        if (workers[i].writing && !record_writer_close(&workers[i].records)) ok = 0;
+    }
+    for (int i = 1; records_path && ok && i < threads; i++) ok = append_records(records_path, part_path[i]);
+    double seconds = (now_ns() - start) / 1e9;
+
+    for (int i = 0; i < threads; i++) {
+        PgnWorker *w = &workers[i];
+        games += w->games;
+        plies += w->plies;
+        illegal += w->illegal;
+        malformed += w->malformed;
+        busy_ns += w->busy_ns;
+        for (int e = 0; e < w->error_count; e++) {
+            printf("%s game at byte %zu: %s \"%s\"\n", w->errors[e].status == PGN_ILLEGAL ? "Illegal" : "Malformed",
+                   w->errors[e].offset, w->errors[e].status == PGN_ILLEGAL ? "no single legal move matches" : "cannot read",
+                   w->errors[e].token);
+        }
+    }
+
+    printf("Games: %" PRIu64 " (%" PRIu64 " illegal, %" PRIu64 " malformed), plies: %" PRIu64 "\n", games, illegal,
+           malformed, plies);
+    printf("Time: %.3f s on %d threads, %.0f games/s, %.0f games/s per thread, %.1f M plies/s, %.1f MB/s\n", seconds,
+           threads, seconds > 0 ? games / seconds : 0.0, busy_ns > 0 ? games * 1e9 / busy_ns : 0.0,
+           seconds > 0 ? plies / seconds / 1e6 : 0.0, seconds > 0 ? r.size / seconds / 1e6 : 0.0);
+    if (records_path && ok) printf("Wrote %" PRIu64 " game records to %s\n", games - illegal - malformed, records_path);
+
+    pgn_close(&r);
+    free(workers);
+    return ok && !illegal && !malformed ? 0 : 1;
+}
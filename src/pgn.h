@@ -0,0 +1,77 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <stddef.h>
+#include "position.h"
+
+#define PGN_MAX_TAGS 32
+#define PGN_MAX_PLIES 4096
+
+// Replay outcomes
+#define PGN_OK 0
+#define PGN_ILLEGAL 1             // a move matches no legal move, or more than one
+#define PGN_MALFORMED 2           // bad FEN, unknown token, unbalanced comment or variation, too long
+
+// One tag pair; both strings point into the mapped file and are not terminated
+typedef struct {
+    const char *name;
+    const char *value;        // escapes are left as they are
+    int name_length;
+    int value_length;
+} PgnTag;
+
+// One game inside a mapped file; nothing is copied
+typedef struct {
+    const char *text;         // the whole game, tags included
+    size_t length;
+    PgnTag tags[PGN_MAX_TAGS];  // tags past PGN_MAX_TAGS are skipped
+    int tag_count;
+    const char *movetext;
+    size_t movetext_length;
+} PgnGame;
+
+// Read-only view of a mapped PGN file, or of the games between offset and end
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t offset;            // next game
+    size_t end;
+} PgnReader;
+
+// A replayed game: the moves in the engine's encoding, up to the first bad token
+typedef struct {
+    Move moves[PGN_MAX_PLIES];
+    int ply_count;
+    int result;               // RESULT_* from the termination marker, else from the Result tag
+    const char *error;        // the token the replay stopped at, when it failed
+    int error_length;
+} PgnReplay;
+
+// Function to map a PGN file for reading; returns 1 on success
+int pgn_open(PgnReader *r, const char *path);
+
+// Function to unmap a PGN file
+void pgn_close(PgnReader *r);
+
+// Function to cut the file into parts at game starts: part i runs from bounds[i] to
+// bounds[i + 1], so bounds needs parts + 1 entries. A game starts at a line opening with
+// '[' that does not follow another such line
+void pgn_split(const PgnReader *r, int parts, size_t *bounds);
+
+// Function to step to the next game; returns 1 on a game and 0 at the end. The movetext
+// runs to the next game start, so a comment holding a line that opens with '[' splits it
+int pgn_next_game(PgnReader *r, PgnGame *game);
+
+// Function to find a tag by name; NULL if the game does not have it
+const PgnTag *pgn_find_tag(const PgnGame *game, const char *name);
+
+// Function to play a game's moves from its start position (the FEN tag, else the
+// standard one) into pos and replay; returns PGN_OK, PGN_ILLEGAL or PGN_MALFORMED
+int pgn_replay(const PgnGame *game, Position *pos, PgnReplay *replay);
+
+// Function to replay every game of a PGN file on a pool of threads, counting illegal
+// and malformed games and optionally writing the good ones as game records; returns
+// the process exit code
+int run_pgn_import(const char *path, int threads, const char *records_path);
+
+#endif
@@ -0,0 +1,537 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+#include <ctype.h>
+#include "position.h"
+#include "eval.h"
+
+static const char piece_chars[] = " PNBRQK";
+
+const int piece_value[7] = {0, 100, 320, 330, 500, 900, 0};
+
+// Zobrist keys, indexed by piece code so no remapping is needed
+static uint64_t zobrist_psq[24][64];
+static uint64_t zobrist_castling[16];
+static uint64_t zobrist_ep[8];
+static uint64_t zobrist_side;
+static uint64_t zobrist_no_pawns;   // pawn key of a board without pawns, so it is never 0
+
+// Function to seed the Zobrist keys; must run once before any position is set up
+void init_zobrist(void) {
+    uint64_t state = 1070372ULL;
+    for (int i = 0; i < 24 * 64 + 16 + 8 + 2; i++) {
+        // xorshift64* keeps the keys identical from run to run
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        uint64_t key = state * 2685821657736338717ULL;
+        if (i < 24 * 64) zobrist_psq[i / 64][i % 64] = key;
+        else if (i < 24 * 64 + 16) zobrist_castling[i - 24 * 64] = key;
+        else if (i < 24 * 64 + 24) zobrist_ep[i - 24 * 64 - 16] = key;
+        else if (i == 24 * 64 + 24) zobrist_side = key;
+        else zobrist_no_pawns = key;
+    }
+}
+
+// Function to get the castling rights kept after a move from or to a square
+static int castling_rights_kept(int sq) {
+    switch (sq) {
+        case 0: return ~CASTLE_BQ;
+        case 4: return ~(CASTLE_BK | CASTLE_BQ);
+        case 7: return ~CASTLE_BK;
+        case 56: return ~CASTLE_WQ;
+        case 60: return ~(CASTLE_WK | CASTLE_WQ);
+        case 63: return ~CASTLE_WK;
+        default: return ~0;
+    }
+}
+
+// Function to reset a position to an empty board
+void position_clear(Position *pos) {
+    // The history is only read below game_ply, so the large undo stack is left alone
+    memset(pos, 0, offsetof(Position, history));
+    pos->side = WHITE;
+    pos->ep_square = SQ_NONE;
+    pos->fullmove = 1;
+    pos->pawn_key = zobrist_no_pawns;
+}
+
+// Function to place a piece on an empty square
+void position_put_piece(Position *pos, int piece, int sq) {
+    Bitboard b = SQ_BB(sq);
+    int ci = COLOR_INDEX(PIECE_COLOR(piece));
+    pos->squares[sq] = piece;
+    pos->by_type[0] |= b;
+    pos->by_type[PIECE_TYPE(piece)] |= b;
+    pos->by_color[ci] |= b;
+    pos->key ^= zobrist_psq[piece][sq];
+    if (PIECE_TYPE(piece) == PAWN) pos->pawn_key ^= zobrist_psq[piece][sq];
+    pos->material[ci] += piece_value[PIECE_TYPE(piece)];
+    pos->psq_mg += psq_mg[piece][sq];
+    pos->psq_eg += psq_eg[piece][sq];
+    pos->phase += phase_weight[PIECE_TYPE(piece)];
+}
+
+// Function to remove the piece standing on a square
+void position_remove_piece(Position *pos, int sq) {
+    int piece = pos->squares[sq];
+    Bitboard b = SQ_BB(sq);
+    int ci = COLOR_INDEX(PIECE_COLOR(piece));
+    pos->squares[sq] = EMPTY;
+    pos->by_type[0] &= ~b;
+    pos->by_type[PIECE_TYPE(piece)] &= ~b;
+    pos->by_color[ci] &= ~b;
+    pos->key ^= zobrist_psq[piece][sq];
+    if (PIECE_TYPE(piece) == PAWN) pos->pawn_key ^= zobrist_psq[piece][sq];
+    pos->material[ci] -= piece_value[PIECE_TYPE(piece)];
+    pos->psq_mg -= psq_mg[piece][sq];
+    pos->psq_eg -= psq_eg[piece][sq];
+    pos->phase -= phase_weight[PIECE_TYPE(piece)];
+}
+
+// Function to move a piece to an empty square
+static void move_piece(Position *pos, int from, int to) {
+    int piece = pos->squares[from];
+    Bitboard b = SQ_BB(from) | SQ_BB(to);
+    pos->squares[from] = EMPTY;
+    pos->squares[to] = piece;
+    pos->by_type[0] ^= b;
+    pos->by_type[PIECE_TYPE(piece)] ^= b;
+    pos->by_color[COLOR_INDEX(PIECE_COLOR(piece))] ^= b;
+    pos->key ^= zobrist_psq[piece][from] ^ zobrist_psq[piece][to];
+    if (PIECE_TYPE(piece) == PAWN) pos->pawn_key ^= zobrist_psq[piece][from] ^ zobrist_psq[piece][to];
+    pos->psq_mg += psq_mg[piece][to] - psq_mg[piece][from];
+    pos->psq_eg += psq_eg[piece][to] - psq_eg[piece][from];
+}
+
+// Function to check if a pawn of the given color could capture on an en passant square
+static int ep_capturable(const Position *pos, int ep_square, int color) {
+    return (pawn_attacks[COLOR_INDEX(OPPONENT(color))][ep_square] & pieces_of(pos, color, PAWN)) != 0;
+}
+
+// Function to find the checkers and pinned pieces for the side to move, once per node
+static void compute_check_info(Position *pos) {
+    int us = pos->side;
+    int ksq = king_square(pos, us);
+    Bitboard them = pos->by_color[COLOR_INDEX(us) ^ 1];
+    Bitboard occ = occupied_bb(pos);
+
+    pos->checkers = attackers_to(pos, ksq, occ) & them;
+    pos->pinned = 0;
+
+    // Enemy sliders that would hit the king on an empty board
+    Bitboard snipers = ((rook_attacks(ksq, 0) & (pos->by_type[ROOK] | pos->by_type[QUEEN]))
+                      | (bishop_attacks(ksq, 0) & (pos->by_type[BISHOP] | pos->by_type[QUEEN]))) & them;
+    while (snipers) {
+        Bitboard blockers = between_bb[ksq][pop_lsb(&snipers)] & occ;
+        if (blockers && !more_than_one(blockers)) pos->pinned |= blockers & pos->by_color[COLOR_INDEX(us)];
+    }
+}
+
+// Function to complete a cleared position whose pieces were placed with position_put_piece and
+// whose side, castling, en passant and clock fields were set directly
+void position_finish_setup(Position *pos) {
+    // Only keep an en passant square that can actually be captured, as make_move does
+    if (pos->ep_square != SQ_NONE && !ep_capturable(pos, pos->ep_square, pos->side)) pos->ep_square = SQ_NONE;
+
+    // position_put_piece already keyed the pieces; add the rest of the state
+    pos->key ^= zobrist_castling[pos->castling];
+    if (pos->ep_square != SQ_NONE) pos->key ^= zobrist_ep[SQ_COL(pos->ep_square)];
+    if (pos->side == BLACK) pos->key ^= zobrist_side;
+    compute_check_info(pos);
+}
+
+// Function to compute the Zobrist key from scratch (used to verify the incremental key)
+uint64_t position_compute_key(const Position *pos) {
+    uint64_t key = zobrist_castling[pos->castling];
+    for (int sq = 0; sq < 64; sq++) {
+        if (pos->squares[sq] != EMPTY) key ^= zobrist_psq[pos->squares[sq]][sq];
+    }
+    if (pos->ep_square != SQ_NONE) key ^= zobrist_ep[SQ_COL(pos->ep_square)];
+    if (pos->side == BLACK) key ^= zobrist_side;
+    return key;
+}
+
+// Function to compute the pawn key from scratch (used to verify the incremental pawn key)
+uint64_t position_compute_pawn_key(const Position *pos) {
+    uint64_t key = zobrist_no_pawns;
+    Bitboard pawns = pos->by_type[PAWN];
+    while (pawns) {
+        int sq = pop_lsb(&pawns);
+        key ^= zobrist_psq[pos->squares[sq]][sq];
+    }
+    return key;
+}
+
+// Function to format a square as algebraic text ("e4"); buf needs 3 bytes
+void square_name(int sq, char *buf) {
+    buf[0] = (char)('a' + SQ_COL(sq));
+    buf[1] = (char)('8' - SQ_ROW(sq));
+    buf[2] = '\0';
+}
+
+// Function to parse algebraic square text; returns SQ_NONE on failure
+int parse_square(const char *s) {
+    if (s[0] < 'a' || s[0] > 'h' || s[1] < '1' || s[1] > '8') return SQ_NONE;
+    return SQUARE('8' - s[1], s[0] - 'a');
+}
+
+// Function to load a FEN string; returns 1 on success, 0 on a malformed FEN
+int position_set_fen(Position *pos, const char *fen) {
+    const char *p = fen;
+    int r = 0, c = 0;
+
+    position_clear(pos);
+    while (*p == ' ') p++;
+
+    // Piece placement, rank 8 first, which is row 0 of the board array
+    for (; *p && *p != ' '; p++) {
+        if (*p == '/') {
+            if (c != 8) return 0;
+            r++;
+            c = 0;
+        } else if (*p >= '1' && *p <= '8') {
+            c += *p - '0';
+            if (c > 8) return 0;
+        } else {
+            const char *found = strchr(piece_chars, toupper((unsigned char)*p));
+            if (!found || *p == ' ' || r > 7 || c > 7) return 0;
+            int color = isupper((unsigned char)*p) ? WHITE : BLACK;
+            position_put_piece(pos, color | (int)(found - piece_chars), SQUARE(r, c));
+            c++;
+        }
+    }
+    if (r != 7 || c != 8) return 0;
+    if (popcount(pieces_of(pos, WHITE, KING)) != 1 || popcount(pieces_of(pos, BLACK, KING)) != 1) return 0;
+
+    // Side to move
+    while (*p == ' ') p++;
+    if (*p == 'w') pos->side = WHITE;
+    else if (*p == 'b') pos->side = BLACK;
+    else return 0;
+    p++;
+
+    // Castling rights
+    while (*p == ' ') p++;
+    for (; *p && *p != ' '; p++) {
+        switch (*p) {
+            case 'K': pos->castling |= CASTLE_WK; break;
+            case 'Q': pos->castling |= CASTLE_WQ; break;
+            case 'k': pos->castling |= CASTLE_BK; break;
+            case 'q': pos->castling |= CASTLE_BQ; break;
+            case '-': break;
+            default: return 0;
+        }
+    }
+
+    // En passant square
+    while (*p == ' ') p++;
+    if (*p && *p != '-') {
+        pos->ep_square = parse_square(p);
+        if (pos->ep_square == SQ_NONE) return 0;
+        p += 2;
+    } else if (*p) {
+        p++;
+    }
+
+    // Clocks are optional in EPD-style input
+    int halfmove = 0, fullmove = 1;
+    if (sscanf(p, "%d %d", &halfmove, &fullmove) >= 1) {
+        pos->halfmove = halfmove;
+        pos->fullmove = fullmove > 0 ? fullmove : 1;
+    }
+    position_finish_setup(pos);
+    return 1;
+}
+
+// Function to write the position as a FEN string into buf
+void position_get_fen(const Position *pos, char *buf, int size) {
+    char fen[128];
+    int n = 0;
+
+    for (int r = 0; r < 8; r++) {
+        int empty = 0;
+        for (int c = 0; c < 8; c++) {
+            int piece = pos->squares[SQUARE(r, c)];
+            if (piece == EMPTY) {
+                empty++;
+                continue;
+            }
+            if (empty) fen[n++] = (char)('0' + empty);
+            empty = 0;
+            char ch = piece_chars[PIECE_TYPE(piece)];
+            fen[n++] = (PIECE_COLOR(piece) == WHITE) ? ch : (char)tolower(ch);
+        }
+        if (empty) fen[n++] = (char)('0' + empty);
+        if (r < 7) fen[n++] = '/';
+    }
+    fen[n++] = ' ';
+    fen[n++] = (pos->side == WHITE) ? 'w' : 'b';
+    fen[n++] = ' ';
+    if (pos->castling & CASTLE_WK) fen[n++] = 'K';
+    if (pos->castling & CASTLE_WQ) fen[n++] = 'Q';
+    if (pos->castling & CASTLE_BK) fen[n++] = 'k';
+    if (pos->castling & CASTLE_BQ) fen[n++] = 'q';
+    if (!pos->castling) fen[n++] = '-';
+    fen[n++] = ' ';
+    if (pos->ep_square != SQ_NONE) {
+        square_name(pos->ep_square, fen + n);
+        n += 2;
+    } else {
+        fen[n++] = '-';
+    }
+    fen[n] = '\0';
+    snprintf(buf, (size_t)size, "%s %d %d", fen, pos->halfmove, pos->fullmove);
+}
+
+// Function to load a position from a board[8][8] array
+void position_from_board(Position *pos, const int board[8][8], int side) {
+    position_clear(pos);
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board[r][c] != EMPTY) position_put_piece(pos, board[r][c], SQUARE(r, c));
+        }
+    }
+    pos->side = side;
+    position_finish_setup(pos);
+}
+
+// Function to write the mailbox back into a board[8][8] array
+void position_to_board(const Position *pos, int board[8][8]) {
+    for (int sq = 0; sq < 64; sq++) {
+        board[SQ_ROW(sq)][SQ_COL(sq)] = pos->squares[sq];
+    }
+}
+
+// Function to play a legal move, pushing its undo record onto pos->history, which
+// must not be full (game_ply below MAX_GAME_PLY)
+void make_move(Position *pos, Move move) {
+    int us = pos->side;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int kind = MOVE_KIND(move);
+    int piece = pos->squares[from];
+    assert(pos->game_ply < MAX_GAME_PLY);
+    UndoInfo *undo = &pos->history[pos->game_ply++];
+
+    undo->key = pos->key;
+    undo->checkers = pos->checkers;
+    undo->pinned = pos->pinned;
+    undo->halfmove = (uint16_t)pos->halfmove;
+    undo->castling = (uint8_t)pos->castling;
+    undo->ep_square = (int8_t)pos->ep_square;
+    undo->captured = (uint8_t)pos->squares[to];
+
+    pos->halfmove++;
+    if (pos->ep_square != SQ_NONE) {
+        pos->key ^= zobrist_ep[SQ_COL(pos->ep_square)];
+        pos->ep_square = SQ_NONE;
+    }
+
+    if (kind == MOVE_CASTLING) {
+        int rook_from = (to > from) ? from + 3 : from - 4;
+        int rook_to = (to > from) ? from + 1 : from - 1;
+        move_piece(pos, from, to);
+        move_piece(pos, rook_from, rook_to);
+    } else {
+        if (kind == MOVE_EN_PASSANT) {
+            int capture_sq = to + ((us == WHITE) ? 8 : -8);
+            undo->captured = (uint8_t)pos->squares[capture_sq];
+            position_remove_piece(pos, capture_sq);
+        } else if (undo->captured != EMPTY) {
+            position_remove_piece(pos, to);
+        }
+        if (undo->captured != EMPTY) pos->halfmove = 0;
+
+        move_piece(pos, from, to);
+        if (kind == MOVE_PROMOTION) {
+            position_remove_piece(pos, to);
+            position_put_piece(pos, us | MOVE_PROMO(move), to);
+        }
+
+        if (PIECE_TYPE(piece) == PAWN) {
+            pos->halfmove = 0;
+            if ((to ^ from) == 16 && ep_capturable(pos, (from + to) / 2, OPPONENT(us))) {
+                pos->ep_square = (from + to) / 2;
+                pos->key ^= zobrist_ep[SQ_COL(pos->ep_square)];
+            }
+        }
+    }
+
+    int castling = pos->castling & castling_rights_kept(from) & castling_rights_kept(to);
+    if (castling != pos->castling) {
+        pos->key ^= zobrist_castling[pos->castling] ^ zobrist_castling[castling];
+        pos->castling = castling;
+    }
+
+    if (us == BLACK) pos->fullmove++;
+    pos->side = OPPONENT(us);
+    pos->key ^= zobrist_side;
+    compute_check_info(pos);
+}
+
+// Function to take back the last move played with make_move
+void unmake_move(Position *pos, Move move) {
+    UndoInfo *undo = &pos->history[--pos->game_ply];
+    int them = pos->side;
+    int us = OPPONENT(them);
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int kind = MOVE_KIND(move);
+
+    pos->side = us;
+    if (us == BLACK) pos->fullmove--;
+
+    if (kind == MOVE_CASTLING) {
+        int rook_from = (to > from) ? from + 3 : from - 4;
+        int rook_to = (to > from) ? from + 1 : from - 1;
+        move_piece(pos, rook_to, rook_from);
+        move_piece(pos, to, from);
+    } else {
+        if (kind == MOVE_PROMOTION) {
+            position_remove_piece(pos, to);
+            position_put_piece(pos, us | PAWN, to);
+        }
+        move_piece(pos, to, from);
+        if (kind == MOVE_EN_PASSANT) {
+            position_put_piece(pos, undo->captured, to + ((us == WHITE) ? 8 : -8));
+        } else if (undo->captured != EMPTY) {
+            position_put_piece(pos, undo->captured, to);
+        }
+    }
+
+    pos->castling = undo->castling;
+    pos->ep_square = undo->ep_square;
+    pos->halfmove = undo->halfmove;
+    pos->key = undo->key;
+    pos->checkers = undo->checkers;
+    pos->pinned = undo->pinned;
+}
+
+// Function to drop the history no repetition or fifty-move check can reach: only the
+// plies since the last capture or pawn move are kept, moved to the front
+void position_compact_history(Position *pos) {
+    int keep = pos->halfmove < pos->game_ply ? pos->halfmove : pos->game_ply;
+    // Past a hundred quiet plies is_draw stops at the fifty-move rule and never looks back
+    if (keep > 100) keep = 100;
+    memmove(pos->history, pos->history + pos->game_ply - keep, keep * sizeof(UndoInfo));
+    pos->game_ply = keep;
+}
+
+// Function to pass the move to the opponent; the side to move must not be in check
+void make_null_move(Position *pos) {
+    assert(pos->game_ply < MAX_GAME_PLY);
+    UndoInfo *undo = &pos->history[pos->game_ply++];
+
+    undo->key = pos->key;
+    undo->checkers = pos->checkers;
+    undo->pinned = pos->pinned;
+    undo->halfmove = (uint16_t)pos->halfmove;
+    undo->castling = (uint8_t)pos->castling;
+    undo->ep_square = (int8_t)pos->ep_square;
+    undo->captured = EMPTY;
+
+    // Nothing before a pass counts towards a repetition
+    pos->halfmove = 0;
+    if (pos->ep_square != SQ_NONE) {
+        pos->key ^= zobrist_ep[SQ_COL(pos->ep_square)];
+        pos->ep_square = SQ_NONE;
+    }
+    pos->side = OPPONENT(pos->side);
+    pos->key ^= zobrist_side;
+    compute_check_info(pos);
+}
+
+// Function to take back a pass played with make_null_move
+void unmake_null_move(Position *pos) {
+    UndoInfo *undo = &pos->history[--pos->game_ply];
+
+    pos->side = OPPONENT(pos->side);
+    pos->ep_square = undo->ep_square;
+    pos->halfmove = undo->halfmove;
+    pos->key = undo->key;
+    pos->checkers = undo->checkers;
+    pos->pinned = undo->pinned;
+}
+
+// Function to check if a square is attacked by any piece of the given color
+int is_square_attacked(const Position *pos, int sq, int by_color) {
+    Bitboard them = pos->by_color[COLOR_INDEX(by_color)];
+    Bitboard occ = occupied_bb(pos);
+
+    // Look outward from the target square, cheapest tests first
+    return (pawn_attacks[COLOR_INDEX(by_color) ^ 1][sq] & pos->by_type[PAWN] & them)
+        || (knight_attacks[sq] & pos->by_type[KNIGHT] & them)
+        || (king_attacks[sq] & pos->by_type[KING] & them)
+        || (bishop_attacks(sq, occ) & (pos->by_type[BISHOP] | pos->by_type[QUEEN]) & them)
+        || (rook_attacks(sq, occ) & (pos->by_type[ROOK] | pos->by_type[QUEEN]) & them);
+}
+
+// Function to get every piece (of both colors) attacking a square
+Bitboard attackers_to(const Position *pos, int sq, Bitboard occupied) {
+    return (pawn_attacks[1][sq] & pieces_of(pos, WHITE, PAWN))
+         | (pawn_attacks[0][sq] & pieces_of(pos, BLACK, PAWN))
+         | (knight_attacks[sq] & pos->by_type[KNIGHT])
+         | (bishop_attacks(sq, occupied) & (pos->by_type[BISHOP] | pos->by_type[QUEEN]))
+         | (rook_attacks(sq, occupied) & (pos->by_type[ROOK] | pos->by_type[QUEEN]))
+         | (king_attacks[sq] & pos->by_type[KING]);
+}
+
+// Function to statically evaluate the exchange a move starts on its target square;
+// returns the material the moving side can expect to win (negative if it loses)
+int see(const Position *pos, Move move) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int gain[32];
+    int d = 0;
+
+    if (MOVE_KIND(move) == MOVE_CASTLING) return 0;
+
+    Bitboard occ = occupied_bb(pos) ^ SQ_BB(from);
+    int piece = PIECE_TYPE(pos->squares[from]);
+    gain[0] = piece_value[PIECE_TYPE(pos->squares[to])];
+    if (MOVE_KIND(move) == MOVE_EN_PASSANT) {
+        occ ^= SQ_BB(to + (pos->side == WHITE ? 8 : -8));
+        gain[0] = piece_value[PAWN];
+    } else if (MOVE_KIND(move) == MOVE_PROMOTION) {
+        piece = MOVE_PROMO(move);
+        gain[0] += piece_value[piece] - piece_value[PAWN];
+    }
+
+    Bitboard diagonal = pos->by_type[BISHOP] | pos->by_type[QUEEN];
+    Bitboard straight = pos->by_type[ROOK] | pos->by_type[QUEEN];
+    Bitboard attackers = attackers_to(pos, to, occ) & occ;
+    int side = pos->side;
+
+    // gain[d] is what the side making capture d has won if the exchange stops there;
+    // each recapture uses the least valuable attacker, revealing x-rays behind it
+    while (d < 31) {
+        d++;
+        side = OPPONENT(side);
+        gain[d] = piece_value[piece] - gain[d - 1];
+        if ((-gain[d - 1] > gain[d] ? -gain[d - 1] : gain[d]) < 0) break;
+
+        Bitboard mine = attackers & pos->by_color[COLOR_INDEX(side)];
+        if (!mine) break;
+
+        int type;
+        Bitboard bb = 0;
+        for (type = PAWN; type <= KING; type++) {
+            if ((bb = mine & pos->by_type[type])) break;
+        }
+        // The king can only take last, on a square nothing defends
+        if (type == KING && (attackers & pos->by_color[COLOR_INDEX(OPPONENT(side))])) break;
+
+        occ ^= bb & -bb;
+        if (type == PAWN || type == BISHOP || type == QUEEN) attackers |= bishop_attacks(to, occ) & diagonal;
+        if (type == ROOK || type == QUEEN) attackers |= rook_attacks(to, occ) & straight;
+        attackers &= occ;
+        piece = type;
+    }
+
+    while (--d) {
+        gain[d - 1] = -(-gain[d - 1] > gain[d] ? -gain[d - 1] : gain[d]);
+    }
+    return gain[0];
+}
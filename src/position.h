@@ -0,0 +1,135 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "types.h"
+#include "bitboard.h"
+
+#define CASTLE_WK 1
+#define CASTLE_WQ 2
+#define CASTLE_BK 4
+#define CASTLE_BQ 8
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+#define MAX_GAME_PLY 1024
+
+// State that make_move cannot recover from the move itself
+typedef struct {
+    uint64_t key;
+    Bitboard checkers;
+    Bitboard pinned;
+    uint16_t halfmove;
+    uint8_t captured;
+    uint8_t castling;
+    int8_t ep_square;
+} UndoInfo;
+
+// Bitboard position: per-type and per-color occupancy plus a mailbox
+// that uses the same piece codes and layout as board[8][8]
+typedef struct {
+    int squares[64];
+    Bitboard by_type[7];      // index 0 holds all occupied squares
+    Bitboard by_color[2];
+    int side;                 // WHITE or BLACK to move
+    int castling;
+    int ep_square;
+    int halfmove;
+    int fullmove;
+    uint64_t key;             // Zobrist key, updated incrementally
+    uint64_t pawn_key;        // Zobrist key of the pawns alone, for the pawn hash table
+    Bitboard checkers;        // enemy pieces giving check to the side to move
+    Bitboard pinned;          // side-to-move pieces pinned to their own king
+    int material[2];          // piece values per color, king excluded
+    int psq_mg;               // material + piece-square sums, White minus Black
+    int psq_eg;
+    int phase;                // phase_weight sum of the pieces on the board
+    int game_ply;             // entries used in history
+    UndoInfo history[MAX_GAME_PLY];
+} Position;
+
+extern const int piece_value[7];
+
+// Function to seed the Zobrist keys; must run once before any position is set up
+void init_zobrist(void);
+
+// Function to reset a position to an empty board
+void position_clear(Position *pos);
+
+// Function to place a piece on an empty square
+void position_put_piece(Position *pos, int piece, int sq);
+
+// Function to remove the piece standing on a square
+void position_remove_piece(Position *pos, int sq);
+
+// Function to complete a cleared position whose pieces were placed with position_put_piece and
+// whose side, castling, en passant and clock fields were set directly
+void position_finish_setup(Position *pos);
+
+// Function to load a FEN string; returns 1 on success, 0 on a malformed FEN
+int position_set_fen(Position *pos, const char *fen);
+
+// Function to write the position as a FEN string into buf
+void position_get_fen(const Position *pos, char *buf, int size);
+
+// Function to load a position from a board[8][8] array
+void position_from_board(Position *pos, const int board[8][8], int side);
+
+// Function to write the mailbox back into a board[8][8] array
+void position_to_board(const Position *pos, int board[8][8]);
+
+// Function to play a legal move, pushing its undo record onto pos->history, which
+// must not be full (game_ply below MAX_GAME_PLY)
+void make_move(Position *pos, Move move);
+
+// Function to take back the last move played with make_move
+void unmake_move(Position *pos, Move move);
+
+// Function to drop the history no repetition or fifty-move check can reach: only the
+// plies since the last capture or pawn move are kept, moved to the front
+void position_compact_history(Position *pos);
+
+// Function to pass the move to the opponent; the side to move must not be in check
+void make_null_move(Position *pos);
+
+// Function to take back a pass played with make_null_move
+void unmake_null_move(Position *pos);
+
+// Function to compute the Zobrist key from scratch (used to verify the incremental key)
+uint64_t position_compute_key(const Position *pos);
+
+// Function to compute the pawn key from scratch (used to verify the incremental pawn key)
+uint64_t position_compute_pawn_key(const Position *pos);
+
+// Function to check if a square is attacked by any piece of the given color
+int is_square_attacked(const Position *pos, int sq, int by_color);
+
+// Function to get every piece (of both colors) attacking a square
+Bitboard attackers_to(const Position *pos, int sq, Bitboard occupied);
+
+// Function to statically evaluate the exchange a move starts on its target square;
+// returns the material the moving side can expect to win (negative if it loses)
+int see(const Position *pos, Move move);
+
+// Function to format a square as algebraic text ("e4"); buf needs 3 bytes
+void square_name(int sq, char *buf);
+
+// Function to parse algebraic square text; returns SQ_NONE on failure
+int parse_square(const char *s);
+
+static inline Bitboard pieces_of(const Position *pos, int color, int type) {
+    return pos->by_color[COLOR_INDEX(color)] & pos->by_type[type];
+}
+
+static inline Bitboard occupied_bb(const Position *pos) {
+    return pos->by_type[0];
+}
+
+static inline int in_check(const Position *pos) {
+    return pos->checkers != 0;
+}
+
+static inline int king_square(const Position *pos, int color) {
+    return lsb(pieces_of(pos, color, KING));
+}
+
+#endif
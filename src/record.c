@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "record.h"
+#include "movegen.h"
+#include "misc.h"
+
+#define RECORD_BUFFER_SIZE (1 << 20)
+#define RECORD_LINE 512
+
+static const char position_magic[RECORD_HEADER_SIZE] = {'C', 'H', 'E', 'S', 'S', 'P', 'O', 'S'};
+static const char game_magic[RECORD_HEADER_SIZE] = {'C', 'H', 'E', 'S', 'S', 'G', 'A', 'M'};
+
+// Function to pack a position; returns 0 if it has more than 32 pieces
+int pack_position(const Position *pos, PackedPosition *packed) {
+    uint8_t *b = packed->bytes;
+    Bitboard occ = occupied_bb(pos);
+    int n = 0;
+
+    if (popcount(occ) > 32) return 0;
+    memset(b, 0, PACKED_POSITION_SIZE);
+    for (int i = 0; i < 8; i++) b[i] = (uint8_t)(occ >> (8 * i));
+    while (occ) {
+        int piece = pos->squares[pop_lsb(&occ)];
+        int code = PIECE_TYPE(piece) | (PIECE_COLOR(piece) == BLACK ? 8 : 0);
+        b[8 + n / 2] |= (uint8_t)(code << (4 * (n & 1)));
+        n++;
+    }
+
+    int fullmove = pos->fullmove < 0xFFFF ? pos->fullmove : 0xFFFF;
+    b[24] = (uint8_t)((pos->side == BLACK) | (pos->castling << 1));
+    b[25] = pos->ep_square == SQ_NONE ? PACKED_NO_SQUARE : (uint8_t)pos->ep_square;
+    b[26] = (uint8_t)(pos->halfmove < 255 ? pos->halfmove : 255);
+    b[28] = (uint8_t)fullmove;
+    b[29] = (uint8_t)(fullmove >> 8);
+    return 1;
+}
+
+// Function to unpack a position; returns 0 if the bytes do not hold a valid position
+int unpack_position(const PackedPosition *packed, Position *pos) {
+    const uint8_t *b = packed->bytes;
+    Bitboard occ = 0;
+    int n = 0;
+
+    for (int i = 0; i < 8; i++) occ |= (Bitboard)b[i] << (8 * i);
+    if (popcount(occ) > 32 || (b[24] & ~0x1F) || (b[25] >= 64 && b[25] != PACKED_NO_SQUARE)) return 0;
+
+    position_clear(pos);
+    while (occ) {
+        int sq = pop_lsb(&occ);
+        int code = (b[8 + n / 2] >> (4 * (n & 1))) & 0xF;
+        n++;
+        if ((code & 7) < PAWN || (code & 7) > KING) return 0;
+        position_put_piece(pos, (code & 7) | (code & 8 ? BLACK : WHITE), sq);
+    }
+    if (popcount(pieces_of(pos, WHITE, KING)) != 1 || popcount(pieces_of(pos, BLACK, KING)) != 1) return 0;
+
+    pos->side = (b[24] & 1) ? BLACK : WHITE;
+    pos->castling = b[24] >> 1;
+    pos->ep_square = b[25] == PACKED_NO_SQUARE ? SQ_NONE : b[25];
+    pos->halfmove = b[26];
+    pos->fullmove = b[28] | (b[29] << 8);
+    if (pos->fullmove == 0) pos->fullmove = 1;
+    position_finish_setup(pos);
+    return 1;
+}
+
+// Function to pack the position described by a FEN string; returns 0 on a bad FEN
+int fen_to_packed(const char *fen, PackedPosition *packed) {
+    Position pos;
+    return position_set_fen(&pos, fen) && pack_position(&pos, packed);
+}
+
+// Function to write a packed position as a FEN string; returns 0 if it is invalid
+int packed_to_fen(const PackedPosition *packed, char *buf, int size) {
+    Position pos;
+    if (!unpack_position(packed, &pos)) return 0;
+    position_get_fen(&pos, buf, size);
+    return 1;
+}
+
+// Function to append raw bytes through the writer's buffer
+static void put_bytes(RecordWriter *w, const void *data, size_t size) {
+    if (w->used + size > RECORD_BUFFER_SIZE) {
+        if (fwrite(w->buffer, 1, w->used, w->file) != w->used) w->failed = 1;
+        w->used = 0;
+    }
+    memcpy(w->buffer + w->used, data, size);
+    w->used += size;
+}
+
+// Function to create a record file of the given kind; returns 1 on success
+int record_writer_open(RecordWriter *w, const char *path, int kind) {
+    memset(w, 0, sizeof(*w));
+    w->kind = kind;
+    w->file = fopen(path, "wb");
+    w->buffer = malloc(RECORD_BUFFER_SIZE);
+    if (!w->file || !w->buffer) {
+        printf("Could not create %s\n", path);
+        if (w->file) fclose(w->file);
+        free(w->buffer);
+        return 0;
+    }
+    put_bytes(w, kind == RECORD_GAMES ? game_magic : position_magic, RECORD_HEADER_SIZE);
+    return 1;
+}
+
+// Function to append one position to a position file
+void record_write_position(RecordWriter *w, const PackedPosition *packed) {
+    put_bytes(w, packed->bytes, PACKED_POSITION_SIZE);
+    w->records++;
+}
+
+// Function to append one game (start position, moves and result) to a game file
+void record_write_game(RecordWriter *w, const Position *start, const Move *moves, int count, int result) {
+    PackedPosition packed;
+    uint8_t header[4] = {(uint8_t)count, (uint8_t)(count >> 8), (uint8_t)result, 0};
+
+    if (!pack_position(start, &packed) || count > 0xFFFF) {
+        w->failed = 1;
+        return;
+    }
+    put_bytes(w, packed.bytes, PACKED_POSITION_SIZE);
+    put_bytes(w, header, sizeof(header));
+    for (int i = 0; i < count; i++) {
+        uint8_t move[2] = {(uint8_t)moves[i], (uint8_t)(moves[i] >> 8)};
+        put_bytes(w, move, sizeof(move));
+    }
+    w->records++;
+}
+
+// Function to flush and close the file; returns 1 if every write succeeded
+int record_writer_close(RecordWriter *w) {
+    if (w->used && fwrite(w->buffer, 1, w->used, w->file) != w->used) w->failed = 1;
+    if (fclose(w->file) != 0) w->failed = 1;
+    free(w->buffer);
+    w->buffer = NULL;
+    w->file = NULL;
+    return !w->failed;
+}
+
+// Function to map a record file for reading; returns 1 on success
+int record_reader_open(RecordReader *r, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    memset(r, 0, sizeof(*r));
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < RECORD_HEADER_SIZE) {
+        printf("Could not open record file %s\n", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Could not map record file %s\n", path);
+        return 0;
+    }
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    r->data = data;
+    r->size = (size_t)st.st_size;
+    r->offset = RECORD_HEADER_SIZE;
+    if (memcmp(data, position_magic, RECORD_HEADER_SIZE) == 0) r->kind = RECORD_POSITIONS;
+    else if (memcmp(data, game_magic, RECORD_HEADER_SIZE) == 0) r->kind = RECORD_GAMES;
+    else {
+        printf("%s is not a record file\n", path);
+        record_reader_close(r);
+        return 0;
+    }
+    return 1;
+}
+
+// Function to unmap a record file
+void record_reader_close(RecordReader *r) {
+    if (r->data) munmap((void *)r->data, r->size);
+    r->data = NULL;
+}
+
+// Function to step to the next game of a game file; returns 1 on a game, 0 at the
+// end and -1 if the file is truncated
+int record_next_game(RecordReader *r, GameView *game) {
+    if (r->offset == r->size) return 0;
+    if (r->size - r->offset < GAME_HEADER_SIZE) return -1;
+
+    const uint8_t *p = r->data + r->offset;
+    int count = p[PACKED_POSITION_SIZE] | (p[PACKED_POSITION_SIZE + 1] << 8);
+    size_t length = GAME_HEADER_SIZE + 2 * (size_t)count;
+    if (r->size - r->offset < length) return -1;
+
+    game->start = (const PackedPosition *)p;
+    game->ply_count = count;
+    game->result = p[PACKED_POSITION_SIZE + 2];
+    game->moves = p + GAME_HEADER_SIZE;
+    r->offset += length;
+    return 1;
+}
+
+// Function to convert FEN/EPD lines into a position file, checking every position
+// survives the round trip back to FEN; returns the process exit code
+int run_pack_fens(const char *in_path, const char *out_path) {
+    FILE *in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "r");
+    char line[RECORD_LINE], original[128], restored[128];
+    uint64_t text_bytes = 0, invalid = 0, mismatches = 0;
+    RecordWriter w;
+
+    if (!in) {
+        printf("Could not open %s\n", in_path);
+        return 1;
+    }
+    if (!record_writer_open(&w, out_path, RECORD_POSITIONS)) {
+        if (in != stdin) fclose(in);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), in)) {
+        Position pos;
+        PackedPosition packed;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!line[0] || line[0] == '#') continue;
+        text_bytes += strlen(line) + 1;
+        if (!position_set_fen(&pos, line) || !pack_position(&pos, &packed)) {
+            invalid++;
+            continue;
+        }
+
+        // Compare normalised FENs, so dropped en passant squares or EPD fields do not count
+        position_get_fen(&pos, original, sizeof(original));
+        if (!packed_to_fen(&packed, restored, sizeof(restored)) || strcmp(original, restored) != 0) {
+            printf("Round trip mismatch: %s -> %s\n", original, restored);
+            mismatches++;
+        }
+        record_write_position(&w, &packed);
+    }
+    if (in != stdin) fclose(in);
+
+    uint64_t count = w.records;
+    if (!record_writer_close(&w)) {
+        printf("Could not write %s\n", out_path);
+        return 1;
+    }
+    printf("Positions: %" PRIu64 " (%" PRIu64 " invalid, %" PRIu64 " round-trip mismatches)\n", count, invalid,
+           mismatches);
+    printf("Size: %" PRIu64 " bytes of text, %" PRIu64 " bytes packed (%.1f%%)\n", text_bytes,
+           (uint64_t)RECORD_HEADER_SIZE + count * PACKED_POSITION_SIZE,
+           text_bytes ? 100.0 * (RECORD_HEADER_SIZE + count * PACKED_POSITION_SIZE) / text_bytes : 0.0);
+    return mismatches ? 1 : 0;
+}
+
+// Function to print a record file as text: FENs, or start FEN and moves per game
+int run_unpack(const char *path) {
+    RecordReader r;
+    char fen[128], text[6];
+    GameView game;
+    int status;
+
+    if (!record_reader_open(&r, path)) return 1;
+    if (r.kind == RECORD_POSITIONS) {
+        for (size_t i = 0; i < record_position_count(&r); i++) {
+            if (packed_to_fen(record_position_at(&r, i), fen, sizeof(fen))) printf("%s\n", fen);
+            else printf("# invalid position %zu\n", i);
+        }
+        record_reader_close(&r);
+        return 0;
+    }
+
+    static const char *results[4] = {"0-1", "1/2-1/2", "1-0", "*"};
+    while ((status = record_next_game(&r, &game)) > 0) {
+        if (!packed_to_fen(game.start, fen, sizeof(fen))) {
+            printf("# invalid start position\n");
+            continue;
+        }
+        printf("%s moves", fen);
+        for (int i = 0; i < game.ply_count; i++) {
+            move_to_uci(game_move(&game, i), text);
+            printf(" %s", text);
+        }
+        printf(" %s\n", results[game.result & 3]);
+    }
+    record_reader_close(&r);
+    if (status < 0) printf("# truncated game record\n");
+    return status < 0 ? 1 : 0;
+}
+
+// Function to unpack every position of a record file (replaying the moves of games)
+// and report the throughput; returns the process exit code
+int run_record_scan(const char *path) {
+    RecordReader r;
+    Position pos;
+    GameView game;
+    uint64_t games = 0, positions = 0, invalid = 0, hash = 0;
+    int status = 0;
+
+    if (!record_reader_open(&r, path)) return 1;
+    int64_t start = now_ns();
+    if (r.kind == RECORD_POSITIONS) {
+        for (size_t i = 0; i < record_position_count(&r); i++) {
+            if (!unpack_position(record_position_at(&r, i), &pos)) {
+                invalid++;
+                continue;
+            }
+            hash ^= pos.key;
+            positions++;
+        }
+    } else {
+        while ((status = record_next_game(&r, &game)) > 0) {
+            games++;
+            if (!unpack_position(game.start, &pos)) {
+                invalid++;
+                continue;
+            }
+            hash ^= pos.key;
+            positions++;
+            for (int i = 0; i < game.ply_count; i++) {
+                Move move = game_move(&game, i);
+                if (!is_pseudo_legal(&pos, move) || !is_legal_move(&pos, move)) {
+                    invalid++;
+                    break;
+                }
+                // Keep room in the undo stack: nothing here ever unmakes a move
+                if (pos.game_ply >= MAX_GAME_PLY - 1) position_compact_history(&pos);
+                make_move(&pos, move);
+                hash ^= pos.key;
+                positions++;
+            }
+        }
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    size_t size = r.size;
+    record_reader_close(&r);
+
+    if (r.kind == RECORD_GAMES) printf("Games: %" PRIu64 "\n", games);
+    printf("Positions: %" PRIu64 " (%" PRIu64 " invalid), key checksum %016" PRIx64 "\n", positions, invalid, hash);
+    printf("Time: %.3f s, %.1f M positions/s, %.1f MB/s, %.1f bytes per position\n", seconds,
+           seconds > 0 ? positions / seconds / 1e6 : 0.0, seconds > 0 ? size / seconds / 1e6 : 0.0,
+           positions ? (double)size / positions : 0.0);
+    if (status < 0) printf("Truncated game record at the end of %s\n", path);
+    return status < 0 || invalid ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "position.h"
+
+// Packed position, 32 bytes, little-endian whatever the host:
+//   0-7    occupancy, bit sq set for every occupied square (sq as in board[8][8])
+//   8-23   one 4-bit code per occupied square in square order, low nibble first:
+//          the piece type, plus 8 for Black (so BLACK | type maps to type + 8)
+//   24     bit 0 Black to move, bits 1-4 the CASTLE_* rights
+//   25     en passant square, 0xFF if none
+//   26     halfmove clock (capped at 255)
+//   27     reserved, 0
+//   28-29  fullmove number
+//   30-31  reserved, 0
+#define PACKED_POSITION_SIZE 32
+#define PACKED_NO_SQUARE 0xFF
+
+typedef struct {
+    uint8_t bytes[PACKED_POSITION_SIZE];
+} PackedPosition;
+
+// Record files start with an 8-byte magic naming their kind. A position file is a
+// plain array of packed positions; a game file holds one record per game:
+//   packed start position, ply count (2 bytes), result (1), reserved (1), then
+//   ply count 16-bit moves in the engine's Move encoding
+#define RECORD_POSITIONS 1
+#define RECORD_GAMES 2
+#define RECORD_HEADER_SIZE 8
+#define GAME_HEADER_SIZE (PACKED_POSITION_SIZE + 4)
+
+// Game results, as half points scored by White
+#define RESULT_BLACK_WINS 0
+#define RESULT_DRAW 1
+#define RESULT_WHITE_WINS 2
+#define RESULT_UNKNOWN 3
+
+// Buffered writer for one record file
+typedef struct {
+    FILE *file;
+    uint8_t *buffer;
+    size_t used;
+    uint64_t records;
+    int kind;
+    int failed;
+} RecordWriter;
+
+// Read-only view of a mapped record file
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t offset;            // next record
+    int kind;
+} RecordReader;
+
+// One game inside a mapped file; points into the mapping, nothing is copied
+typedef struct {
+    const PackedPosition *start;
+    const uint8_t *moves;
+    int ply_count;
+    int result;
+} GameView;
+
+// Function to pack a position; returns 0 if it has more than 32 pieces
+int pack_position(const Position *pos, PackedPosition *packed);
+
+// Function to unpack a position; returns 0 if the bytes do not hold a valid position
+int unpack_position(const PackedPosition *packed, Position *pos);
+
+// Function to pack the position described by a FEN string; returns 0 on a bad FEN
+int fen_to_packed(const char *fen, PackedPosition *packed);
+
+// Function to write a packed position as a FEN string; returns 0 if it is invalid
+int packed_to_fen(const PackedPosition *packed, char *buf, int size);
+
+// Function to create a record file of the given kind; returns 1 on success
+int record_writer_open(RecordWriter *w, const char *path, int kind);
+
+// Function to append one position to a position file
+void record_write_position(RecordWriter *w, const PackedPosition *packed);
+
+// Function to append one game (start position, moves and result) to a game file
+void record_write_game(RecordWriter *w, const Position *start, const Move *moves, int count, int result);
+
+// Function to flush and close the file; returns 1 if every write succeeded
+int record_writer_close(RecordWriter *w);
+
+// Function to map a record file for reading; returns 1 on success
+int record_reader_open(RecordReader *r, const char *path);
+
+// Function to unmap a record file
+void record_reader_close(RecordReader *r);
+
+// Function to step to the next game of a game file; returns 1 on a game, 0 at the
+// end and -1 if the file is truncated
+int record_next_game(RecordReader *r, GameView *game);
+
+// Function to get the number of positions in a position file
+static inline size_t record_position_count(const RecordReader *r) {
+    return (r->size - RECORD_HEADER_SIZE) / PACKED_POSITION_SIZE;
+}
+
+// Function to get one position of a position file, in place
+static inline const PackedPosition *record_position_at(const RecordReader *r, size_t index) {
+    return (const PackedPosition *)(r->data + RECORD_HEADER_SIZE + index * PACKED_POSITION_SIZE);
+}
+
+// Function to decode move i of a game
+static inline Move game_move(const GameView *game, int i) {
+    return (Move)(game->moves[2 * i] | (game->moves[2 * i + 1] << 8));
+}
+
+// Function to convert FEN/EPD lines into a position file, checking every position
+// survives the round trip back to FEN; returns the process exit code
+int run_pack_fens(const char *in_path, const char *out_path);
+
+// Function to print a record file as text: FENs, or start FEN and moves per game
+int run_unpack(const char *path);
+
+// Function to unpack every position of a record file (replaying the moves of games)
+// and report the throughput; returns the process exit code
+int run_record_scan(const char *path);
+
+#endif
@@ -0,0 +1,638 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "search.h"
+#include "misc.h"
+#include "eval.h"
+#include "bitbase.h"
+
+// Function to check for a draw by the fifty-move rule or repetition
+int is_draw(const Position *pos) {
+    if (pos->halfmove >= 100) return 1;
+
+    // Only positions since the last irreversible move can repeat, and only
+    // with the same side to move, so step back two plies at a time
+    int end = pos->game_ply - pos->halfmove;
+    if (end < 0) end = 0;
+    for (int i = pos->game_ply - 2; i >= end; i -= 2) {
+        if (pos->history[i].key == pos->key) return 1;
+    }
+    return 0;
+}
+
+// Function to check if neither side has enough material left to ever mate
+// (bare kings, a single minor piece, or only bishops all on one square color)
+int is_insufficient_material(const Position *pos) {
+    const Bitboard light_squares = 0xAA55AA55AA55AA55ULL;
+
+    if (pos->by_type[PAWN] | pos->by_type[ROOK] | pos->by_type[QUEEN]) return 0;
+    Bitboard minors = pos->by_type[KNIGHT] | pos->by_type[BISHOP];
+    if (!more_than_one(minors)) return 1;
+    if (pos->by_type[KNIGHT]) return 0;
+    return !(minors & light_squares) || !(minors & ~light_squares);
+}
+
+// Function to check if a side has a piece other than pawns and its king; without one,
+// passing is often the best it could do and the null move observation does not hold
+static inline int has_non_pawn_material(const Position *pos, int color) {
+    return (pos->by_color[COLOR_INDEX(color)] & ~(pos->by_type[PAWN] | pos->by_type[KING])) != 0;
+}
+
+// Function to turn a clock (and increment, in milliseconds) into a hard limit and an
+// optimum time for the next move; moves_to_go 0 means the rest of the game
+void search_allocate_time(SearchLimits *limits, int64_t time, int64_t inc, int moves_to_go) {
+    if (moves_to_go <= 0) moves_to_go = DEFAULT_MOVES_TO_GO;
+    int64_t usable = time - MOVE_OVERHEAD_MS;
+    if (usable < 1) usable = 1;
+
+    int64_t target = usable / moves_to_go + inc * 3 / 4;
+    int64_t maximum = usable / 2;
+    if (moves_to_go == 1) maximum = usable;
+    if (target > maximum) target = maximum;
+
+    limits->movetime = target * 2 < maximum ? target * 2 : maximum;
+    limits->optimum_time = target / 2 > 1 ? target / 2 : 1;
+}
+
+// Function to check the shared stop flag
+static inline int stopped(const SearchThread *st) {
+    return atomic_load_explicit(&st->signals->stop, memory_order_relaxed);
+}
+
+// Function to get the milliseconds since the search (or the ponderhit) started
+int64_t search_elapsed(const SearchThread *st) {
+    return now_ms() - atomic_load_explicit(&st->signals->start_time, memory_order_relaxed);
+}
+
+// Function to check if the clock applies right now
+static inline int clock_running(const SearchThread *st) {
+    return !atomic_load_explicit(&st->signals->pondering, memory_order_relaxed);
+}
+
+// Function to stop the search once the time or node budget is spent
+static void check_limits(SearchThread *st) {
+    if ((st->limits.nodes && st->stats.nodes >= st->limits.nodes)
+        || (st->id == 0 && st->limits.movetime && clock_running(st) && search_elapsed(st) >= st->limits.movetime)) {
+        atomic_store_explicit(&st->signals->stop, 1, memory_order_relaxed);
+    }
+}
+
+// Function to sum the nodes searched by every thread of the search
+uint64_t search_total_nodes(const SearchThread *st) {
+    uint64_t nodes = 0;
+    for (int i = 0; i < st->thread_count; i++) nodes += st->threads[i].stats.nodes;
+    return nodes;
+}
+
+// Function to get the deepest ply reached by any thread of the search
+int search_seldepth(const SearchThread *st) {
+    int seldepth = 0;
+    for (int i = 0; i < st->thread_count; i++) {
+        if (st->threads[i].stats.seldepth > seldepth) seldepth = st->threads[i].stats.seldepth;
+    }
+    return seldepth;
+}
+
+// Function to add one set of counters into another
+void stats_add(SearchStats *total, const SearchStats *part) {
+    total->nodes += part->nodes;
+    total->qnodes += part->qnodes;
+    total->tt_probes += part->tt_probes;
+    total->tt_hits += part->tt_hits;
+    total->tt_cutoffs += part->tt_cutoffs;
+    total->interior_nodes += part->interior_nodes;
+    total->moves_searched += part->moves_searched;
+    total->cutoffs += part->cutoffs;
+    for (int i = 0; i < CUTOFF_SLOTS; i++) total->cutoffs_by_move[i] += part->cutoffs_by_move[i];
+    total->bitbase_hits += part->bitbase_hits;
+    total->pawn_probes += part->pawn_probes;
+    total->pawn_hits += part->pawn_hits;
+    if (part->seldepth > total->seldepth) total->seldepth = part->seldepth;
+}
+
+// Function to sum the counters of every thread of the search (seldepth is the maximum)
+void search_total_stats(const SearchThread *st, SearchStats *total) {
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < st->thread_count; i++) {
+        SearchStats part = st->threads[i].stats;
+#if STATS_ENABLED
+        part.pawn_probes = st->threads[i].pawns.probes;
+        part.pawn_hits = st->threads[i].pawns.hits;
+#endif
+        stats_add(total, &part);
+    }
+}
+
+// Function to write counters as a single-line JSON object; st, if given, adds the depth
+// reached and the nodes and time to each completed depth of its search
+void stats_write_json(FILE *out, const char *label, const SearchStats *stats, int64_t time_ms,
+                      const SearchThread *st) {
+    char line[8192], fen[128];
+    int n;
+
+    n = snprintf(line, sizeof(line), "{\"label\":\"%s\",\"stats_enabled\":%d,\"time_ms\":%" PRId64
+                 ",\"nodes\":%" PRIu64 ",\"nps\":%" PRIu64 ",\"qnodes\":%" PRIu64 ",\"seldepth\":%d", label,
+                 STATS_ENABLED, time_ms, stats->nodes, time_ms > 0 ? stats->nodes * 1000 / (uint64_t)time_ms : stats->nodes,
+                 stats->qnodes, stats->seldepth);
+    n += snprintf(line + n, sizeof(line) - n, ",\"tt_probes\":%" PRIu64 ",\"tt_hits\":%" PRIu64 ",\"tt_cutoffs\":%" PRIu64
+                  ",\"pawn_probes\":%" PRIu64 ",\"pawn_hits\":%" PRIu64 ",\"bitbase_hits\":%" PRIu64, stats->tt_probes,
+                  stats->tt_hits, stats->tt_cutoffs, stats->pawn_probes, stats->pawn_hits, stats->bitbase_hits);
+    n += snprintf(line + n, sizeof(line) - n, ",\"interior_nodes\":%" PRIu64 ",\"moves_searched\":%" PRIu64
+                  ",\"cutoffs\":%" PRIu64 ",\"cutoffs_by_move\":[", stats->interior_nodes, stats->moves_searched,
+                  stats->cutoffs);
+    for (int i = 0; i < CUTOFF_SLOTS; i++) {
+        n += snprintf(line + n, sizeof(line) - n, "%s%" PRIu64, i ? "," : "", stats->cutoffs_by_move[i]);
+    }
+    n += snprintf(line + n, sizeof(line) - n, "]");
+
+    if (st) {
+        // Per-depth progress of the main thread; helpers skip depths
+        position_get_fen(&st->pos, fen, sizeof(fen));
+        n += snprintf(line + n, sizeof(line) - n, ",\"fen\":\"%s\",\"threads\":%d,\"depth\":%d,\"time_to_depth_ms\":[",
+                      fen, st->thread_count, st->completed_depth);
+        for (int d = 1; d <= st->completed_depth && n < (int)sizeof(line) - 64; d++) {
+            n += snprintf(line + n, sizeof(line) - n, "%s%" PRId64, d > 1 ? "," : "", st->iteration_time[d]);
+        }
+        n += snprintf(line + n, sizeof(line) - n, "],\"nodes_to_depth\":[");
+        for (int d = 1; d <= st->completed_depth && n < (int)sizeof(line) - 64; d++) {
+            n += snprintf(line + n, sizeof(line) - n, "%s%" PRIu64, d > 1 ? "," : "", st->iteration_nodes[d]);
+        }
+        n += snprintf(line + n, sizeof(line) - n, "]");
+    }
+    snprintf(line + n, sizeof(line) - n, "}\n");
+    fputs(line, out);
+    fflush(out);
+}
+
+// Function to make mate scores relative to the stored node rather than the root
+static int score_to_tt(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) return score + ply;
+    if (score <= -VALUE_MATE_IN_MAX_PLY) return score - ply;
+    return score;
+}
+
+// Function to turn a stored mate score back into one relative to the root
+static int score_from_tt(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) return score - ply;
+    if (score <= -VALUE_MATE_IN_MAX_PLY) return score + ply;
+    return score;
+}
+
+// Function to copy the child's principal variation behind the move just searched
+static void update_pv(SearchThread *st, int ply, Move move) {
+    st->pv[ply][ply] = move;
+    for (int i = ply + 1; i < st->pv_length[ply + 1]; i++) {
+        st->pv[ply][i] = st->pv[ply + 1][i];
+    }
+    st->pv_length[ply] = st->pv_length[ply + 1];
+}
+
+// Function to evaluate the thread's position at a ply, with the network when one is in use
+// and otherwise through the pawn table
+static inline int evaluate_node(SearchThread *st, int ply) {
+    if (st->use_nnue) return nnue_evaluate(&st->pos, st->nnue_acc, st->nnue_dirty, ply);
+    return evaluate(&st->pos, st->plain_pawns ? NULL : &st->pawns);
+}
+
+// Function to play a move from a ply, noting what it changes for the network's accumulators
+static inline void play_move(SearchThread *st, int ply, Move move) {
+    if (st->use_nnue) {
+        nnue_record_move(&st->pos, move, &st->nnue_dirty[ply + 1]);
+        st->nnue_acc[ply + 1].computed[0] = st->nnue_acc[ply + 1].computed[1] = 0;
+    }
+    st->played[ply + 1] = move;
+    make_move(&st->pos, move);
+}
+
+// Function to pass from a ply; the network's accumulators carry over unchanged
+static inline void play_null_move(SearchThread *st, int ply) {
+    if (st->use_nnue) {
+        st->nnue_dirty[ply + 1].count = 0;
+        st->nnue_acc[ply + 1].computed[0] = st->nnue_acc[ply + 1].computed[1] = 0;
+    }
+    st->played[ply + 1] = MOVE_NONE;
+    make_null_move(&st->pos);
+}
+
+// Function to check if the search uses a selective technique
+static inline int pruning(const SearchThread *st, int technique) {
+    return !(st->pruning_off & technique);
+}
+
+// Function to remember a quiet move that caused a cutoff as a killer and in the history,
+// and to lower the history of the quiet moves searched before it
+static void update_quiet_stats(SearchThread *st, int ply, int depth, Move move, const Move *quiets, int count) {
+    if (st->killers[ply][0] != move) {
+        st->killers[ply][1] = st->killers[ply][0];
+        st->killers[ply][0] = move;
+    }
+
+    int bonus = depth * depth;
+    history_update(&st->history, st->pos.side, move, bonus);
+    for (int i = 0; i < count; i++) history_update(&st->history, st->pos.side, quiets[i], -bonus);
+}
+
+// Function to resolve captures (and at its first ply, checks) until the position is
+// quiet, so the static evaluation is never taken in the middle of an exchange
+static int qsearch(SearchThread *st, int ply, int alpha, int beta, int with_checks) {
+    Position *pos = &st->pos;
+
+    st->pv_length[ply] = ply;
+    st->stats.nodes++;
+    STAT_INC(st->stats.qnodes);
+    if (ply > st->stats.seldepth) st->stats.seldepth = ply;
+    if ((st->stats.nodes & 1023) == 0) check_limits(st);
+    if (stopped(st)) return 0;
+    if (ply >= MAX_PLY - 1) return evaluate_node(st, ply);
+
+    int bitbase_score;
+    if (bitbase_probe(pos, &bitbase_score)) {
+        STAT_INC(st->stats.bitbase_hits);
+        return bitbase_score;
+    }
+
+    TTData tte;
+    Move tt_move = MOVE_NONE;
+    int tt_eval = VALUE_NONE;
+    STAT_INC(st->stats.tt_probes);
+    if (tt_probe(st->tt, pos->key, &tte)) {
+        STAT_INC(st->stats.tt_hits);
+        tt_move = tte.move;
+        tt_eval = tte.eval;
+        int score = score_from_tt(tte.score, ply);
+        if (tte.bound == BOUND_EXACT
+            || (tte.bound == BOUND_LOWER && score >= beta)
+            || (tte.bound == BOUND_UPPER && score <= alpha)) {
+            STAT_INC(st->stats.tt_cutoffs);
+            return score;
+        }
+    }
+
+    // Stand pat: the side to move can usually do at least as well as the static eval,
+    // except in check where every evasion has to be searched
+    int alpha_orig = alpha;
+    int checked = in_check(pos);
+    int static_eval = checked ? -VALUE_INFINITE : tt_eval != VALUE_NONE ? tt_eval : evaluate_node(st, ply);
+    int best = static_eval;
+    if (!checked) {
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+
+    MovePicker mp;
+    if (checked) picker_init(&mp, pos, tt_move, NULL, &st->history);
+    else picker_init_qsearch(&mp, pos, tt_move, with_checks);
+
+    int legal = 0;
+    Move best_move = MOVE_NONE;
+    Move move;
+    while ((move = picker_next(&mp)) != MOVE_NONE) {
+        if (!is_legal_move(pos, move)) continue;
+        legal++;
+
+        if (!checked && is_tactical_move(pos, move)) {
+            // Delta pruning: even winning the piece cheaply cannot lift the score to alpha
+            if (MOVE_KIND(move) != MOVE_PROMOTION) {
+                int victim = MOVE_KIND(move) == MOVE_EN_PASSANT ? PAWN : PIECE_TYPE(pos->squares[MOVE_TO(move)]);
+                if (static_eval + piece_value[victim] + DELTA_MARGIN <= alpha) continue;
+            }
+            // Captures that lose material by SEE are not worth resolving
+            if (see(pos, move) < 0) continue;
+        }
+
+        play_move(st, ply, move);
+        tt_prefetch(st->tt, pos->key);
+        int score = -qsearch(st, ply + 1, -beta, -alpha, 0);
+        unmake_move(pos, move);
+        if (stopped(st)) return 0;
+
+        if (score > best) {
+            best = score;
+            best_move = move;
+            if (score > alpha) {
+                alpha = score;
+                update_pv(st, ply, move);
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    if (checked && legal == 0) return -VALUE_MATE + ply;
+
+    int bound = best >= beta ? BOUND_LOWER : best > alpha_orig ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(st->tt, pos->key, best_move, score_to_tt(best, ply), checked ? VALUE_NONE : static_eval, DEPTH_QS, bound);
+    return best;
+}
+
+// Function to search one node with negamax alpha-beta
+static int negamax(SearchThread *st, int depth, int ply, int alpha, int beta) {
+    Position *pos = &st->pos;
+
+    st->pv_length[ply] = ply;
+    st->stats.nodes++;
+    if (ply > st->stats.seldepth) st->stats.seldepth = ply;
+    if ((st->stats.nodes & 1023) == 0) check_limits(st);
+    if (stopped(st)) return 0;
+
+    if (ply > 0 && is_draw(pos)) return VALUE_DRAW;
+    if (ply >= MAX_PLY - 1) return evaluate_node(st, ply);
+
+    // Small endgames are known exactly. A conversion into one is cut at once; when the
+    // root is already such an endgame only draws are, so the search can still find the
+    // way to mate, with the bitbase scoring its leaves
+    int bitbase_score;
+    if (ply > 0 && bitbase_probe(pos, &bitbase_score) && (bitbase_score == VALUE_DRAW || !st->root_in_bitbase)) {
+        STAT_INC(st->stats.bitbase_hits);
+        return bitbase_score;
+    }
+
+    int checked = in_check(pos);
+    if (checked) depth++;
+    if (depth <= 0) return qsearch(st, ply, alpha, beta, 1);
+
+    // Transposition table: reuse a deep enough result or at least its best move
+    TTData tte;
+    Move tt_move = MOVE_NONE;
+    int tt_eval = VALUE_NONE;
+    STAT_INC(st->stats.tt_probes);
+    if (tt_probe(st->tt, pos->key, &tte)) {
+        STAT_INC(st->stats.tt_hits);
+        tt_move = tte.move;
+        tt_eval = tte.eval;
+        if (tte.depth >= depth) {
+            int score = score_from_tt(tte.score, ply);
+            if (tte.bound == BOUND_EXACT
+                || (tte.bound == BOUND_LOWER && score >= beta)
+                || (tte.bound == BOUND_UPPER && score <= alpha)) {
+                STAT_INC(st->stats.tt_cutoffs);
+                return score;
+            }
+        }
+    }
+
+    // The static eval is only needed for pruning, which a node in check never does; the
+    // table keeps it, so a position is evaluated once however often it is searched
+    int static_eval = checked ? VALUE_NONE : tt_eval != VALUE_NONE ? tt_eval : evaluate_node(st, ply);
+
+    int mate_window = beta >= VALUE_MATE_IN_MAX_PLY || alpha <= -VALUE_MATE_IN_MAX_PLY;
+
+    // Reverse futility: this close to the horizon, a static eval far enough above beta
+    // will not drop below it whatever the opponent does
+    if (pruning(st, PRUNE_FUTILITY) && static_eval != VALUE_NONE && !mate_window && depth <= FUTILITY_MAX_DEPTH
+        && static_eval - REVERSE_FUTILITY_MARGIN * depth >= beta) {
+        return static_eval;
+    }
+
+    // Null move: if passing still fails high on a reduced search, a real move would too.
+    // Not in check, not twice in a row, and not without pieces, where zugzwang is common
+    if (pruning(st, PRUNE_NULL_MOVE) && static_eval != VALUE_NONE && !mate_window && depth >= NULL_MOVE_MIN_DEPTH
+        && st->played[ply] != MOVE_NONE && static_eval >= beta && has_non_pawn_material(pos, pos->side)) {
+        int reduction = NULL_MOVE_REDUCTION + depth / NULL_MOVE_DEPTH_STEP;
+        play_null_move(st, ply);
+        tt_prefetch(st->tt, pos->key);
+        int score = -negamax(st, depth - 1 - reduction, ply + 1, -beta, -beta + 1);
+        unmake_null_move(pos);
+        if (stopped(st)) return 0;
+        // An unproven mate is no more than a fail high
+        if (score >= beta) return score >= VALUE_MATE_IN_MAX_PLY ? beta : score;
+    }
+
+    // Futility: quiet moves cannot lift a static eval this far below alpha near the horizon
+    int futile = pruning(st, PRUNE_FUTILITY) && static_eval != VALUE_NONE && !mate_window && depth <= FUTILITY_MAX_DEPTH
+        && static_eval + FUTILITY_MARGIN * depth <= alpha;
+
+    MovePicker mp;
+    if (st->plain_order) picker_init_plain(&mp, pos);
+    else picker_init(&mp, pos, tt_move, st->killers[ply], &st->history);
+
+    int alpha_orig = alpha;
+    int best = -VALUE_INFINITE;
+    Move best_move = MOVE_NONE;
+    Move quiets[MAX_MOVES];
+    int legal = 0, quiet_count = 0;
+    Move move;
+    while ((move = picker_next(&mp)) != MOVE_NONE) {
+        if (!is_legal_move(pos, move)) continue;
+        legal++;
+        int quiet = !is_tactical_move(pos, move);
+        int checks = quiet && (futile || (pruning(st, PRUNE_LMR) && legal >= LMR_MIN_MOVES)) && gives_check(pos, move);
+
+        if (futile && quiet && legal > 1 && !checks) continue;
+
+        // Late quiet moves that neither check nor are killers are searched shallower first
+        int reduction = 0;
+        if (pruning(st, PRUNE_LMR) && quiet && !checked && !checks && depth >= LMR_MIN_DEPTH && legal >= LMR_MIN_MOVES
+            && move != st->killers[ply][0] && move != st->killers[ply][1]) {
+            reduction = 1 + (legal >= 3 * LMR_MIN_MOVES) + (depth >= 8);
+            if (reduction > depth - 2) reduction = depth - 2;
+        }
+
+        play_move(st, ply, move);
+        tt_prefetch(st->tt, pos->key);
+        int score;
+        if (legal == 1 || (!reduction && !pruning(st, PRUNE_PVS))) {
+            score = -negamax(st, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // Later moves only have to be shown no better than alpha, which a zero-window
+            // search does; one that fails high is searched again at full depth, then with
+            // the full window. Without PVS a reduced move goes straight to the full search
+            score = -negamax(st, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && reduction && pruning(st, PRUNE_PVS)) {
+                score = -negamax(st, depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if (score > alpha && (score < beta || (reduction && !pruning(st, PRUNE_PVS)))) {
+                score = -negamax(st, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        unmake_move(pos, move);
+        if (stopped(st)) return 0;
+
+        if (score > best) {
+            best = score;
+            best_move = move;
+            if (score > alpha) {
+                alpha = score;
+                update_pv(st, ply, move);
+                if (alpha >= beta) {
+                    STAT_INC(st->stats.cutoffs);
+                    STAT_INC(st->stats.cutoffs_by_move[legal < CUTOFF_SLOTS ? legal - 1 : CUTOFF_SLOTS - 1]);
+                    if (quiet && !st->plain_order) update_quiet_stats(st, ply, depth, move, quiets, quiet_count);
+                    break;
+                }
+            }
+        }
+        if (quiet) quiets[quiet_count++] = move;
+    }
+
+    STAT_INC(st->stats.interior_nodes);
+    STAT_ADD(st->stats.moves_searched, legal);
+    if (legal == 0) return checked ? -VALUE_MATE + ply : VALUE_DRAW;
+
+    int bound = best >= beta ? BOUND_LOWER : best > alpha_orig ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(st->tt, pos->key, best_move, score_to_tt(best, ply), static_eval, depth, bound);
+    return best;
+}
+
+// Function to search the root moves, best move of the last iteration first, within a
+// window; a score at or below alpha is only an upper bound, one at or above beta a lower bound
+static int search_root(SearchThread *st, int depth, int alpha, int beta) {
+    Position *pos = &st->pos;
+
+    st->pv_length[0] = 0;
+    st->played[0] = st->root_moves.moves[0];  // anything but a null move
+    for (int i = 0; i < st->root_moves.count; i++) {
+        Move move = st->root_moves.moves[i];
+        st->stats.nodes++;
+        play_move(st, 0, move);
+        int score;
+        if (!pruning(st, PRUNE_PVS) || i == 0) {
+            score = -negamax(st, depth - 1, 1, -beta, -alpha);
+        } else {
+            score = -negamax(st, depth - 1, 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) score = -negamax(st, depth - 1, 1, -beta, -alpha);
+        }
+        unmake_move(pos, move);
+        if (stopped(st)) break;
+
+        if (score > alpha) {
+            alpha = score;
+            update_pv(st, 0, move);
+            // A move that beat the previous best is trustworthy even in an unfinished iteration
+            st->best_move = move;
+            st->best_score = score;
+
+            // Keep the new best move at the front for the next iteration
+            for (int j = i; j > 0; j--) st->root_moves.moves[j] = st->root_moves.moves[j - 1];
+            st->root_moves.moves[0] = move;
+            if (alpha >= beta) break;
+        }
+    }
+    return alpha;
+}
+
+// Function to search the root to a depth, starting with a narrow window around the last
+// iteration's score and widening the side it fails on until the score falls inside
+static void search_depth(SearchThread *st, int depth) {
+    int alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
+    int window = ASPIRATION_WINDOW;
+    int previous = st->best_score;
+
+    if (pruning(st, PRUNE_ASPIRATION) && depth >= ASPIRATION_MIN_DEPTH
+        && previous > -VALUE_MATE_IN_MAX_PLY && previous < VALUE_MATE_IN_MAX_PLY) {
+        alpha = previous - window;
+        beta = previous + window;
+    }
+
+    for (;;) {
+        int score = search_root(st, depth, alpha, beta);
+        if (stopped(st)) return;
+
+        window *= 2;
+        if (score <= alpha && alpha > -VALUE_INFINITE) {
+            // Failed low: the best move of the last iteration stays until one proves better
+            st->best_score = score;
+            alpha = window > 8 * ASPIRATION_WINDOW ? -VALUE_INFINITE : score - window;
+        } else if (score >= beta && beta < VALUE_INFINITE) {
+            beta = window > 8 * ASPIRATION_WINDOW ? VALUE_INFINITE : score + window;
+        } else {
+            return;
+        }
+    }
+}
+
+// Function to print one UCI-style info line for a finished iteration; the line is
+// built first and written in one call so it cannot interleave with other output
+static void print_info(SearchThread *st, int depth) {
+    int64_t elapsed = search_elapsed(st);
+    uint64_t nodes = search_total_nodes(st);
+    int score = st->best_score;
+    char line[2048], text[6];
+    int n;
+
+    n = snprintf(line, sizeof(line), "info depth %d seldepth %d score ", depth, search_seldepth(st));
+    if (score >= VALUE_MATE_IN_MAX_PLY) n += snprintf(line + n, sizeof(line) - n, "mate %d", (VALUE_MATE - score + 1) / 2);
+    else if (score <= -VALUE_MATE_IN_MAX_PLY) n += snprintf(line + n, sizeof(line) - n, "mate %d", -(VALUE_MATE + score) / 2);
+    else n += snprintf(line + n, sizeof(line) - n, "cp %d", score);
+    n += snprintf(line + n, sizeof(line) - n, " nodes %" PRIu64 " nps %" PRIu64 " hashfull %d time %" PRId64 " pv",
+                  nodes, elapsed > 0 ? nodes * 1000 / (uint64_t)elapsed : nodes, tt_hashfull(st->tt), elapsed);
+    for (int i = 0; i < st->pv_length[0] && n < (int)sizeof(line) - 8; i++) {
+        move_to_uci(st->pv[0][i], text);
+        n += snprintf(line + n, sizeof(line) - n, " %s", text);
+    }
+    snprintf(line + n, sizeof(line) - n, "\n");
+    fputs(line, stdout);
+    fflush(stdout);
+}
+
+// Lazy SMP helpers skip some iterations so the threads spread over different depths
+static const int skip_size[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static const int skip_phase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Function to reset a thread for a new search of pos; returns 0 if pos has no legal moves
+int search_prepare(SearchThread *st, const Position *pos, const SearchLimits *limits) {
+    st->pos = *pos;
+    st->limits = *limits;
+    memset(&st->stats, 0, sizeof(st->stats));
+    st->best_move = MOVE_NONE;
+    st->best_score = 0;
+    st->completed_depth = 0;
+    memset(st->killers, 0, sizeof(st->killers));
+    memset(st->history, 0, sizeof(st->history));
+    memset(st->iteration_nodes, 0, sizeof(st->iteration_nodes));
+    memset(st->iteration_time, 0, sizeof(st->iteration_time));
+    st->pawns.probes = st->pawns.hits = 0;
+    st->use_nnue = nnue_loaded() && !st->classical_eval;
+    st->nnue_acc[0].computed[0] = st->nnue_acc[0].computed[1] = 0;
+
+    st->root_in_bitbase = bitbase_covers(&st->pos);
+    generate_legal_moves(&st->pos, &st->root_moves);
+    if (st->root_moves.count == 0) return 0;
+
+    // Always have something to play, even if the first iteration is cut short
+    st->best_move = st->root_moves.moves[0];
+    return 1;
+}
+
+// Function to run iterative deepening on a prepared thread until the limits or the stop flag end it
+void search_iterate(SearchThread *st) {
+    int max_depth = (st->limits.depth > 0 && st->limits.depth < MAX_PLY) ? st->limits.depth : MAX_PLY - 1;
+
+    for (int depth = 1; depth <= max_depth; depth++) {
+        if (st->id > 0) {
+            int i = (st->id - 1) % 20;
+            if (((depth + skip_phase[i]) / skip_size[i]) % 2) continue;
+        }
+
+        search_depth(st, depth);
+        if (stopped(st)) break;
+
+        st->completed_depth = depth;
+        st->iteration_nodes[depth] = st->stats.nodes;
+        st->iteration_time[depth] = search_elapsed(st);
+        if (st->print_info && st->id == 0) print_info(st, depth);
+
+        // A forced mate will not get any shorter with more depth
+        if (st->best_score >= VALUE_MATE_IN_MAX_PLY && VALUE_MATE - st->best_score <= depth) break;
+
+        // The next iteration would most likely not finish in the remaining time
+        if (st->id == 0 && st->limits.optimum_time && clock_running(st)
+            && search_elapsed(st) >= st->limits.optimum_time) break;
+    }
+}
+
+// Function to run a single-threaded search; returns the best move found
+// within the budget, or MOVE_NONE when the position has no legal moves
+Move search_position(SearchThread *st, const Position *pos, const SearchLimits *limits) {
+    st->signals = &st->own_signals;
+    atomic_store(&st->signals->stop, 0);
+    atomic_store(&st->signals->pondering, 0);
+    atomic_store(&st->signals->start_time, now_ms());
+    st->id = 0;
+    st->threads = st;
+    st->thread_count = 1;
+
+    tt_new_search(st->tt);
+    if (!search_prepare(st, pos, limits)) return MOVE_NONE;
+    search_iterate(st);
+    return st->best_move;
+}
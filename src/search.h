@@ -0,0 +1,169 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "position.h"
+#include "movegen.h"
+#include "tt.h"
+#include "movepick.h"
+#include "pawns.h"
+#include "stats.h"
+#include "nnue.h"
+
+#define MAX_PLY 128
+
+#define VALUE_DRAW 0
+#define VALUE_MATE 31000
+#define VALUE_INFINITE 32000
+#define VALUE_MATE_IN_MAX_PLY (VALUE_MATE - MAX_PLY)
+#define VALUE_NONE 32001          // no static eval: the node was in check
+
+// Quiescence search results are stored in the table below every real search depth
+#define DEPTH_QS 0
+// Best-case positional swing a capture can add on top of the captured material
+#define DELTA_MARGIN 200
+
+// Selective search techniques; SearchThread.pruning_off switches any of them off
+#define PRUNE_NULL_MOVE 1
+#define PRUNE_LMR 2               // late move reductions
+#define PRUNE_FUTILITY 4          // futility and reverse futility pruning near the leaves
+#define PRUNE_ASPIRATION 8        // aspiration windows at the root
+#define PRUNE_PVS 16              // zero-window searches for every move after the first
+#define PRUNE_ALL 31
+
+// Null move: tried from this depth, with the reduction growing by one every NULL_MOVE_DEPTH_STEP plies
+#define NULL_MOVE_MIN_DEPTH 3
+#define NULL_MOVE_REDUCTION 2
+#define NULL_MOVE_DEPTH_STEP 4
+// Late move reductions: quiet moves from this legal move index on, at this depth or more
+#define LMR_MIN_MOVES 4
+#define LMR_MIN_DEPTH 3
+// Futility pruning within this many plies of the horizon, the margin growing per ply
+#define FUTILITY_MAX_DEPTH 3
+#define FUTILITY_MARGIN 150
+#define REVERSE_FUTILITY_MARGIN 120
+// Aspiration window half-width around the last score, from this depth on; it doubles on every failure
+#define ASPIRATION_MIN_DEPTH 4
+#define ASPIRATION_WINDOW 30
+
+// Time kept in reserve for the GUI and the pipe on every move
+#define MOVE_OVERHEAD_MS 30
+// Moves assumed to remain when the clock does not say
+#define DEFAULT_MOVES_TO_GO 30
+
+// Budget for one search; a zero field means "no limit"
+typedef struct {
+    int depth;
+    uint64_t nodes;
+    int64_t movetime;         // hard limit in milliseconds
+    int64_t optimum_time;     // no new iteration starts after this many milliseconds
+} SearchLimits;
+
+// Flags shared by every thread of one search and by whoever controls it
+typedef struct {
+    atomic_int stop;
+    atomic_int pondering;     // go ponder/infinite: ignore the clock, hold the result until told
+    _Atomic int64_t start_time;
+} SearchSignals;
+
+// Beta cutoffs are counted by the index of the move that caused them; the last
+// slot collects every later move
+#define CUTOFF_SLOTS 8
+
+// Counters collected while searching; each thread owns its copy, so updates never
+// contend, and they are only summed once the search is over
+typedef struct {
+    uint64_t nodes;               // every node, quiescence included
+    uint64_t qnodes;              // nodes searched by the quiescence search
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+    uint64_t tt_cutoffs;
+    uint64_t interior_nodes;      // nodes that searched at least one move
+    uint64_t moves_searched;      // legal moves searched at those nodes
+    uint64_t cutoffs;             // beta cutoffs
+    uint64_t cutoffs_by_move[CUTOFF_SLOTS];  // beta cutoffs by the legal move index that caused them
+    uint64_t bitbase_hits;        // nodes scored exactly by an endgame bitbase
+    uint64_t pawn_probes;         // filled in from the pawn table by search_total_stats
+    uint64_t pawn_hits;
+    int seldepth;                 // deepest ply reached, quiescence included
+} SearchStats;
+
+// Everything one search needs; no search state lives in globals
+typedef struct SearchThread {
+    Position pos;             // private copy, so threads never share a board
+    TranspositionTable *tt;   // shared; may be used by several threads
+    SearchLimits limits;
+    SearchStats stats;
+    SearchSignals *signals;   // shared by every thread of one search
+    SearchSignals own_signals;  // target of signals when searching alone
+    int id;                   // 0 is the main thread, which owns the clock and output
+    struct SearchThread *threads;
+    int thread_count;
+    int print_info;           // print a UCI-style info line per iteration
+    int plain_order;          // search moves in generation order (for measuring the ordering)
+    int plain_pawns;          // recompute the pawn structure at every evaluation (for measuring the pawn table)
+    int root_in_bitbase;      // the root is a bitbase endgame: search on, use the tables at the leaves
+    int classical_eval;       // evaluate with the hand-written terms even when a network is loaded
+    int use_nnue;             // set by search_prepare: a network is loaded and classical_eval is off
+    int pruning_off;          // PRUNE_* techniques not to use (for measuring them)
+
+    Move pv[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY];
+    MoveList root_moves;
+    Move killers[MAX_PLY][2];   // last two quiet moves that caused a cutoff at each ply
+    HistoryTable history;
+    PawnTable pawns;          // private, kept from one search to the next
+    uint64_t iteration_nodes[MAX_PLY];  // nodes searched when each iteration completed
+    int64_t iteration_time[MAX_PLY];    // milliseconds elapsed when each iteration completed
+    NnueAccumulator nnue_acc[MAX_PLY + 1];  // per ply, computed lazily by nnue_evaluate
+    DirtyPieces nnue_dirty[MAX_PLY + 1];    // the move that led to each ply
+    Move played[MAX_PLY + 1];   // the move that led to each ply, MOVE_NONE for a null move
+
+    Move best_move;
+    int best_score;
+    int completed_depth;
+} SearchThread;
+
+// Function to turn a clock (and increment, in milliseconds) into a hard limit and an
+// optimum time for the next move; moves_to_go 0 means the rest of the game
+void search_allocate_time(SearchLimits *limits, int64_t time, int64_t inc, int moves_to_go);
+
+// Function to reset a thread for a new search of pos; returns 0 if pos has no legal moves
+int search_prepare(SearchThread *st, const Position *pos, const SearchLimits *limits);
+
+// Function to run iterative deepening on a prepared thread until the limits or the stop flag end it
+void search_iterate(SearchThread *st);
+
+// Function to run a single-threaded search; returns the best move found
+// within the budget, or MOVE_NONE when the position has no legal moves
+Move search_position(SearchThread *st, const Position *pos, const SearchLimits *limits);
+
+// Function to get the milliseconds since the search (or the ponderhit) started
+int64_t search_elapsed(const SearchThread *st);
+
+// Function to sum the nodes searched by every thread of the search
+uint64_t search_total_nodes(const SearchThread *st);
+
+// Function to get the deepest ply reached by any thread of the search
+int search_seldepth(const SearchThread *st);
+
+// Function to sum the counters of every thread of the search (seldepth is the maximum)
+void search_total_stats(const SearchThread *st, SearchStats *total);
+
+// Function to add one set of counters into another
+void stats_add(SearchStats *total, const SearchStats *part);
+
+// Function to write counters as a single-line JSON object; st, if given, adds the depth
+// reached and the nodes and time to each completed depth of its search
+void stats_write_json(FILE *out, const char *label, const SearchStats *stats, int64_t time_ms,
+                      const SearchThread *st);
+
+// Function to check for a draw by the fifty-move rule or repetition
+int is_draw(const Position *pos);
+
+// Function to check if neither side has enough material left to ever mate
+int is_insufficient_material(const Position *pos);
+
+#endif
@@ -0,0 +1,678 @@
+#define _GNU_SOURCE  // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "server.h"
+#include "game.h"
+#include "misc.h"
+
+#define SERVER_BACKLOG 4096
+#define SERVER_EVENTS 256
+#define SERVER_INPUT 4096         // longest request line, with room to spare
+#define SERVER_MAX_BACKLOG (1 << 20)  // pending output that stops reading a connection
+#define GAME_BLOCK 1024           // games are allocated in blocks that never move
+#define MAX_GAME_BLOCKS 1024
+#define LATENCY_RING 65536        // latest move latencies kept for the percentiles
+#define REPLY_SIZE 96
+
+struct Connection;
+
+// One hosted game. The main thread owns it except while busy, when the job fields
+// and the game state belong to the worker searching it
+typedef struct ServerGame {
+    GameState state;
+    struct Connection *owner; // NULL once the connection went away
+    struct ServerGame *prev_owned, *next_owned;  // links in the owner's list of games
+    int id;
+    int in_use;
+    int busy;
+    int next_free;
+    struct ServerGame *next_job;  // link in the work queue or the finished list
+    char move[8];             // client move to play before searching; empty for go
+    int64_t received_ns;
+    char reply[REPLY_SIZE];
+} ServerGame;
+
+// One client connection: a line-buffered input and a growing output buffer
+typedef struct Connection {
+    int fd;
+    uint32_t events;          // epoll events currently registered
+    char in[SERVER_INPUT];
+    size_t in_used;
+    int discarding;           // dropping the rest of an overlong line
+    char *out;
+    size_t out_used, out_sent, out_size;
+    int dirty;                // has output waiting for the next flush
+    ServerGame *games;        // games this connection owns, so closing it skips the rest
+    struct Connection *next_closed;
+} Connection;
+
+struct Server;
+
+// Search worker with its own engine and table
+typedef struct {
+    struct Server *server;
+    SearchThread *search;
+    TranspositionTable tt;
+    Position pos;
+    _Atomic int64_t busy_ns;
+    _Atomic uint64_t jobs;
+    pthread_t handle;
+} ServerWorker;
+
+typedef struct Server {
+    const ServerSettings *settings;
+    int epoll_fd, listen_fd, wake_fd;
+    ServerWorker *workers;
+    int worker_count;
+
+    ServerGame *blocks[MAX_GAME_BLOCKS];
+    int block_count;
+    int free_game;            // head of the free list, -1 if empty
+    int active_games;
+    uint64_t games_created;
+
+    // Work queue and finished list, shared with the workers
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    ServerGame *queue_head, *queue_tail;
+    ServerGame *done_head;
+    int stopping;
+
+    Connection *closed;       // freed once the current batch of events is handled
+    Connection **dirty;
+    int dirty_count, dirty_size;
+    uint64_t connections;
+    uint64_t moves;
+    int32_t latency_us[LATENCY_RING];
+    int64_t start_ns;
+    Position scratch;         // for fen replies on the main thread
+} Server;
+
+static volatile sig_atomic_t server_stop = 0;
+
+// Function to note a SIGINT or SIGTERM for the event loop
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    server_stop = 1;
+}
+
+// Function to fill a socket address from "port", "host:port" or "unix:path"; returns its length or 0
+static socklen_t parse_address(const char *text, struct sockaddr_storage *storage) {
+    memset(storage, 0, sizeof(*storage));
+    if (strncmp(text, "unix:", 5) == 0) {
+        struct sockaddr_un *un = (struct sockaddr_un *)storage;
+        if (strlen(text + 5) >= sizeof(un->sun_path)) return 0;
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, text + 5);
+        return sizeof(*un);
+    }
+
+    struct sockaddr_in *in = (struct sockaddr_in *)storage;
+    char host[64] = "127.0.0.1";
+    const char *colon = strrchr(text, ':');
+    const char *port = text;
+    if (colon) {
+        if ((size_t)(colon - text) >= sizeof(host)) return 0;
+        memcpy(host, text, colon - text);
+        host[colon - text] = '\0';
+        port = colon + 1;
+    }
+    in->sin_family = AF_INET;
+    in->sin_port = htons((uint16_t)atoi(port));
+    if (atoi(port) <= 0 || inet_pton(AF_INET, host, &in->sin_addr) != 1) return 0;
+    return sizeof(*in);
+}
+
+// Function to open a socket for an address, listening or connected; returns -1 on failure
+int server_socket(const char *address, int listening) {
+    struct sockaddr_storage storage;
+    socklen_t length = parse_address(address, &storage);
+    int one = 1;
+
+    if (!length) {
+        printf("Bad address %s (use port, host:port or unix:path)\n", address);
+        return -1;
+    }
+    int fd = socket(storage.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (listening) {
+        if (storage.ss_family == AF_UNIX) unlink(((struct sockaddr_un *)&storage)->sun_path);
+        else setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&storage, length) < 0 || listen(fd, SERVER_BACKLOG) < 0) {
+            perror(address);
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, (struct sockaddr *)&storage, length) < 0) {
+        perror(address);
+        close(fd);
+        return -1;
+    }
+    // Replies are single short lines; do not hold them back
+    if (storage.ss_family != AF_UNIX) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Function to get a game by id
+static ServerGame *game_at(Server *s, int id) {
+    return &s->blocks[id / GAME_BLOCK][id % GAME_BLOCK];
+}
+
+// Function to take a free game slot, growing the table by a block if needed; NULL when full
+static ServerGame *allocate_game(Server *s, Connection *owner) {
+    if (s->free_game < 0) {
+        if (s->block_count == MAX_GAME_BLOCKS) return NULL;
+        ServerGame *block = calloc(GAME_BLOCK, sizeof(ServerGame));
+        if (!block) return NULL;
+        s->blocks[s->block_count] = block;
+        // Chain the new slots so that the lowest id comes out first
+        for (int i = GAME_BLOCK - 1; i >= 0; i--) {
+            block[i].id = s->block_count * GAME_BLOCK + i;
+            block[i].next_free = s->free_game;
+            s->free_game = block[i].id;
+        }
+        s->block_count++;
+    }
+
+    ServerGame *g = game_at(s, s->free_game);
+    s->free_game = g->next_free;
+    g->owner = owner;
+    g->prev_owned = NULL;
+    g->next_owned = owner->games;
+    if (owner->games) owner->games->prev_owned = g;
+    owner->games = g;
+    g->in_use = 1;
+    g->busy = 0;
+    s->active_games++;
+    s->games_created++;
+    return g;
+}
+
+// Function to take a game off its owner's list; a busy game stays in use until its job comes back
+static void disown_game(ServerGame *g) {
+    if (!g->owner) return;
+    if (g->prev_owned) g->prev_owned->next_owned = g->next_owned;
+    else g->owner->games = g->next_owned;
+    if (g->next_owned) g->next_owned->prev_owned = g->prev_owned;
+    g->prev_owned = g->next_owned = NULL;
+    g->owner = NULL;
+}
+
+// Function to return a game slot to the free list
+static void release_game(Server *s, ServerGame *g) {
+    disown_game(g);
+    g->in_use = 0;
+    g->next_free = s->free_game;
+    s->free_game = g->id;
+    s->active_games--;
+}
+
+// Function to search one game on a worker: play the client's move, if any, then the reply
+static void run_job(ServerWorker *w, ServerGame *g) {
+    Position *pos = &w->pos;
+    char text[6];
+
+    game_position(&g->state, pos);
+    int result = game_result(pos);
+    if (result != RESULT_UNKNOWN) {
+        snprintf(g->reply, REPLY_SIZE, "error %d game-over %s\n", g->id, game_result_text(result));
+        return;
+    }
+    if (g->move[0]) {
+        Move move = parse_uci_move(pos, g->move);
+        if (move == MOVE_NONE) {
+            snprintf(g->reply, REPLY_SIZE, "error %d illegal-move %s\n", g->id, g->move);
+            return;
+        }
+        game_play(&g->state, pos, move);
+        result = game_result(pos);
+    }
+
+    Move best = MOVE_NONE;
+    if (result == RESULT_UNKNOWN) {
+        best = search_position(w->search, pos, &w->server->settings->limits);
+        game_play(&g->state, pos, best);
+        result = game_result(pos);
+    }
+    move_to_uci(best, text);
+    snprintf(g->reply, REPLY_SIZE, "bestmove %d %s %s\n", g->id, text, game_result_text(result));
+}
+
+// Function to run one worker: take the oldest job, search it, hand it back to the main thread
+static void *worker_main(void *arg) {
+    ServerWorker *w = arg;
+    Server *s = w->server;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (!s->queue_head && !s->stopping) pthread_cond_wait(&s->work_ready, &s->lock);
+        ServerGame *g = s->queue_head;
+        if (!g) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        s->queue_head = g->next_job;
+        if (!s->queue_head) s->queue_tail = NULL;
+        pthread_mutex_unlock(&s->lock);
+
+        int64_t start = now_ns();
+        run_job(w, g);
+        atomic_fetch_add_explicit(&w->busy_ns, now_ns() - start, memory_order_relaxed);
+        atomic_fetch_add_explicit(&w->jobs, 1, memory_order_relaxed);
+
+        // Only the job that finds the list empty has to wake the main thread; it
+        // takes the whole list each time it wakes
+        pthread_mutex_lock(&s->lock);
+        int wake = s->done_head == NULL;
+        g->next_job = s->done_head;
+        s->done_head = g;
+        pthread_mutex_unlock(&s->lock);
+        if (wake) {
+            uint64_t one = 1;
+            if (write(s->wake_fd, &one, sizeof(one)) < 0) perror("eventfd");
+        }
+    }
+    return NULL;
+}
+
+// Function to queue a game for a worker
+static void queue_job(Server *s, ServerGame *g) {
+    g->busy = 1;
+    g->next_job = NULL;
+    pthread_mutex_lock(&s->lock);
+    if (s->queue_tail) s->queue_tail->next_job = g;
+    else s->queue_head = g;
+    s->queue_tail = g;
+    pthread_cond_signal(&s->work_ready);
+    pthread_mutex_unlock(&s->lock);
+}
+
+// Function to register the epoll events a connection needs: input unless too much
+// output is waiting for the client, and output while there is any
+static void update_events(Server *s, Connection *c) {
+    size_t backlog = c->out_used - c->out_sent;
+    uint32_t events = (backlog < SERVER_MAX_BACKLOG ? EPOLLIN : 0) | (backlog ? EPOLLOUT : 0);
+
+    if (events != c->events) {
+        struct epoll_event ev = {.events = events, .data.ptr = c};
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->events = events;
+    }
+}
+
+// Function to append text to a connection's output; it goes out at the next flush
+static void send_text(Server *s, Connection *c, const char *text) {
+    size_t length = strlen(text);
+
+    if (c->fd < 0) return;
+    if (c->out_used + length > c->out_size) {
+        size_t size = c->out_size ? c->out_size : 4096;
+        while (c->out_used + length > size) size *= 2;
+        char *out = realloc(c->out, size);
+        if (!out) return;
+        c->out = out;
+        c->out_size = size;
+    }
+    memcpy(c->out + c->out_used, text, length);
+    c->out_used += length;
+    if (!c->dirty) {
+        if (s->dirty_count == s->dirty_size) {
+            s->dirty_size = s->dirty_size ? 2 * s->dirty_size : 64;
+            s->dirty = realloc(s->dirty, s->dirty_size * sizeof(Connection *));
+        }
+        s->dirty[s->dirty_count++] = c;
+        c->dirty = 1;
+    }
+}
+
+// Function to close a connection; games still searching are released when their job comes back
+static void close_connection(Server *s, Connection *c) {
+    if (c->fd < 0) return;
+    while (c->games) {
+        ServerGame *g = c->games;
+        if (g->busy) disown_game(g);
+        else release_game(s, g);
+    }
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->next_closed = s->closed;
+    s->closed = c;
+}
+
+// Function to write as much pending output as the socket takes
+static void flush_output(Server *s, Connection *c) {
+    c->dirty = 0;
+    while (c->fd >= 0 && c->out_sent < c->out_used) {
+        ssize_t n = send(c->fd, c->out + c->out_sent, c->out_used - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) close_connection(s, c);
+            break;
+        }
+        c->out_sent += (size_t)n;
+    }
+    if (c->fd < 0) return;
+    if (c->out_sent == c->out_used) c->out_sent = c->out_used = 0;
+    update_events(s, c);
+}
+
+// Function to get the p-th percentile (0-100) of the recent move latencies in microseconds
+static int64_t latency_percentile(const Server *s, double p) {
+    static int32_t sorted[LATENCY_RING];
+    size_t count = s->moves < LATENCY_RING ? (size_t)s->moves : LATENCY_RING;
+
+    memcpy(sorted, s->latency_us, count * sizeof(int32_t));
+    return percentile_int32(sorted, count, p);
+}
+
+// Function to sum the workers' search time and jobs
+static void worker_totals(const Server *s, int64_t *busy_ns, uint64_t *jobs) {
+    *busy_ns = 0;
+    *jobs = 0;
+    for (int i = 0; i < s->worker_count; i++) {
+        *busy_ns += atomic_load_explicit(&s->workers[i].busy_ns, memory_order_relaxed);
+        *jobs += atomic_load_explicit(&s->workers[i].jobs, memory_order_relaxed);
+    }
+}
+
+// Function to find a game of this connection from its id text; replies with an error if there is none
+static ServerGame *find_game(Server *s, Connection *c, const char *text) {
+    char reply[REPLY_SIZE];
+    char *end;
+    long id = text ? strtol(text, &end, 10) : -1;
+
+    if (text && *end == '\0' && id >= 0 && id < (long)s->block_count * GAME_BLOCK) {
+        ServerGame *g = game_at(s, (int)id);
+        if (g->in_use && g->owner == c) return g;
+    }
+    snprintf(reply, sizeof(reply), "error %.16s unknown-game\n", text ? text : "-");
+    send_text(s, c, reply);
+    return NULL;
+}
+
+// Function to handle one request line
+static void handle_line(Server *s, Connection *c, char *line, int64_t received) {
+    char reply[256];
+    char *save = NULL;
+    char *command = strtok_r(line, " \t", &save);
+    ServerGame *g;
+
+    if (!command) return;
+    if (strcmp(command, "new") == 0) {
+        char *fen = strtok_r(NULL, "", &save);
+        g = allocate_game(s, c);
+        if (!g) {
+            send_text(s, c, "error - server-full\n");
+        } else if (!game_init(&g->state, fen && *fen ? fen : START_FEN)) {
+            release_game(s, g);
+            send_text(s, c, "error - bad-fen\n");
+        } else {
+            snprintf(reply, sizeof(reply), "game %d\n", g->id);
+            send_text(s, c, reply);
+        }
+    } else if (strcmp(command, "move") == 0 || strcmp(command, "go") == 0) {
+        if (!(g = find_game(s, c, strtok_r(NULL, " \t", &save)))) return;
+        char *move = command[0] == 'm' ? strtok_r(NULL, " \t", &save) : "";
+        if (g->busy) {
+            snprintf(reply, sizeof(reply), "error %d busy\n", g->id);
+            send_text(s, c, reply);
+        } else if (!move || strlen(move) >= sizeof(g->move)) {
+            snprintf(reply, sizeof(reply), "error %d illegal-move %.8s\n", g->id, move ? move : "");
+            send_text(s, c, reply);
+        } else {
+            strcpy(g->move, move);
+            g->received_ns = received;
+            queue_job(s, g);
+        }
+    } else if (strcmp(command, "fen") == 0) {
+        if (!(g = find_game(s, c, strtok_r(NULL, " \t", &save)))) return;
+        if (g->busy) {
+            snprintf(reply, sizeof(reply), "error %d busy\n", g->id);
+        } else {
+            int n = snprintf(reply, sizeof(reply), "fen %d ", g->id);
+            game_position(&g->state, &s->scratch);
+            position_get_fen(&s->scratch, reply + n, (int)sizeof(reply) - n - 1);
+            strcat(reply, "\n");
+        }
+        send_text(s, c, reply);
+    } else if (strcmp(command, "close") == 0) {
+        if (!(g = find_game(s, c, strtok_r(NULL, " \t", &save)))) return;
+        snprintf(reply, sizeof(reply), "closed %d\n", g->id);
+        if (g->busy) disown_game(g);
+        else release_game(s, g);
+        send_text(s, c, reply);
+    } else if (strcmp(command, "stats") == 0) {
+        int64_t busy_ns;
+        uint64_t jobs;
+        worker_totals(s, &busy_ns, &jobs);
+        snprintf(reply, sizeof(reply), "stats workers %d games %d jobs %" PRIu64 " busy_ms %" PRId64
+                 " uptime_ms %" PRId64 " p50_us %" PRId64 " p99_us %" PRId64 "\n", s->worker_count,
+                 s->active_games, jobs, busy_ns / 1000000, (now_ns() - s->start_ns) / 1000000,
+                 latency_percentile(s, 50), latency_percentile(s, 99));
+        send_text(s, c, reply);
+    } else if (strcmp(command, "quit") == 0) {
+        close_connection(s, c);
+    } else {
+        send_text(s, c, "error - unknown-command\n");
+    }
+}
+
+// Function to read what a connection has sent and handle every complete line
+static void read_connection(Server *s, Connection *c) {
+    for (;;) {
+        ssize_t n = recv(c->fd, c->in + c->in_used, sizeof(c->in) - c->in_used, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_connection(s, c);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        int64_t received = now_ns();
+        size_t start = 0;
+        c->in_used += (size_t)n;
+        for (size_t i = c->in_used - (size_t)n; i < c->in_used && c->fd >= 0; i++) {
+            if (c->in[i] != '\n') continue;
+            c->in[i] = '\0';
+            if (i > start && c->in[i - 1] == '\r') c->in[i - 1] = '\0';
+            if (!c->discarding) handle_line(s, c, c->in + start, received);
+            c->discarding = 0;
+            start = i + 1;
+        }
+        if (c->fd < 0) return;
+
+        memmove(c->in, c->in + start, c->in_used - start);
+        c->in_used -= start;
+        if (c->in_used == sizeof(c->in)) {
+            send_text(s, c, "error - line-too-long\n");
+            c->in_used = 0;
+            c->discarding = 1;
+        }
+        // Stop taking requests while the client is not reading its replies
+        if (c->out_used - c->out_sent >= SERVER_MAX_BACKLOG) return;
+    }
+}
+
+// Function to accept every pending connection
+static void accept_connections(Server *s) {
+    for (;;) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        Connection *c = calloc(1, sizeof(Connection));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        c->fd = fd;
+        c->events = EPOLLIN;
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        s->connections++;
+    }
+}
+
+// Function to hand finished searches back to their connections
+static void collect_results(Server *s) {
+    uint64_t count;
+    if (read(s->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("eventfd");
+
+    pthread_mutex_lock(&s->lock);
+    ServerGame *g = s->done_head;
+    s->done_head = NULL;
+    pthread_mutex_unlock(&s->lock);
+
+    int64_t now = now_ns();
+    while (g) {
+        ServerGame *next = g->next_job;
+        g->busy = 0;
+        if (!g->owner) {
+            release_game(s, g);
+        } else {
+            send_text(s, g->owner, g->reply);
+            s->latency_us[s->moves % LATENCY_RING] = (int32_t)((now - g->received_ns) / 1000);
+            s->moves++;
+        }
+        g = next;
+    }
+}
+
+// Function to start the workers and register the listening and wake-up descriptors; returns 1 on success
+static int server_start(Server *s) {
+    size_t worker_mb = s->settings->hash_mb / (size_t)s->worker_count;
+
+    s->free_game = -1;
+    s->start_ns = now_ns();
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work_ready, NULL);
+
+    s->listen_fd = server_socket(s->settings->address, 1);
+    if (s->listen_fd < 0) return 0;
+    fcntl(s->listen_fd, F_SETFL, O_NONBLOCK);
+    s->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (s->wake_fd < 0 || s->epoll_fd < 0) return 0;
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &s->listen_fd};
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->listen_fd, &ev);
+    ev.data.ptr = &s->wake_fd;
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->wake_fd, &ev);
+
+    s->workers = calloc((size_t)s->worker_count, sizeof(ServerWorker));
+    if (!s->workers) return 0;
+    for (int i = 0; i < s->worker_count; i++) {
+        ServerWorker *w = &s->workers[i];
+        w->server = s;
+        w->search = calloc(1, sizeof(SearchThread));
+        if (!w->search || !tt_init(&w->tt, worker_mb ? worker_mb : 1)) return 0;
+        w->search->tt = &w->tt;
+        pthread_create(&w->handle, NULL, worker_main, w);
+    }
+    return 1;
+}
+
+// Function to serve games on the address until SIGINT or SIGTERM; returns the exit code
+int run_server(const ServerSettings *settings) {
+    static Server server;
+    Server *s = &server;
+    struct epoll_event events[SERVER_EVENTS];
+    struct sigaction action;
+
+    s->settings = settings;
+    s->worker_count = settings->workers > 0 ? settings->workers : 1;
+    if (!server_start(s)) {
+        printf("Could not start the server on %s\n", settings->address);
+        return 1;
+    }
+
+    // No SA_RESTART, so a signal interrupts epoll_wait
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    printf("Serving on %s with %d workers\n", settings->address, s->worker_count);
+    fflush(stdout);
+
+    while (!server_stop) {
+        int n = epoll_wait(s->epoll_fd, events, SERVER_EVENTS, 1000);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &s->listen_fd) {
+                accept_connections(s);
+            } else if (ptr == &s->wake_fd) {
+                collect_results(s);
+            } else {
+                Connection *c = ptr;
+                if (c->fd >= 0 && (events[i].events & (EPOLLERR | EPOLLHUP))) close_connection(s, c);
+                if (c->fd >= 0 && (events[i].events & EPOLLOUT)) flush_output(s, c);
+                if (c->fd >= 0 && (events[i].events & EPOLLIN)) read_connection(s, c);
+            }
+        }
+
+        // One send per connection for everything this batch produced
+        for (int i = 0; i < s->dirty_count; i++) flush_output(s, s->dirty[i]);
+        s->dirty_count = 0;
+        while (s->closed) {
+            Connection *c = s->closed;
+            s->closed = c->next_closed;
+            free(c->out);
+            free(c);
+        }
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->stopping = 1;
+    pthread_cond_broadcast(&s->work_ready);
+    pthread_mutex_unlock(&s->lock);
+    for (int i = 0; i < s->worker_count; i++) pthread_join(s->workers[i].handle, NULL);
+
+    int64_t busy_ns;
+    uint64_t jobs;
+    double seconds = (now_ns() - s->start_ns) / 1e9;
+    worker_totals(s, &busy_ns, &jobs);
+    printf("Connections: %" PRIu64 ", games: %" PRIu64 "\n", s->connections, s->games_created);
+    printf("Moves: %" PRIu64 " (%.0f per second)\n", s->moves, seconds > 0 ? s->moves / seconds : 0.0);
+    printf("Latency: p50 %.2f ms, p99 %.2f ms (last %d moves)\n", latency_percentile(s, 50) / 1000.0,
+           latency_percentile(s, 99) / 1000.0, LATENCY_RING);
+    printf("Workers: %.1f%% busy\n", seconds > 0 ? 100.0 * busy_ns / 1e9 / (seconds * s->worker_count) : 0.0);
+
+    for (int i = 0; i < s->worker_count; i++) {
+        tt_free(&s->workers[i].tt);
+        free(s->workers[i].search);
+    }
+    free(s->workers);
+    for (int b = 0; b < s->block_count; b++) free(s->blocks[b]);
+    free(s->dirty);
+    close(s->epoll_fd);
+    close(s->wake_fd);
+    close(s->listen_fd);
+    if (strncmp(settings->address, "unix:", 5) == 0) unlink(settings->address + 5);
+    return 0;
+}
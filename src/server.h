@@ -0,0 +1,50 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include "search.h"
+
+// Per-move node budget when the server is given no other limit; small, since one
+// process is meant to keep thousands of games moving
+#define SERVER_DEFAULT_NODES 5000
+
+// Line protocol, one request or reply per line. Replies to new, fen, close and stats
+// come back at once and in order; bestmove replies come whenever a search finishes.
+//   new [fen]         -> game <id>
+//   move <id> <uci>   -> bestmove <id> <uci|0000> <result>   client move, then the engine's
+//   go <id>           -> bestmove <id> <uci|0000> <result>   engine moves
+//   fen <id>          -> fen <id> <fen>
+//   close <id>        -> closed <id>
+//   stats             -> stats workers <n> games <n> jobs <n> busy_ms <n> uptime_ms <n> p50_us <n> p99_us <n>
+//   quit              closes the connection and every game it opened
+// The result is "*" while the game goes on, else "1-0", "0-1" or "1/2-1/2"; 0000 means the
+// client's move ended the game. Failures reply "error <id|-> <reason>".
+
+typedef struct {
+    const char *address;      // "port", "host:port" (IPv4) or "unix:path"
+    SearchLimits limits;
+    int workers;
+    size_t hash_mb;           // split between the workers
+} ServerSettings;
+
+// Synthetic clients for the server: every game plays random legal moves and waits
+// for the engine's reply, and a finished game is replaced by a new one
+typedef struct {
+    const char *address;
+    int games;                // games in flight at once
+    int connections;          // the games are spread over this many connections
+    int seconds;
+    int think_ms;             // mean pause before each client move
+} LoadSettings;
+
+// Function to open a socket for an address, listening or connected; returns -1 on failure
+int server_socket(const char *address, int listening);
+
+// Function to serve games on the address until SIGINT or SIGTERM; returns the exit code
+int run_server(const ServerSettings *settings);
+
+// Function to load a running server with synthetic games and report move latency
+// percentiles and throughput per core; returns the process exit code
+int run_load_generator(const LoadSettings *settings);
+
+#endif
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "smp.h"
+#include "misc.h"
+
+// Function to allocate count search threads sharing one table; returns 1 on success
+int pool_init(SearchPool *pool, int count, TranspositionTable *tt) {
+    if (count < 1) count = 1;
+    if (count > MAX_THREADS) count = MAX_THREADS;
+
+    pool->threads = calloc((size_t)count, sizeof(SearchThread));
+    if (!pool->threads) {
+        printf("Could not allocate %d search threads\n", count);
+        pool->count = 0;
+        return 0;
+    }
+    pool->count = count;
+    pool->best = &pool->threads[0];
+    atomic_init(&pool->signals.stop, 0);
+    atomic_init(&pool->signals.pondering, 0);
+    atomic_init(&pool->signals.start_time, 0);
+
+    for (int i = 0; i < count; i++) {
+        SearchThread *st = &pool->threads[i];
+        st->tt = tt;
+        st->signals = &pool->signals;
+        st->id = i;
+        st->threads = pool->threads;
+        st->thread_count = count;
+    }
+    return 1;
+}
+
+// Function to release the pool's threads
+void pool_free(SearchPool *pool) {
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->count = 0;
+}
+
+// Function to ask a running pool_search to finish as soon as possible
+void pool_stop(SearchPool *pool) {
+    atomic_store(&pool->signals.stop, 1);
+}
+
+// Function to switch a pondering search to normal timing, with the clock starting now
+void pool_ponderhit(SearchPool *pool) {
+    atomic_store(&pool->signals.start_time, now_ms());
+    atomic_store(&pool->signals.pondering, 0);
+}
+
+// Function to run one helper thread's search
+static void *helper_main(void *arg) {
+    search_iterate((SearchThread *)arg);
+    return NULL;
+}
+
+// Function to search with every thread of the pool; returns the chosen best move
+Move pool_search(SearchPool *pool, const Position *pos, const SearchLimits *limits) {
+    pthread_t handles[MAX_THREADS];
+    int print_info = pool->threads[0].print_info;
+
+    atomic_store(&pool->signals.stop, 0);
+    atomic_store(&pool->signals.start_time, now_ms());
+    tt_new_search(pool->threads[0].tt);
+    pool->best = &pool->threads[0];
+    for (int i = 0; i < pool->count; i++) {
+        if (!search_prepare(&pool->threads[i], pos, limits)) return MOVE_NONE;
+        pool->threads[i].print_info = (i == 0) && print_info;
+    }
+
+    int started = 1;
+    for (int i = 1; i < pool->count; i++) {
+        if (pthread_create(&handles[i], NULL, helper_main, &pool->threads[i]) != 0) break;
+        started++;
+    }
+
+    // The main thread ends the search for everyone once its own iterations are done,
+    // but a pondering search must wait for ponderhit or stop before answering
+    search_iterate(&pool->threads[0]);
+    while (atomic_load(&pool->signals.pondering) && !atomic_load(&pool->signals.stop)) {
+        sleep_ms(1);
+    }
+    atomic_store(&pool->signals.stop, 1);
+    for (int i = 1; i < started; i++) pthread_join(handles[i], NULL);
+
+    // Prefer the deepest completed iteration, then the better score
+    for (int i = 1; i < started; i++) {
+        SearchThread *st = &pool->threads[i];
+        if (st->completed_depth > pool->best->completed_depth
+            || (st->completed_depth == pool->best->completed_depth && st->best_score > pool->best->best_score)) {
+            pool->best = st;
+        }
+    }
+    return pool->best->best_move;
+}
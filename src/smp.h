@@ -0,0 +1,33 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "search.h"
+
+#define MAX_THREADS 256
+
+// Lazy SMP: every thread searches the same root on its own position copy,
+// sharing only the transposition table and the stop flag
+typedef struct {
+    SearchThread *threads;
+    int count;
+    SearchSignals signals;
+    SearchThread *best;       // thread whose result was chosen by the last search
+} SearchPool;
+
+// Function to allocate count search threads sharing one table; returns 1 on success
+int pool_init(SearchPool *pool, int count, TranspositionTable *tt);
+
+// Function to release the pool's threads
+void pool_free(SearchPool *pool);
+
+// Function to search with every thread of the pool; returns the chosen best move.
+// If signals.pondering is set the result is held until pool_stop or pool_ponderhit
+Move pool_search(SearchPool *pool, const Position *pos, const SearchLimits *limits);
+
+// Function to ask a running pool_search to finish as soon as possible
+void pool_stop(SearchPool *pool);
+
+// Function to switch a pondering search to normal timing, with the clock starting now
+void pool_ponderhit(SearchPool *pool);
+
+#endif
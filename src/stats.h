@@ -0,0 +1,17 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Search instrumentation is compiled in by default. Build with -DNO_SEARCH_STATS to
+// remove every counter update; node counts and selective depth, which the search and
+// the UCI output need, are kept either way
+#ifdef NO_SEARCH_STATS
+#define STATS_ENABLED 0
+#define STAT_INC(counter) ((void)0)
+#define STAT_ADD(counter, n) ((void)0)
+#else
+#define STATS_ENABLED 1
+#define STAT_INC(counter) ((counter)++)
+#define STAT_ADD(counter, n) ((counter) += (n))
+#endif
+
+#endif
@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "tournament.h"
+#include "movegen.h"
+#include "misc.h"
+#include "record.h"
+#include "game.h"
+
+#define OPENING_LINE 512
+#define RANDOM_PLIES 2            // random moves played after a built-in opening line
+#define OPENING_DEPTH 5           // depth of the search that checks an opening is balanced
+#define OPENING_MAX_SCORE 120     // openings scored beyond this are redrawn
+#define OPENING_ATTEMPTS 20
+#define RESIGN_SCORE 1000         // a side resigns after RESIGN_MOVES moves scored this badly
+#define RESIGN_MOVES 3
+#define DRAW_SCORE 10             // both sides within this of 0 for DRAW_PLIES plies
+#define DRAW_PLIES 16             // after DRAW_MIN_PLY is a draw
+#define DRAW_MIN_PLY 80
+#define REPORT_EVERY 10           // games between progress lines
+
+// Built-in openings as coordinate moves from the start position; each is played
+// twice with colors reversed, after a few random moves that keep the games apart
+static const char *builtin_openings[] = {
+    "e2e4 e7e5 g1f3 b8c6 f1b5",
+    "e2e4 e7e5 g1f3 b8c6 f1c4 f8c5",
+    "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3",
+    "e2e4 c7c5 b1c3 b8c6 g2g3",
+    "e2e4 e7e6 d2d4 d7d5 b1c3",
+    "e2e4 c7c6 d2d4 d7d5 e4e5",
+    "e2e4 d7d5 e4d5 d8d5 b1c3 d5a5",
+    "e2e4 g8f6 e4e5 f6d5 d2d4 d7d6",
+    "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6",
+    "d2d4 d7d5 c2c4 c7c6 g1f3 g8f6",
+    "d2d4 g8f6 c2c4 g7g6 b1c3 f8g7 e2e4 d7d6",
+    "d2d4 g8f6 c2c4 e7e6 b1c3 f8b4",
+    "d2d4 f7f5 g2g3 g8f6 f1g2",
+    "c2c4 e7e5 b1c3 g8f6 g2g3",
+    "g1f3 d7d5 g2g3 g8f6 f1g2",
+    "e2e4 e7e5 f2f4",
+};
+static const int builtin_opening_count = sizeof(builtin_openings) / sizeof(builtin_openings[0]);
+
+// One game as played, enough to write it out as PGN
+typedef struct {
+    char fen[128];            // start position; empty for the standard start
+    Move moves[MAX_GAME_PLY];
+    int ply_count;
+    int round;
+    int white;                // engine index playing White
+    int result;               // half points scored by White: 2, 1 or 0
+    const char *termination;  // PGN Termination tag; NULL if the game was abandoned
+    const char *reason;
+} GameRecord;
+
+// State shared by every worker of one match
+typedef struct {
+    const MatchSettings *settings;
+    char (*openings)[OPENING_LINE];
+    int opening_count;
+    int next_game;
+    int finished;
+    int wins, draws, losses;  // from engines[0]'s point of view
+    atomic_int stop;          // set once the SPRT has decided
+    FILE *pgn;
+    RecordWriter records;
+    int write_records;
+    int64_t start_time;
+    pthread_mutex_t lock;
+} Match;
+
+// Per-worker engines: each side keeps its own search state and table between games
+typedef struct {
+    Match *match;
+    SearchThread *engines[2];
+    TranspositionTable tt[2];
+    GameRecord record;
+    pthread_t handle;
+} MatchWorker;
+
+// Function to parse a "base+increment" time control given in seconds; returns 0 if malformed
+static int parse_time_control(const char *text, int64_t *base_ms, int64_t *inc_ms) {
+    double base = 0, inc = 0;
+    if (sscanf(text, "%lf+%lf", &base, &inc) < 1 || base <= 0 || inc < 0) return 0;
+    *base_ms = (int64_t)(base * 1000);
+    *inc_ms = (int64_t)(inc * 1000);
+    return 1;
+}
+
+// Function to map an engine setting name to the selective search technique it switches;
+// 0 if it is not one
+static int pruning_key(const char *name) {
+    if (strcmp(name, "nullmove") == 0) return PRUNE_NULL_MOVE;
+    if (strcmp(name, "lmr") == 0) return PRUNE_LMR;
+    if (strcmp(name, "futility") == 0) return PRUNE_FUTILITY;
+    if (strcmp(name, "aspiration") == 0) return PRUNE_ASPIRATION;
+    if (strcmp(name, "pvs") == 0) return PRUNE_PVS;
+    return 0;
+}
+
+// Function to apply "key=value,key=value" settings (name, nodes, depth, movetime, tc,
+// hash, order, eval, and nullmove, lmr, futility, aspiration, pvs set to on or off) on top of
+// an engine's defaults; returns 0 on an unknown or bad key
+int parse_engine_config(EngineConfig *engine, const char *text) {
+    char buf[256];
+    char *save = NULL;
+
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(tok, '=');
+        if (!value) {
+            printf("Engine setting %s needs a value\n", tok);
+            return 0;
+        }
+        *value++ = '\0';
+        if (strcmp(tok, "name") == 0) {
+            snprintf(engine->name, sizeof(engine->name), "%s", value);
+        } else if (strcmp(tok, "nodes") == 0) {
+            engine->limits.nodes = (uint64_t)atoll(value);
+        } else if (strcmp(tok, "depth") == 0) {
+            engine->limits.depth = atoi(value);
+        } else if (strcmp(tok, "movetime") == 0) {
+            engine->limits.movetime = atoll(value);
+        } else if (strcmp(tok, "hash") == 0) {
+            engine->hash_mb = (size_t)atol(value);
+        } else if (strcmp(tok, "tc") == 0) {
+            if (!parse_time_control(value, &engine->base_ms, &engine->inc_ms)) {
+                printf("Bad time control %s (expected seconds+increment, e.g. 10+0.1)\n", value);
+                return 0;
+            }
+        } else if (strcmp(tok, "order") == 0 && (strcmp(value, "plain") == 0 || strcmp(value, "staged") == 0)) {
+            engine->plain_order = value[0] == 'p';
+        } else if (strcmp(tok, "eval") == 0 && (strcmp(value, "classical") == 0 || strcmp(value, "nnue") == 0)) {
+            if (value[0] == 'n' && !nnue_loaded()) {
+                printf("eval=nnue needs a network (--nnue <file>)\n");
+                return 0;
+            }
+            engine->classical_eval = value[0] == 'c';
+        } else if (pruning_key(tok) && (strcmp(value, "on") == 0 || strcmp(value, "off") == 0)) {
+            if (value[1] == 'f') engine->pruning_off |= pruning_key(tok);
+            else engine->pruning_off &= ~pruning_key(tok);
+        } else {
+            printf("Unknown engine setting %s=%s\n", tok, value);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Function to read the FEN/EPD lines of an opening file; returns the count, 0 on failure
+static int load_openings(Match *m, const char *path) {
+    FILE *in = fopen(path, "r");
+    char line[OPENING_LINE];
+    int capacity = 0;
+
+    if (!in) {
+        printf("Could not open %s\n", path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), in)) {
+        Position pos;
+        line[strcspn(line, "\r\n")] = '\0';
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p || *p == '#') continue;
+        if (!position_set_fen(&pos, p)) {
+            printf("Skipping invalid opening: %s\n", p);
+            continue;
+        }
+        if (m->opening_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            m->openings = realloc(m->openings, (size_t)capacity * OPENING_LINE);
+            if (!m->openings) break;
+        }
+        strcpy(m->openings[m->opening_count++], p);
+    }
+    fclose(in);
+    if (!m->opening_count) printf("No openings in %s\n", path);
+    return m->opening_count;
+}
+
+// Function to set up the start of a game pair, recording any moves played from the
+// standard start; both games of a pair get the same opening
+static void setup_opening(MatchWorker *w, int pair, Position *pos, GameRecord *rec) {
+    Match *m = w->match;
+
+    rec->fen[0] = '\0';
+    rec->ply_count = 0;
+    if (m->opening_count) {
+        position_set_fen(pos, m->openings[pair % m->opening_count]);
+        position_get_fen(pos, rec->fen, sizeof(rec->fen));
+        return;
+    }
+
+    // A named line, then random moves until a short search finds the position balanced
+    Position line;
+    char text[OPENING_LINE];
+    char *save = NULL;
+    int line_plies;
+
+    position_set_fen(&line, START_FEN);
+    snprintf(text, sizeof(text), "%s", builtin_openings[pair % builtin_opening_count]);
+    for (char *tok = strtok_r(text, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        Move move = parse_uci_move(&line, tok);
+        if (move == MOVE_NONE) break;
+        rec->moves[rec->ply_count++] = move;
+        make_move(&line, move);
+    }
+    line_plies = rec->ply_count;
+
+    SearchLimits limits = {.depth = OPENING_DEPTH};
+    SearchThread *st = w->engines[0];
+    int plain_order = st->plain_order, pruning_off = st->pruning_off;
+    st->plain_order = 0;
+    st->pruning_off = 0;
+    for (int attempt = 0; attempt < OPENING_ATTEMPTS; attempt++) {
+        uint64_t seed = ((uint64_t)pair + 1) * 0x9E3779B97F4A7C15ULL + (uint64_t)attempt;
+
+        *pos = line;
+        rec->ply_count = line_plies;
+        for (int i = 0; i < RANDOM_PLIES; i++) {
+            MoveList list;
+            generate_legal_moves(pos, &list);
+            if (!list.count) break;
+            seed ^= seed >> 12;
+            seed ^= seed << 25;
+            seed ^= seed >> 27;
+            Move move = list.moves[(seed * 2685821657736338717ULL >> 32) % (uint64_t)list.count];
+            rec->moves[rec->ply_count++] = move;
+            make_move(pos, move);
+        }
+
+        // The same table contents every time keep both games of the pair identical
+        tt_clear(st->tt);
+        if (search_position(st, pos, &limits) != MOVE_NONE && abs(st->best_score) <= OPENING_MAX_SCORE) break;
+    }
+    st->plain_order = plain_order;
+    st->pruning_off = pruning_off;
+}
+
+// Function to end a game with a result in half points for White
+static void finish_game(GameRecord *rec, int result, const char *termination, const char *reason) {
+    rec->result = result;
+    rec->termination = termination;
+    rec->reason = reason;
+}
+
+// Function to play one game of the match; the record's termination stays NULL if
+// the match was stopped before the game ended
+static void play_game(MatchWorker *w, int index, GameRecord *rec) {
+    const MatchSettings *ms = w->match->settings;
+    Position pos;
+    int64_t clock[2];
+    int resign_count[2] = {0, 0}, draw_count = 0;
+
+    rec->round = index + 1;
+    rec->white = index % 2;
+    rec->termination = NULL;
+    setup_opening(w, index / 2, &pos, rec);
+    for (int e = 0; e < 2; e++) {
+        tt_clear(&w->tt[e]);
+        clock[e] = ms->engines[e].base_ms;
+    }
+
+    for (;;) {
+        MoveList list;
+        int white_to_move = pos.side == WHITE;
+
+        if (atomic_load(&w->match->stop)) return;
+        generate_legal_moves(&pos, &list);
+        if (!list.count) {
+            if (in_check(&pos)) finish_game(rec, white_to_move ? 0 : 2, "normal", white_to_move ? "Black mates" : "White mates");
+            else finish_game(rec, 1, "normal", "stalemate");
+            return;
+        }
+        if (pos.halfmove >= 100) return finish_game(rec, 1, "normal", "fifty-move rule");
+        if (repetition_count(&pos) >= 2) return finish_game(rec, 1, "normal", "threefold repetition");
+        if (is_insufficient_material(&pos)) return finish_game(rec, 1, "normal", "insufficient material");
+        if (rec->ply_count >= ms->max_plies) return finish_game(rec, 1, "adjudication", "game too long");
+
+        int e = white_to_move ? rec->white : 1 - rec->white;
+        const EngineConfig *engine = &ms->engines[e];
+        SearchThread *st = w->engines[e];
+        SearchLimits limits = engine->limits;
+
+        if (engine->base_ms) search_allocate_time(&limits, clock[e], engine->inc_ms, 0);
+        int64_t start = now_ms();
+        Move move = search_position(st, &pos, &limits);
+        if (engine->base_ms) {
+            clock[e] -= now_ms() - start;
+            if (clock[e] < 0) {
+                return finish_game(rec, white_to_move ? 0 : 2, "time forfeit",
+                                   white_to_move ? "White loses on time" : "Black loses on time");
+            }
+            clock[e] += engine->inc_ms;
+        }
+
+        // Adjudicate hopeless and dead-drawn games to save time
+        resign_count[e] = st->best_score <= -RESIGN_SCORE ? resign_count[e] + 1 : 0;
+        if (resign_count[e] >= RESIGN_MOVES) {
+            return finish_game(rec, white_to_move ? 0 : 2, "adjudication", white_to_move ? "White resigns" : "Black resigns");
+        }
+        draw_count = abs(st->best_score) <= DRAW_SCORE ? draw_count + 1 : 0;
+        if (rec->ply_count >= DRAW_MIN_PLY && draw_count >= DRAW_PLIES) {
+            return finish_game(rec, 1, "adjudication", "draw agreed");
+        }
+
+        rec->moves[rec->ply_count++] = move;
+        make_move(&pos, move);
+    }
+}
+
+// Function to write one game in PGN, wrapping the move text at 80 columns
+static void write_pgn(FILE *out, const MatchSettings *ms, const GameRecord *rec) {
+    static const char *results[3] = {"0-1", "1/2-1/2", "1-0"};
+    char date[16], san[10], word[24];
+    time_t now = time(NULL);
+    struct tm tm;
+    Position pos;
+    int column = 0;
+
+    localtime_r(&now, &tm);
+    strftime(date, sizeof(date), "%Y.%m.%d", &tm);
+    fprintf(out, "[Event \"Self-play match\"]\n[Site \"?\"]\n[Date \"%s\"]\n[Round \"%d\"]\n", date, rec->round);
+    fprintf(out, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n", ms->engines[rec->white].name,
+            ms->engines[1 - rec->white].name, results[rec->result]);
+    if (rec->fen[0]) fprintf(out, "[SetUp \"1\"]\n[FEN \"%s\"]\n", rec->fen);
+    fprintf(out, "[PlyCount \"%d\"]\n[Termination \"%s\"]\n\n", rec->ply_count, rec->termination);
+
+    position_set_fen(&pos, rec->fen[0] ? rec->fen : START_FEN);
+    for (int i = 0; i < rec->ply_count; i++) {
+        move_to_san(&pos, rec->moves[i], san);
+        if (pos.side == WHITE) snprintf(word, sizeof(word), "%d. %s", pos.fullmove, san);
+        else if (i == 0) snprintf(word, sizeof(word), "%d... %s", pos.fullmove, san);
+        else snprintf(word, sizeof(word), "%s", san);
+        make_move(&pos, rec->moves[i]);
+
+        int len = (int)strlen(word);
+        if (column && column + 1 + len > 80) {
+            fputc('\n', out);
+            column = 0;
+        }
+        fprintf(out, "%s%s", column ? " " : "", word);
+        column += (column ? 1 : 0) + len;
+    }
+    fprintf(out, "%s{%s} %s\n\n", column ? " " : "", rec->reason, results[rec->result]);
+}
+
+// Function to append one game to the binary game records
+static void write_record(RecordWriter *out, const GameRecord *rec) {
+    Position start;
+    position_set_fen(&start, rec->fen[0] ? rec->fen : START_FEN);
+    record_write_game(out, &start, rec->moves, rec->ply_count, rec->result);
+}
+
+// Function to convert an expected score into an Elo difference
+static double score_to_elo(double score) {
+    if (score <= 0.0) score = 1e-6;
+    if (score >= 1.0) score = 1.0 - 1e-6;
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Function to get the expected score of an Elo difference
+static double elo_to_score(double elo) {
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Function to compute the score, its per-game variance and the log-likelihood ratio of
+// the SPRT (normal approximation of the trinomial win/draw/loss distribution)
+static double sprt_llr(const Match *m, double *score, double *variance) {
+    const MatchSettings *ms = m->settings;
+    double n = m->wins + m->draws + m->losses;
+
+    *score = 0.5;
+    *variance = 0.0;
+    if (n == 0) return 0.0;
+    double s = (m->wins + 0.5 * m->draws) / n;
+    double var = (m->wins * (1 - s) * (1 - s) + m->draws * (0.5 - s) * (0.5 - s) + m->losses * s * s) / n;
+    *score = s;
+    *variance = var;
+    if (var <= 0.0) return 0.0;
+
+    double s0 = elo_to_score(ms->elo0), s1 = elo_to_score(ms->elo1);
+    return n * (s1 - s0) * (2 * s - s0 - s1) / (2 * var);
+}
+
+// Function to check the SPRT and optionally print the running result: W/L/D, Elo with
+// its 95% interval and the LLR; returns -1 if H0 is accepted, 1 if H1 is, 0 while undecided
+static int report(const Match *m, int print) {
+    const MatchSettings *ms = m->settings;
+    double score, variance;
+    double llr = sprt_llr(m, &score, &variance);
+    double lower = log(ms->beta / (1 - ms->alpha)), upper = log((1 - ms->beta) / ms->alpha);
+    int n = m->wins + m->draws + m->losses;
+    double margin = n ? 1.96 * sqrt(variance / n) : 0.0;
+
+    if (print) {
+        printf("Games %d: +%d -%d =%d, score %.1f%%, Elo %.1f +/- %.1f, LLR %.2f [%.2f, %.2f]\n", n, m->wins,
+               m->losses, m->draws, 100.0 * score, score_to_elo(score),
+               (score_to_elo(score + margin) - score_to_elo(score - margin)) / 2, llr, lower, upper);
+        fflush(stdout);
+    }
+    return llr >= upper ? 1 : llr <= lower ? -1 : 0;
+}
+
+// Function to run one worker: claim the next game, play it, record the result
+static void *worker_main(void *arg) {
+    MatchWorker *w = arg;
+    Match *m = w->match;
+    const MatchSettings *ms = m->settings;
+
+    for (;;) {
+        pthread_mutex_lock(&m->lock);
+        int index = m->next_game < ms->games && !atomic_load(&m->stop) ? m->next_game++ : -1;
+        pthread_mutex_unlock(&m->lock);
+        if (index < 0) break;
+
+        play_game(w, index, &w->record);
+        if (!w->record.termination) break;
+
+        // Games stopped by the SPRT are dropped rather than counted half-played
+        pthread_mutex_lock(&m->lock);
+        int points = w->record.white == 0 ? w->record.result : 2 - w->record.result;
+        m->wins += points == 2;
+        m->draws += points == 1;
+        m->losses += points == 0;
+        m->finished++;
+        if (m->pgn) write_pgn(m->pgn, ms, &w->record);
+        if (m->write_records) write_record(&m->records, &w->record);
+        if (report(m, m->finished % REPORT_EVERY == 0 && m->finished < ms->games)) atomic_store(&m->stop, 1);
+        pthread_mutex_unlock(&m->lock);
+    }
+    return NULL;
+}
+
+// Function to play a self-play match on a pool of worker threads, writing PGN and
+// reporting Elo and the SPRT as games finish; returns the process exit code
+int run_match(const MatchSettings *settings) {
+    Match m;
+    MatchWorker *workers;
+    int count = settings->concurrency > 0 ? settings->concurrency : 1;
+
+    memset(&m, 0, sizeof(m));
+    m.settings = settings;
+    if (settings->openings_path && !load_openings(&m, settings->openings_path)) return 1;
+    if (settings->pgn_path && !(m.pgn = fopen(settings->pgn_path, "w"))) {
+        printf("Could not open %s\n", settings->pgn_path);
+        return 1;
+    }
+    if (settings->records_path) {
+        if (!record_writer_open(&m.records, settings->records_path, RECORD_GAMES)) return 1;
+        m.write_records = 1;
+    }
+    workers = calloc((size_t)count, sizeof(MatchWorker));
+    if (!workers) return 1;
+    pthread_mutex_init(&m.lock, NULL);
+
+    printf("%s vs %s: up to %d games, %d at a time, %s openings\n", settings->engines[0].name,
+           settings->engines[1].name, settings->games, count, m.opening_count ? "file" : "built-in");
+    printf("SPRT elo0 %.1f elo1 %.1f alpha %.2f beta %.2f\n", settings->elo0, settings->elo1, settings->alpha,
+           settings->beta);
+
+    m.start_time = now_ms();
+    for (int i = 0; i < count; i++) {
+        workers[i].match = &m;
+        for (int e = 0; e < 2; e++) {
+            workers[i].engines[e] = calloc(1, sizeof(SearchThread));
+            if (!workers[i].engines[e] || !tt_init(&workers[i].tt[e], settings->engines[e].hash_mb)) return 1;
+            workers[i].engines[e]->tt = &workers[i].tt[e];
+            workers[i].engines[e]->plain_order = settings->engines[e].plain_order;
+            workers[i].engines[e]->classical_eval = settings->engines[e].classical_eval;
+            workers[i].engines[e]->pruning_off = settings->engines[e].pruning_off;
+        }
+        pthread_create(&workers[i].handle, NULL, worker_main, &workers[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(workers[i].handle, NULL);
+        for (int e = 0; e < 2; e++) {
+            tt_free(&workers[i].tt[e]);
+            free(workers[i].engines[e]);
+        }
+    }
+    double hours = (now_ms() - m.start_time) / 3600000.0;
+
+    int decision = report(&m, 1);
+    if (decision > 0) printf("SPRT: H1 accepted, %s is stronger\n", settings->engines[0].name);
+    else if (decision < 0) printf("SPRT: H0 accepted, %s is not stronger\n", settings->engines[0].name);
+    else printf("SPRT: undecided after %d games\n", m.finished);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int cores = cpus > 0 && cpus < count ? (int)cpus : count;
+    printf("Time: %.1f s, %.0f games/hour, %.0f games/hour per core\n", hours * 3600,
+           hours > 0 ? m.finished / hours : 0.0, hours > 0 ? m.finished / hours / cores : 0.0);
+
+    if (m.pgn) fclose(m.pgn);
+    if (m.write_records && !record_writer_close(&m.records)) printf("Could not write %s\n", settings->records_path);
+    free(m.openings);
+    free(workers);
+    pthread_mutex_destroy(&m.lock);
+    return 0;
+}
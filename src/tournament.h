@@ -0,0 +1,44 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <stddef.h>
+#include "search.h"
+
+// Per-move node budget for engines given no other limit
+#define MATCH_DEFAULT_NODES 20000
+
+// One side of a self-play match: the search settings it plays with
+typedef struct {
+    char name[32];
+    SearchLimits limits;      // per-move budget (depth, nodes or movetime) when there is no clock
+    int64_t base_ms;          // clock per game; 0 plays by limits alone
+    int64_t inc_ms;
+    size_t hash_mb;
+    int plain_order;
+    int classical_eval;       // ignore a loaded network
+    int pruning_off;          // PRUNE_* techniques switched off
+} EngineConfig;
+
+// Everything a match needs; engines[0] is the candidate the statistics are reported for
+typedef struct {
+    EngineConfig engines[2];
+    int games;                // upper bound; the SPRT usually stops the run earlier
+    int concurrency;          // games played at the same time, one per worker thread
+    int max_plies;            // longer games are adjudicated drawn
+    const char *openings_path;  // FEN/EPD lines; NULL uses the built-in suite
+    const char *pgn_path;     // NULL writes no PGN
+    const char *records_path; // binary game records; NULL writes none
+    double elo0, elo1;        // SPRT hypotheses H0: elo = elo0, H1: elo = elo1
+    double alpha, beta;       // SPRT error rates
+} MatchSettings;
+
+// Function to apply "key=value,key=value" settings (name, nodes, depth, movetime, tc,
+// hash, order, eval, and nullmove, lmr, futility, aspiration, pvs set to on or off) on top of
+// an engine's defaults; returns 0 on an unknown or bad key
+int parse_engine_config(EngineConfig *engine, const char *text);
+
+// Function to play a self-play match on a pool of worker threads, writing PGN and
+// reporting Elo and the SPRT as games finish; returns the process exit code
+int run_match(const MatchSettings *settings);
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "tt.h"
+
+// Data word layout: move (16) | score (16) | eval (16) | depth (8) | bound (2) | generation (6)
+#define DATA_MOVE(d) ((Move)((d) & 0xFFFF))
+#define DATA_SCORE(d) ((int)(int16_t)(((d) >> 16) & 0xFFFF))
+#define DATA_EVAL(d) ((int)(int16_t)(((d) >> 32) & 0xFFFF))
+#define DATA_DEPTH(d) ((int)(int8_t)(((d) >> 48) & 0xFF))
+#define DATA_BOUND(d) ((int)(((d) >> 56) & 0x3))
+#define DATA_GENERATION(d) ((uint8_t)(((d) >> 58) & 0x3F))
+
+// Function to map a key onto a bucket without requiring a power-of-two table
+static inline TTBucket *bucket_for(const TranspositionTable *tt, uint64_t key) {
+    return &tt->buckets[(uint64_t)(((unsigned __int128)key * tt->bucket_count) >> 64)];
+}
+
+// Function to allocate the table with a memory budget in MB; returns 1 on success
+int tt_init(TranspositionTable *tt, size_t mb) {
+    size_t bytes;
+
+    tt_free(tt);
+    if (mb == 0) mb = 1;
+    tt->bucket_count = (uint64_t)(mb * 1024 * 1024 / sizeof(TTBucket));
+    bytes = (size_t)tt->bucket_count * sizeof(TTBucket);
+    tt->buckets = aligned_alloc(64, bytes);
+    if (!tt->buckets) {
+        printf("Could not allocate %zu MB for the transposition table\n", mb);
+        tt->bucket_count = 0;
+        return 0;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(tt->buckets, bytes, MADV_HUGEPAGE);
+#endif
+    tt_clear(tt);
+    return 1;
+}
+
+// Function to release the table memory
+void tt_free(TranspositionTable *tt) {
+    free(tt->buckets);
+    tt->buckets = NULL;
+    tt->bucket_count = 0;
+}
+
+// Function to wipe every entry
+void tt_clear(TranspositionTable *tt) {
+    memset(tt->buckets, 0, (size_t)tt->bucket_count * sizeof(TTBucket));
+    tt->generation = 0;
+}
+
+// Function to start a new search generation so older entries age out first
+void tt_new_search(TranspositionTable *tt) {
+    tt->generation = (uint8_t)((tt->generation + 1) & 0x3F);
+}
+
+// Function to look up a key; returns 1 and fills out on a verified hit
+int tt_probe(const TranspositionTable *tt, uint64_t key, TTData *out) {
+    TTBucket *bucket = bucket_for(tt, key);
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        uint64_t data = atomic_load_explicit(&bucket->entries[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket->entries[i].check, memory_order_relaxed);
+        if ((check ^ data) == key && DATA_BOUND(data) != BOUND_NONE) {
+            out->move = DATA_MOVE(data);
+            out->score = DATA_SCORE(data);
+            out->eval = DATA_EVAL(data);
+            out->depth = DATA_DEPTH(data);
+            out->bound = DATA_BOUND(data);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to store a search result, preferring to keep deep and recent entries
+void tt_store(TranspositionTable *tt, uint64_t key, Move move, int score, int eval, int depth, int bound) {
+    TTBucket *bucket = bucket_for(tt, key);
+    TTEntry *victim = &bucket->entries[0];
+    int victim_worth = 1 << 30;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        TTEntry *e = &bucket->entries[i];
+        uint64_t data = atomic_load_explicit(&e->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&e->check, memory_order_relaxed);
+
+        if ((check ^ data) == key) {
+            // Same position: keep a deeper result unless the new one is exact
+            if (bound != BOUND_EXACT && depth < DATA_DEPTH(data) - 2
+                && DATA_GENERATION(data) == tt->generation) return;
+            if (move == MOVE_NONE) move = DATA_MOVE(data);
+            victim = e;
+            break;
+        }
+
+        // Otherwise replace the shallowest entry, counting each generation of age as 8 plies
+        int age = (tt->generation - DATA_GENERATION(data)) & 0x3F;
+        int worth = DATA_BOUND(data) == BOUND_NONE ? -(1 << 30) : DATA_DEPTH(data) - 8 * age;
+        if (worth < victim_worth) {
+            victim_worth = worth;
+            victim = e;
+        }
+    }
+
+    uint64_t data = (uint64_t)move
+                  | ((uint64_t)(uint16_t)score << 16)
+                  | ((uint64_t)(uint16_t)eval << 32)
+                  | ((uint64_t)(uint8_t)depth << 48)
+                  | ((uint64_t)bound << 56)
+                  | ((uint64_t)tt->generation << 58);
+    atomic_store_explicit(&victim->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&victim->data, data, memory_order_relaxed);
+}
+
+// Function to estimate how full the table is for this generation, in permille
+int tt_hashfull(const TranspositionTable *tt) {
+    uint64_t sample = tt->bucket_count < 250 ? tt->bucket_count : 250;
+    int used = 0;
+
+    for (uint64_t b = 0; b < sample; b++) {
+        for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+            uint64_t data = atomic_load_explicit(&tt->buckets[b].entries[i].data, memory_order_relaxed);
+            if (DATA_BOUND(data) != BOUND_NONE && DATA_GENERATION(data) == tt->generation) used++;
+        }
+    }
+    return sample ? (int)(used * 1000 / (sample * TT_BUCKET_ENTRIES)) : 0;
+}
@@ -0,0 +1,70 @@
+#ifndef TT_H
+#define TT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "types.h"
+
+#define BOUND_NONE 0
+#define BOUND_UPPER 1
+#define BOUND_LOWER 2
+#define BOUND_EXACT 3
+
+#define TT_BUCKET_ENTRIES 4
+#define TT_DEFAULT_MB 16
+
+// One slot: the key is stored XORed with the data, so a torn write from
+// another thread fails verification instead of returning mixed data
+typedef struct {
+    _Atomic uint64_t check;   // key ^ data
+    _Atomic uint64_t data;
+} TTEntry;
+
+// Four entries fill exactly one 64-byte cache line
+typedef struct {
+    TTEntry entries[TT_BUCKET_ENTRIES];
+} __attribute__((aligned(64))) TTBucket;
+
+typedef struct {
+    TTBucket *buckets;
+    uint64_t bucket_count;
+    uint8_t generation;
+} TranspositionTable;
+
+// Unpacked contents of an entry
+typedef struct {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    int bound;
+} TTData;
+
+// Function to allocate the table with a memory budget in MB; returns 1 on success
+int tt_init(TranspositionTable *tt, size_t mb);
+
+// Function to release the table memory
+void tt_free(TranspositionTable *tt);
+
+// Function to wipe every entry
+void tt_clear(TranspositionTable *tt);
+
+// Function to start a new search generation so older entries age out first
+void tt_new_search(TranspositionTable *tt);
+
+// Function to look up a key; returns 1 and fills out on a verified hit
+int tt_probe(const TranspositionTable *tt, uint64_t key, TTData *out);
+
+// Function to store a search result, preferring to keep deep and recent entries
+void tt_store(TranspositionTable *tt, uint64_t key, Move move, int score, int eval, int depth, int bound);
+
+// Function to estimate how full the table is for this generation, in permille
+int tt_hashfull(const TranspositionTable *tt);
+
+// Function to hint the CPU to start loading the bucket for a key
+static inline void tt_prefetch(const TranspositionTable *tt, uint64_t key) {
+    __builtin_prefetch(&tt->buckets[(uint64_t)(((unsigned __int128)key * tt->bucket_count) >> 64)]);
+}
+
+#endif
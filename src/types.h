@@ -0,0 +1,63 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <stdint.h>
+
+#define EMPTY 0
+#define PAWN 1
+#define KNIGHT 2
+#define BISHOP 3
+#define ROOK 4
+#define QUEEN 5
+#define KING 6
+
+#define WHITE 8
+#define BLACK 16
+
+#define WHITE_PAWN (WHITE | PAWN)
+#define WHITE_KNIGHT (WHITE | KNIGHT)
+#define WHITE_BISHOP (WHITE | BISHOP)
+#define WHITE_ROOK (WHITE | ROOK)
+#define WHITE_QUEEN (WHITE | QUEEN)
+#define WHITE_KING (WHITE | KING)
+
+#define BLACK_PAWN (BLACK | PAWN)
+#define BLACK_KNIGHT (BLACK | KNIGHT)
+#define BLACK_BISHOP (BLACK | BISHOP)
+#define BLACK_ROOK (BLACK | ROOK)
+#define BLACK_QUEEN (BLACK | QUEEN)
+#define BLACK_KING (BLACK | KING)
+
+// Piece helpers: the low three bits are the type, bits 3/4 the color
+#define PIECE_TYPE(p) ((p) & 0x7)
+#define PIECE_COLOR(p) ((p) & (WHITE | BLACK))
+#define OPPONENT(color) ((color) ^ (WHITE | BLACK))
+#define COLOR_INDEX(color) ((color) >> 4)   // WHITE -> 0, BLACK -> 1
+
+// Squares are numbered like the board[8][8] array: sq = row * 8 + col,
+// so square 0 is a8 and square 63 is h1
+#define SQ_NONE (-1)
+#define SQUARE(r, c) ((r) * 8 + (c))
+#define SQ_ROW(sq) ((sq) >> 3)
+#define SQ_COL(sq) ((sq) & 7)
+
+typedef uint64_t Bitboard;
+
+// Moves are packed into 16 bits: from (bits 0-5), to (bits 6-11),
+// special kind (bits 12-13) and promotion piece minus KNIGHT (bits 14-15)
+typedef uint16_t Move;
+
+#define MOVE_NONE 0
+#define MOVE_NORMAL 0
+#define MOVE_PROMOTION 1
+#define MOVE_EN_PASSANT 2
+#define MOVE_CASTLING 3
+
+#define MAKE_MOVE(from, to, kind) ((Move)((from) | ((to) << 6) | ((kind) << 12)))
+#define MAKE_PROMOTION(from, to, type) ((Move)((from) | ((to) << 6) | (MOVE_PROMOTION << 12) | (((type) - KNIGHT) << 14)))
+#define MOVE_FROM(m) ((m) & 0x3F)
+#define MOVE_TO(m) (((m) >> 6) & 0x3F)
+#define MOVE_KIND(m) (((m) >> 12) & 0x3)
+#define MOVE_PROMO(m) ((((m) >> 14) & 0x3) + KNIGHT)
+
+#endif
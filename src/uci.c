@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include "uci.h"
+#include "position.h"
+#include "movegen.h"
+#include "search.h"
+#include "smp.h"
+#include "tt.h"
+
+// State of one UCI session; the search runs on its own thread while the
+// main thread keeps reading commands, so "stop" is seen immediately
+typedef struct {
+    Position pos;
+    TranspositionTable tt;
+    SearchPool pool;
+    size_t hash_mb;
+    int threads;
+
+    pthread_t search_thread;
+    int searching;
+    SearchLimits limits;
+    FILE *stats_json;
+} UciState;
+
+// Function to print one protocol line and push it to the GUI right away
+static void uci_send(const char *line) {
+    fputs(line, stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+// Function to run one search and report its result; the body of the search thread
+static void *search_main(void *arg) {
+    UciState *uci = arg;
+    char line[32], text[6];
+
+    Move best = pool_search(&uci->pool, &uci->pos, &uci->limits);
+    if (best == MOVE_NONE) {
+        uci_send("bestmove 0000");
+        return NULL;
+    }
+
+    SearchThread *st = uci->pool.best;
+    move_to_uci(best, text);
+    int n = snprintf(line, sizeof(line), "bestmove %s", text);
+    if (st->pv_length[0] > 1 && st->pv[0][0] == best) {
+        move_to_uci(st->pv[0][1], text);
+        snprintf(line + n, sizeof(line) - n, " ponder %s", text);
+    }
+    uci_send(line);
+
+    // Counters go out after bestmove so they never delay the reply
+    if (uci->stats_json) {
+        SearchStats stats;
+        search_total_stats(&uci->pool.threads[0], &stats);
+        stats_write_json(uci->stats_json, "search", &stats, search_elapsed(&uci->pool.threads[0]), &uci->pool.threads[0]);
+    }
+    return NULL;
+}
+
+// Function to stop a running search and wait until its bestmove has been sent
+static void stop_search(UciState *uci) {
+    if (!uci->searching) return;
+    pool_stop(&uci->pool);
+    pthread_join(uci->search_thread, NULL);
+    uci->searching = 0;
+}
+
+// Function to handle "position [startpos | fen <fen>] [moves <m1> <m2> ...]"
+static void cmd_position(UciState *uci, char *args) {
+    char *moves = strstr(args, "moves");
+    if (moves) {
+        *moves = '\0';
+        moves += 5;
+    }
+
+    if (strncmp(args, "startpos", 8) == 0) {
+        position_set_fen(&uci->pos, START_FEN);
+    } else if (strncmp(args, "fen", 3) == 0) {
+        if (!position_set_fen(&uci->pos, args + 3)) {
+            printf("info string invalid fen\n");
+            fflush(stdout);
+            position_set_fen(&uci->pos, START_FEN);
+            return;
+        }
+    } else {
+        return;
+    }
+    if (!moves) return;
+
+    char *save = NULL;
+    for (char *tok = strtok_r(moves, " \t", &save); tok; tok = strtok_r(NULL, " \t", &save)) {
+        Move move = parse_uci_move(&uci->pos, tok);
+        if (move == MOVE_NONE) {
+            printf("info string illegal move %s\n", tok);
+            fflush(stdout);
+            return;
+        }
+        make_move(&uci->pos, move);
+
+        // Keep room for the search by dropping history no repetition can reach
+        if (uci->pos.game_ply >= MAX_GAME_PLY - MAX_PLY - 1) position_compact_history(&uci->pos);
+    }
+}
+
+// Function to handle "go" and start the search thread
+static void cmd_go(UciState *uci, char *args) {
+    SearchLimits limits = {0};
+    int64_t wtime = -1, btime = -1, winc = 0, binc = 0;
+    int moves_to_go = 0, ponder = 0, infinite = 0;
+    char *save = NULL;
+
+    for (char *tok = strtok_r(args, " \t", &save); tok; tok = strtok_r(NULL, " \t", &save)) {
+        char *value = NULL;
+        if (strcmp(tok, "ponder") == 0) ponder = 1;
+        else if (strcmp(tok, "infinite") == 0) infinite = 1;
+        else if ((value = strtok_r(NULL, " \t", &save)) == NULL) break;
+        else if (strcmp(tok, "wtime") == 0) wtime = atoll(value);
+        else if (strcmp(tok, "btime") == 0) btime = atoll(value);
+        else if (strcmp(tok, "winc") == 0) winc = atoll(value);
+        else if (strcmp(tok, "binc") == 0) binc = atoll(value);
+        else if (strcmp(tok, "movestogo") == 0) moves_to_go = atoi(value);
+        else if (strcmp(tok, "movetime") == 0) limits.movetime = atoll(value);
+        else if (strcmp(tok, "depth") == 0) limits.depth = atoi(value);
+        else if (strcmp(tok, "nodes") == 0) limits.nodes = (uint64_t)atoll(value);
+    }
+
+    int64_t time = uci->pos.side == WHITE ? wtime : btime;
+    int64_t inc = uci->pos.side == WHITE ? winc : binc;
+    if (!infinite && !limits.movetime && time >= 0) search_allocate_time(&limits, time, inc, moves_to_go);
+
+    // Node budgets are per thread in the search, so split the requested total
+    if (limits.nodes) limits.nodes = (limits.nodes + uci->pool.count - 1) / uci->pool.count;
+
+    uci->limits = limits;
+    atomic_store(&uci->pool.signals.pondering, ponder || infinite);
+    if (pthread_create(&uci->search_thread, NULL, search_main, uci) != 0) {
+        uci_send("info string could not start the search thread");
+        return;
+    }
+    uci->searching = 1;
+}
+
+// Function to (re)create the table and the pool after an option changed; returns 1 on success
+static int setup_engine(UciState *uci) {
+    tt_free(&uci->tt);
+    pool_free(&uci->pool);
+    if (!tt_init(&uci->tt, uci->hash_mb) || !pool_init(&uci->pool, uci->threads, &uci->tt)) return 0;
+    uci->pool.threads[0].print_info = 1;
+    return 1;
+}
+
+// Function to handle "setoption name <name> [value <value>]"
+static void cmd_setoption(UciState *uci, char *args) {
+    char *name = strstr(args, "name");
+    if (!name) return;
+    name += 4;
+    while (*name == ' ') name++;
+
+    char *value = strstr(name, " value");
+    if (value) {
+        *value = '\0';
+        value += 6;
+        while (*value == ' ') value++;
+    }
+
+    if (strcasecmp(name, "Hash") == 0 && value) {
+        int mb = atoi(value);
+        uci->hash_mb = mb < 1 ? 1 : (size_t)mb;
+        if (!setup_engine(uci)) uci_send("info string could not allocate the hash table");
+    } else if (strcasecmp(name, "Threads") == 0 && value) {
+        uci->threads = atoi(value);
+        if (!setup_engine(uci)) uci_send("info string could not allocate the search threads");
+    } else if (strcasecmp(name, "Clear Hash") == 0) {
+        tt_clear(&uci->tt);
+    } else if (strcasecmp(name, "EvalFile") == 0 && value) {
+        if (!nnue_load(value)) uci_send("info string could not load the network, keeping the current evaluation");
+    } else if (strcasecmp(name, "Ponder") == 0) {
+        // Pondering only needs "go ponder" and "ponderhit", which are always available
+    } else {
+        printf("info string unknown option %s\n", name);
+        fflush(stdout);
+    }
+}
+
+// Function to answer "uci" with the engine's identity and options
+static void cmd_uci(const UciState *uci) {
+    printf("id name %s\n", ENGINE_NAME);
+    printf("id author %s\n", ENGINE_AUTHOR);
+    printf("option name Hash type spin default %zu min 1 max 65536\n", uci->hash_mb);
+    printf("option name Threads type spin default %d min 1 max %d\n", uci->threads, MAX_THREADS);
+    printf("option name Ponder type check default false\n");
+    printf("option name Clear Hash type button\n");
+    printf("option name EvalFile type string default <empty>\n");
+    printf("uciok\n");
+    fflush(stdout);
+}
+
+// Function to speak the UCI protocol on stdin/stdout until "quit" or end of input,
+// appending the counters of every search to stats_json if given; returns the exit code
+int run_uci(size_t hash_mb, int threads, FILE *stats_json) {
+    static UciState uci;
+    char line[16384];
+
+    uci.stats_json = stats_json;
+    uci.hash_mb = hash_mb;
+    uci.threads = threads;
+    if (!tt_init(&uci.tt, hash_mb) || !pool_init(&uci.pool, threads, &uci.tt)) return 1;
+    uci.pool.threads[0].print_info = 1;
+    position_set_fen(&uci.pos, START_FEN);
+
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *cmd = line + strspn(line, " \t");
+        char *args = cmd + strcspn(cmd, " \t");
+        if (*args) *args++ = '\0';
+        args += strspn(args, " \t");
+
+        if (strcmp(cmd, "uci") == 0) {
+            cmd_uci(&uci);
+        } else if (strcmp(cmd, "isready") == 0) {
+            uci_send("readyok");
+        } else if (strcmp(cmd, "stop") == 0) {
+            stop_search(&uci);
+        } else if (strcmp(cmd, "ponderhit") == 0) {
+            if (uci.searching) pool_ponderhit(&uci.pool);
+        } else if (strcmp(cmd, "quit") == 0) {
+            break;
+        } else if (strcmp(cmd, "ucinewgame") == 0) {
+            stop_search(&uci);
+            tt_clear(&uci.tt);
+        } else if (strcmp(cmd, "position") == 0) {
+            stop_search(&uci);
+            cmd_position(&uci, args);
+        } else if (strcmp(cmd, "go") == 0) {
+            // A finished search still has to be joined before the next one starts
+            stop_search(&uci);
+            cmd_go(&uci, args);
+        } else if (strcmp(cmd, "setoption") == 0) {
+            stop_search(&uci);
+            cmd_setoption(&uci, args);
+        } else if (*cmd) {
+            printf("info string unknown command %s\n", cmd);
+            fflush(stdout);
+        }
+    }
+
+    stop_search(&uci);
+    pool_free(&uci.pool);
+    tt_free(&uci.tt);
+    return 0;
+}
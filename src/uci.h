@@ -0,0 +1,14 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define ENGINE_NAME "Chess"
+#define ENGINE_AUTHOR "the Chess authors"
+
+// Function to speak the UCI protocol on stdin/stdout until "quit" or end of input,
+// appending the counters of every search to stats_json if given; returns the exit code
+int run_uci(size_t hash_mb, int threads, FILE *stats_json);
+
+#endif